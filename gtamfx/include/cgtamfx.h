@@ -2,6 +2,7 @@
 #define GTAMFX_CWRAP_HEADER_
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef _WIN32
 #define EXPORT __dllspec(dllexport)
@@ -41,36 +42,236 @@ struct GtamVec4d {
   double x, y, z, w;
 };
 struct GtamQuat {
-  double x, y, z, w;
+  float x, y, z, w;
 };
 
 typedef struct GtamWindow_T GtamWindow;
 
+/* Objects are referred to by generational handles. A handle whose object was
+ * deleted is stale: the getters return NULL for it and deleting it again does
+ * nothing. The pointers returned by the getters are only valid until the next
+ * new/del call of the same kind of object. */
+typedef struct GtamTextureHandle {
+  uint32_t index, generation;
+} GtamTextureHandle;
+typedef struct GtamShaderHandle {
+  uint32_t index, generation;
+} GtamShaderHandle;
+typedef struct GtamSpriteHandle {
+  uint32_t index, generation;
+} GtamSpriteHandle;
+typedef struct GtamCameraHandle {
+  uint32_t index, generation;
+} GtamCameraHandle;
+typedef struct GtamSpriteBatchHandle {
+  uint32_t index, generation;
+} GtamSpriteBatchHandle;
+typedef struct GtamTilemapHandle {
+  uint32_t index, generation;
+} GtamTilemapHandle;
+typedef struct GtamFontHandle {
+  uint32_t index, generation;
+} GtamFontHandle;
+typedef struct GtamTextHandle {
+  uint32_t index, generation;
+} GtamTextHandle;
+typedef struct GtamParticleEmitterHandle {
+  uint32_t index, generation;
+} GtamParticleEmitterHandle;
+typedef struct GtamPackHandle {
+  uint32_t index, generation;
+} GtamPackHandle;
+
+#define GTAM_TEXTURE_STATE_RESIDENT 0
+#define GTAM_TEXTURE_STATE_LOADING 1
+#define GTAM_TEXTURE_STATE_FAILED 2
+/* freed to stay within the texture budget, loaded again when drawn */
+#define GTAM_TEXTURE_STATE_EVICTED 3
+
 typedef struct GtamTexture_T {
   unsigned int id;
   struct GtamVec2 size;
+  struct {
+    struct GtamVec2 position, scale;
+  } region;
+  int state;
 } GtamTexture;
 
+/* called from gtamUpdateWindow once an async texture is resident (loaded = 1)
+ * or failed to load (loaded = 0) */
+typedef void (*GtamTextureCallback)(GtamTextureHandle texture, int loaded,
+                                    void *user);
+
+struct GtamAtlasOptions {
+  int enabled;
+  int pageSize;
+  int maxImageSize;
+  int padding;
+};
+
+struct GtamAtlasStats {
+  size_t pageCount;
+  size_t imageCount;
+  size_t usedPixels;
+  size_t totalPixels;
+};
+
+/* textures with a gl texture of their own, all but atlas images */
+struct GtamTextureResidencyStats {
+  size_t budget; /* 0 for none */
+  size_t residentBytes; /* mip levels included */
+  size_t residentCount;
+  size_t evictedCount;
+  size_t evictions;
+  size_t reloads;
+};
+
+struct GtamProgramCacheStats {
+  size_t hits;
+  size_t misses; /* rejected binaries included */
+  size_t rejected;
+  size_t stored;
+};
+
+/* totals since gtamInitWindow, fenceWaitTime in milliseconds */
+struct GtamStreamStats {
+  int persistent;
+  size_t capacity;
+  size_t bytesStreamed;
+  size_t allocations;
+  size_t reallocations;
+  size_t fenceWaits;
+  double fenceWaitTime;
+};
+
+/* milliseconds, gpuTime is -1 until it has been read back (a few frames
+ * late) */
+struct GtamFrameStats {
+  uint64_t frame;
+  struct {
+    double poll, upload, sort, cull, transform, submit, swap, total;
+  } cpuTime;
+  double gpuTime;
+  size_t drawCalls;
+  size_t programBinds;
+  size_t textureBinds;
+  size_t uniformUploads;
+  size_t spritesDrawn;
+  size_t spritesCulled;
+  size_t stateChangesFiltered;
+  size_t tileChunksDrawn;
+  size_t textsDrawn;
+  size_t particlesSimulated;
+};
+
 typedef struct GtamShader_T {
   unsigned int id;
   size_t vertexCount;
   bool line;
+  bool instanced;
+  bool cameraBlock; /* uses the GtamCamera uniform block */
 } GtamShader;
 
+/* names are valid until the shader is deleted */
+struct GtamShaderUniform {
+  const char *name;
+  unsigned int type; /* GL_FLOAT_VEC4, GL_SAMPLER_2D, ... */
+  int size;          /* array elements */
+  int location;      /* -1 for members of uniform blocks */
+  int block;         /* index of the uniform block, or -1 */
+};
+
+struct GtamShaderUniformBlock {
+  const char *name;
+  int size; /* bytes */
+  unsigned int binding;
+};
+
 struct GtamTextureView {
   struct GtamVec2 position, scale;
-  GtamTexture *source;
+  GtamTextureHandle source;
 };
 
 typedef struct GtamSprite_T {
   struct GtamTextureView texture;
-  GtamShader *shader;
+  GtamShaderHandle shader;
   struct GtamVec4 color;
   struct GtamVec3 position;
   struct GtamVec3 scale;
   struct GtamQuat rotation;
 } GtamSprite;
 
+/* arrays of a sprite batch, `count` elements each, element i belonging to
+ * sprites[i]. Written into the sprites by gtamUpdateWindow, valid until the
+ * batch is resized or deleted. */
+struct GtamSpriteBatch {
+  size_t count;
+  const GtamSpriteHandle *sprites;
+  struct GtamVec3 *positions;
+  struct GtamVec3 *scales;
+  struct GtamQuat *rotations;
+  struct GtamVec4 *colors;
+  struct GtamVec4 *textureViews; /* position in xy, scale in zw */
+};
+
+/* Tile (x, y) covers position.xy + (x, y) * tileSize to position.xy + (x + 1,
+ * y + 1) * tileSize. Tiles are 0 for none or n for the n-th cell of the
+ * texture, counted from 1 row by row from its top left. Layers are drawn at
+ * position.z plus their depth, in order with the sprites. */
+typedef struct GtamTilemap_T {
+  GtamTextureHandle texture;
+  GtamShaderHandle shader;
+  struct GtamVec2i size; /* tiles, fixed */
+  struct GtamVec2i atlasSize;
+  struct GtamVec3 position;
+  struct GtamVec2 tileSize;
+} GtamTilemap;
+
+/* an asset pack file mapped into memory, see gtampack */
+typedef struct GtamPack_T {
+  size_t textureCount;
+  size_t shaderCount;
+  size_t bytes;
+} GtamPack;
+
+/* in units of the text size, the distance from ascent to descent */
+typedef struct GtamFont_T {
+  float ascent;
+  float descent; /* negative */
+  float lineHeight;
+  int glyphSize; /* pixels from ascent to descent in the distance fields */
+} GtamFont;
+
+/* position is the left end of the first line's baseline, size the world
+ * units from ascent to descent. Shaders get aGlyphPosition, aGlyphUv,
+ * uTransform, uColor and the distance field atlas in uTexture, whose red
+ * channel is 0.5 on the outlines. */
+typedef struct GtamText_T {
+  GtamFontHandle font;
+  GtamShaderHandle shader;
+  struct GtamVec3 position;
+  struct GtamQuat rotation;
+  float size;
+  struct GtamVec4 color;
+} GtamText;
+
+/* Particles live and are simulated on the gpu, each update spawns rate *
+ * delta of them into a ring over the capacity (dropped where a particle is
+ * still alive). Shaders draw each particle as an instance with
+ * aParticlePosition, aParticleColor and aParticleSize, and get uTransform
+ * (world to clip), uTexture and uTextureView. Drawn by position.z. */
+typedef struct GtamParticleEmitter_T {
+  GtamTextureHandle texture;
+  GtamShaderHandle shader;
+  struct GtamVec3 position, positionSpread;
+  struct GtamVec3 velocity, velocitySpread;
+  struct GtamVec3 acceleration;
+  float rate; /* per second */
+  float lifetime, lifetimeSpread;
+  struct GtamVec4 startColor, endColor;
+  float startSize, endSize;
+} GtamParticleEmitter;
+
 #define GTAM_CAMERA_TYPE_ORTHOGRAPHIC 0
 #define GTAM_CAMERA_TYPE_PERSPECTIVE 1
 
@@ -100,11 +301,42 @@ typedef struct GtamCamera_T {
 #define GTAM_ERROR_GL3W_BAD_VERSION 4
 #define GTAM_ERROR_TEXTURE_LOAD_FAIL 5
 #define GTAM_ERROR_SHADER_LOAD_FAIL 6
+#define GTAM_ERROR_INVALID_HANDLE 7
+#define GTAM_ERROR_HEADLESS_FAILED_INIT 8
+#define GTAM_ERROR_FONT_LOAD_FAIL 9
+#define GTAM_ERROR_PACK_LOAD_FAIL 10
+
+#define GTAM_GL_DEBUG_OFF 0
+#define GTAM_GL_DEBUG_PER_FRAME 1
+#define GTAM_GL_DEBUG_PER_CALL 2
+
+#define GTAM_GL_DEBUG_SEVERITY_LOW 0
+#define GTAM_GL_DEBUG_SEVERITY_MEDIUM 1
+#define GTAM_GL_DEBUG_SEVERITY_HIGH 2
+
+/* source, type and id as reported by the driver, text is only valid during
+ * the callback */
+struct GtamGlDebugMessage {
+  unsigned int source, type, id;
+  int severity;
+  const char *text;
+};
+
+/* called from gtamUpdateWindow at most once per distinct message */
+typedef void (*GtamGlDebugCallback)(const struct GtamGlDebugMessage *message,
+                                    void *user);
 
+/* Error of the last call that can fail, made on the calling thread. Calls
+ * taking a window also keep their error in the window, see
+ * gtamWindowGetError. */
 EXPORT int gtamGetError(void);
 EXPORT const char *gtamGetErrorMessage(void);
+EXPORT int gtamWindowGetError(const GtamWindow *window);
+EXPORT const char *gtamWindowGetErrorMessage(const GtamWindow *window);
 
 EXPORT GtamWindow *gtamCreateWindow(struct GtamVec2i size, const char *title);
+/* renders offscreen into a framebuffer of `size`, see gtamWindowReadPixels */
+EXPORT GtamWindow *gtamCreateHeadlessWindow(struct GtamVec2i size);
 EXPORT void gtamDestroyWindow(GtamWindow *window);
 EXPORT void gtamInitWindow(GtamWindow *window);
 EXPORT int gtamWindowShouldClose(const GtamWindow *window);
@@ -117,22 +349,256 @@ EXPORT int gtamWindowIsKeyDown(GtamWindow *window, int keycode);
 EXPORT int gtamWindowIsMouseDown(GtamWindow *window, int button);
 EXPORT void gtamWindowGetMousePosition(GtamWindow *window,
                                        struct GtamVec2 *position);
-EXPORT GtamTexture *gtamWindowNewTexture(GtamWindow *window, const char *path);
-EXPORT void gtamWindowDelTexture(GtamWindow *window, GtamTexture *texture);
-EXPORT GtamShader *gtamWindowNewShader(GtamWindow *window, const char *vertex,
-                                       const char *fragment,
-                                       size_t vertexCount);
-EXPORT void gtamWindowDelShader(GtamWindow *window, GtamShader *shader);
-EXPORT GtamSprite *gtamWindowNewSprite(GtamWindow *window, GtamTexture *texture,
-                                       GtamShader *shader);
-EXPORT void gtamWindowDelSprite(GtamWindow *window, GtamSprite *sprite);
-EXPORT GtamCamera *gtamWindowNewCamera(GtamWindow *window, int type);
-EXPORT void gtamWindowDelCamera(GtamWindow *window, GtamCamera *camera);
-EXPORT void gtamWindowSetActiveCamera(GtamWindow *window, GtamCamera *camera);
-EXPORT GtamCamera *gtamWindowGetActiveCamera(const GtamWindow *window);
+EXPORT void gtamWindowSetAtlasOptions(GtamWindow *window,
+                                      const struct GtamAtlasOptions *options);
+EXPORT void gtamWindowGetAtlasStats(const GtamWindow *window,
+                                    struct GtamAtlasStats *stats);
+EXPORT GtamTextureHandle gtamWindowNewTexture(GtamWindow *window,
+                                              const char *path);
+EXPORT GtamTextureHandle gtamWindowNewTextureAsync(GtamWindow *window,
+                                                   const char *path,
+                                                   GtamTextureCallback callback,
+                                                   void *user);
+EXPORT void gtamWindowSetTextureUploadBudget(GtamWindow *window,
+                                             size_t bytesPerFrame);
+EXPORT size_t gtamWindowGetPendingTextureCount(const GtamWindow *window);
+/* textures drawn the longest time ago are evicted while all of them take more
+ * than `bytes`, and loaded again when drawn; 0 for no budget */
+EXPORT void gtamWindowSetTextureBudget(GtamWindow *window, size_t bytes);
+EXPORT void
+gtamWindowGetTextureResidencyStats(const GtamWindow *window,
+                                   struct GtamTextureResidencyStats *stats);
+EXPORT void gtamWindowDelTexture(GtamWindow *window,
+                                 GtamTextureHandle texture);
+EXPORT GtamTexture *gtamWindowGetTexture(GtamWindow *window,
+                                         GtamTextureHandle texture);
+EXPORT GtamShaderHandle gtamWindowNewShader(GtamWindow *window,
+                                            const char *vertex,
+                                            const char *fragment,
+                                            size_t vertexCount);
+EXPORT void gtamWindowDelShader(GtamWindow *window, GtamShaderHandle shader);
+/* linked programs are cached in `path` across launches, NULL or "" for off */
+EXPORT void gtamWindowSetProgramCacheDirectory(GtamWindow *window,
+                                               const char *path);
+EXPORT void gtamWindowGetProgramCacheStats(const GtamWindow *window,
+                                           struct GtamProgramCacheStats *stats);
+EXPORT GtamShader *gtamWindowGetShader(GtamWindow *window,
+                                       GtamShaderHandle shader);
+/* reflected when the shader was linked, the counts are 0 for a stale handle
+ * and the getters return 0 for an index out of range */
+EXPORT size_t gtamWindowGetShaderUniformCount(const GtamWindow *window,
+                                              GtamShaderHandle shader);
+EXPORT int gtamWindowGetShaderUniform(const GtamWindow *window,
+                                      GtamShaderHandle shader, size_t index,
+                                      struct GtamShaderUniform *uniform);
+EXPORT size_t gtamWindowGetShaderUniformBlockCount(const GtamWindow *window,
+                                                   GtamShaderHandle shader);
+EXPORT int
+gtamWindowGetShaderUniformBlock(const GtamWindow *window,
+                                GtamShaderHandle shader, size_t index,
+                                struct GtamShaderUniformBlock *block);
+/* the pack stays mapped until it is unloaded, textures and shaders created
+ * from it outlive it */
+EXPORT GtamPackHandle gtamWindowLoadPack(GtamWindow *window, const char *path);
+EXPORT void gtamWindowUnloadPack(GtamWindow *window, GtamPackHandle pack);
+EXPORT const GtamPack *gtamWindowGetPack(const GtamWindow *window,
+                                         GtamPackHandle pack);
+EXPORT GtamTextureHandle gtamWindowNewTextureFromPack(GtamWindow *window,
+                                                      GtamPackHandle pack,
+                                                      const char *name);
+EXPORT GtamShaderHandle gtamWindowNewShaderFromPack(GtamWindow *window,
+                                                    GtamPackHandle pack,
+                                                    const char *name,
+                                                    size_t vertexCount);
+/* Sets a uniform outside of uniform blocks, uploaded before the shader's next
+ * draw if it changed. `count` floats (ints for int and bool vectors and
+ * samplers) of one or more whole elements. Returns 0 for unknown uniforms,
+ * type mismatches and uTransform, uTexture and uTextureView. */
+EXPORT int gtamWindowSetShaderParameter(GtamWindow *window,
+                                        GtamShaderHandle shader,
+                                        const char *name, const float *values,
+                                        size_t count);
+EXPORT int gtamWindowSetShaderParameterInt(GtamWindow *window,
+                                           GtamShaderHandle shader,
+                                           const char *name, const int *values,
+                                           size_t count);
+EXPORT GtamSpriteHandle gtamWindowNewSprite(GtamWindow *window,
+                                            GtamTextureHandle texture,
+                                            GtamShaderHandle shader);
+EXPORT void gtamWindowDelSprite(GtamWindow *window, GtamSpriteHandle sprite);
+EXPORT GtamSprite *gtamWindowGetSprite(GtamWindow *window,
+                                       GtamSpriteHandle sprite);
+/* Batched calls. Sprite i's values are read from `values + i * stride` bytes,
+ * a stride of 0 meaning tightly packed floats. Stale handles are skipped, the
+ * setters return how many sprites they wrote. */
+EXPORT size_t gtamWindowNewSprites(GtamWindow *window,
+                                   GtamTextureHandle texture,
+                                   GtamShaderHandle shader, size_t count,
+                                   GtamSpriteHandle *sprites);
+EXPORT void gtamWindowDelSprites(GtamWindow *window,
+                                 const GtamSpriteHandle *sprites,
+                                 size_t count);
+/* xyz */
+EXPORT size_t gtamWindowSetSpritePositions(GtamWindow *window,
+                                           const GtamSpriteHandle *sprites,
+                                           size_t count, const float *values,
+                                           size_t stride);
+/* xyz */
+EXPORT size_t gtamWindowSetSpriteScales(GtamWindow *window,
+                                        const GtamSpriteHandle *sprites,
+                                        size_t count, const float *values,
+                                        size_t stride);
+/* quaternion xyzw */
+EXPORT size_t gtamWindowSetSpriteRotations(GtamWindow *window,
+                                           const GtamSpriteHandle *sprites,
+                                           size_t count, const float *values,
+                                           size_t stride);
+/* rgba */
+EXPORT size_t gtamWindowSetSpriteColors(GtamWindow *window,
+                                        const GtamSpriteHandle *sprites,
+                                        size_t count, const float *values,
+                                        size_t stride);
+/* texture view position xy, scale zw */
+EXPORT size_t gtamWindowSetSpriteTextureViews(GtamWindow *window,
+                                              const GtamSpriteHandle *sprites,
+                                              size_t count,
+                                              const float *values,
+                                              size_t stride);
+EXPORT GtamSpriteBatchHandle gtamWindowNewSpriteBatch(GtamWindow *window,
+                                                      GtamTextureHandle texture,
+                                                      GtamShaderHandle shader,
+                                                      size_t count);
+EXPORT void gtamWindowDelSpriteBatch(GtamWindow *window,
+                                     GtamSpriteBatchHandle batch);
+/* returns 0 for a stale handle */
+EXPORT int gtamWindowGetSpriteBatch(GtamWindow *window,
+                                    GtamSpriteBatchHandle batch,
+                                    struct GtamSpriteBatch *arrays);
+EXPORT void gtamWindowResizeSpriteBatch(GtamWindow *window,
+                                        GtamSpriteBatchHandle batch,
+                                        size_t count);
+/* at most 65535 tiles per side, all layers start out empty */
+EXPORT GtamTilemapHandle gtamWindowNewTilemap(GtamWindow *window,
+                                              GtamTextureHandle texture,
+                                              GtamShaderHandle shader,
+                                              struct GtamVec2i size,
+                                              struct GtamVec2i atlasSize,
+                                              size_t layerCount);
+EXPORT void gtamWindowDelTilemap(GtamWindow *window,
+                                 GtamTilemapHandle tilemap);
+EXPORT GtamTilemap *gtamWindowGetTilemap(GtamWindow *window,
+                                         GtamTilemapHandle tilemap);
+/* 0 for a stale handle */
+EXPORT size_t gtamWindowGetTilemapLayerCount(const GtamWindow *window,
+                                             GtamTilemapHandle tilemap);
+/* tiles outside of the map read as 0, setting them does nothing */
+EXPORT void gtamWindowSetTile(GtamWindow *window, GtamTilemapHandle tilemap,
+                              size_t layer, struct GtamVec2i tile,
+                              uint16_t value);
+EXPORT uint16_t gtamWindowGetTile(const GtamWindow *window,
+                                  GtamTilemapHandle tilemap, size_t layer,
+                                  struct GtamVec2i tile);
+/* a block of `size` tiles at `origin`, row by row */
+EXPORT void gtamWindowSetTiles(GtamWindow *window, GtamTilemapHandle tilemap,
+                               size_t layer, struct GtamVec2i origin,
+                               struct GtamVec2i size, const uint16_t *tiles);
+EXPORT void gtamWindowSetTilemapLayerDepth(GtamWindow *window,
+                                           GtamTilemapHandle tilemap,
+                                           size_t layer, float depth);
+EXPORT float gtamWindowGetTilemapLayerDepth(const GtamWindow *window,
+                                            GtamTilemapHandle tilemap,
+                                            size_t layer);
+/* glyphs are rendered with glyphSize pixels from ascent to descent */
+EXPORT GtamFontHandle gtamWindowNewFont(GtamWindow *window, const char *path,
+                                        int glyphSize);
+EXPORT void gtamWindowDelFont(GtamWindow *window, GtamFontHandle font);
+EXPORT const GtamFont *gtamWindowGetFont(const GtamWindow *window,
+                                         GtamFontHandle font);
+/* rendered glyphs are kept in path for fonts created later, NULL turns it
+ * off */
+EXPORT void gtamWindowSetFontCacheDirectory(GtamWindow *window,
+                                            const char *path);
+/* string is utf-8, lines are separated by '\n' */
+EXPORT GtamTextHandle gtamWindowNewText(GtamWindow *window,
+                                        GtamFontHandle font,
+                                        GtamShaderHandle shader,
+                                        const char *string);
+EXPORT void gtamWindowDelText(GtamWindow *window, GtamTextHandle text);
+EXPORT GtamText *gtamWindowGetText(GtamWindow *window, GtamTextHandle text);
+EXPORT void gtamWindowSetTextString(GtamWindow *window, GtamTextHandle text,
+                                    const char *string);
+/* NULL for a stale handle, valid until the string changes */
+EXPORT const char *gtamWindowGetTextString(const GtamWindow *window,
+                                           GtamTextHandle text);
+/* width of the longest line and height of all lines, in units of size */
+EXPORT void gtamWindowGetTextExtent(GtamWindow *window, GtamTextHandle text,
+                                    struct GtamVec2 *extent);
+EXPORT GtamParticleEmitterHandle
+gtamWindowNewParticleEmitter(GtamWindow *window, GtamTextureHandle texture,
+                             GtamShaderHandle shader, size_t capacity);
+EXPORT void gtamWindowDelParticleEmitter(GtamWindow *window,
+                                         GtamParticleEmitterHandle emitter);
+EXPORT GtamParticleEmitter *
+gtamWindowGetParticleEmitter(GtamWindow *window,
+                             GtamParticleEmitterHandle emitter);
+EXPORT size_t
+gtamWindowGetParticleEmitterCapacity(const GtamWindow *window,
+                                     GtamParticleEmitterHandle emitter);
+/* spawns count particles at once with the next update */
+EXPORT void gtamWindowEmitParticles(GtamWindow *window,
+                                    GtamParticleEmitterHandle emitter,
+                                    size_t count);
+/* seconds per update, 0 for real time (the default) */
+EXPORT void gtamWindowSetParticleTimeStep(GtamWindow *window, float seconds);
+EXPORT GtamCameraHandle gtamWindowNewCamera(GtamWindow *window, int type);
+EXPORT void gtamWindowDelCamera(GtamWindow *window, GtamCameraHandle camera);
+EXPORT GtamCamera *gtamWindowGetCamera(GtamWindow *window,
+                                       GtamCameraHandle camera);
+EXPORT void gtamWindowSetActiveCamera(GtamWindow *window,
+                                      GtamCameraHandle camera);
+EXPORT GtamCameraHandle gtamWindowGetActiveCamera(const GtamWindow *window);
+EXPORT void gtamWindowSetCulling(GtamWindow *window, int enabled);
+/* 0 for one thread per core */
+EXPORT void gtamWindowSetThreadCount(GtamWindow *window, size_t threads);
+EXPORT size_t gtamWindowGetThreadCount(const GtamWindow *window);
+/* GTAM_GL_DEBUG_PER_FRAME by default */
+EXPORT void gtamWindowSetGlDebugMode(GtamWindow *window, int mode);
+EXPORT int gtamWindowGetGlDebugMode(const GtamWindow *window);
+/* NULL prints messages to stderr */
+EXPORT void gtamWindowSetGlDebugCallback(GtamWindow *window,
+                                         GtamGlDebugCallback callback,
+                                         void *user);
+/* world space queries, write up to `capacity` handles and return the number
+ * of hits, which may be larger */
+EXPORT size_t gtamWindowGetSpritesInRect(GtamWindow *window,
+                                         struct GtamVec2 min,
+                                         struct GtamVec2 max,
+                                         GtamSpriteHandle *sprites,
+                                         size_t capacity);
+/* topmost first */
+EXPORT size_t gtamWindowGetSpritesAtPoint(GtamWindow *window,
+                                          struct GtamVec2 point,
+                                          GtamSpriteHandle *sprites,
+                                          size_t capacity);
+EXPORT void gtamWindowScreenToWorld(GtamWindow *window,
+                                    struct GtamVec2 position,
+                                    struct GtamVec2 *world);
 EXPORT void gtamWindowGetFramebufferSize(const GtamWindow *window,
                                          struct GtamVec2 *framebufferSize);
 EXPORT float gtamWindowGetAspectRatio(const GtamWindow *window);
+EXPORT void gtamWindowGetFrameStats(const GtamWindow *window,
+                                    struct GtamFrameStats *stats);
+/* up to `count` of the most recent frames, oldest first, returns the count */
+EXPORT size_t gtamWindowGetFrameStatsHistory(const GtamWindow *window,
+                                             struct GtamFrameStats *stats,
+                                             size_t count);
+EXPORT void gtamWindowGetStreamStats(const GtamWindow *window,
+                                     struct GtamStreamStats *stats);
+EXPORT void gtamWindowSetFrameStatsHistorySize(GtamWindow *window,
+                                               size_t frames);
+EXPORT int gtamWindowIsHeadless(const GtamWindow *window);
+/* last frame as rgba8, width * height * 4 bytes, bottom row first */
+EXPORT void gtamWindowReadPixels(GtamWindow *window, void *pixels);
 
 enum GtamKeyCode {
   GTAM_KEYCODE_UNKNOWN = -1,
@@ -5,6 +5,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -20,7 +22,11 @@ enum class ExceptionType {
   Gl3wFailedInit = 3,
   Gl3wBadVersion = 4,
   TextureLoadFail = 5,
-  ShaderLoadFail = 6
+  ShaderLoadFail = 6,
+  InvalidHandle = 7,
+  HeadlessFailedInit = 8,
+  FontLoadFail = 9,
+  PackLoadFail = 10
 };
 
 struct Exception {
@@ -28,36 +34,276 @@ struct Exception {
   std::string message;
 };
 
+// Objects are owned by the `Window` and referred to by generational handles.
+// Once an object is deleted its handles become stale and resolve to nullptr,
+// even if the slot gets reused by a newer object.
+template <typename T> struct Handle {
+  uint32_t index = 0;
+  uint32_t generation = 0; // 0 is never live, so `Handle{}` is a null handle
+
+  explicit operator bool() const { return generation != 0; }
+  bool operator==(const Handle &) const = default;
+};
+
+struct Texture;
+struct Shader;
+struct Sprite;
+struct SpriteBatch;
+struct Camera;
+struct Tilemap;
+struct Font;
+struct Text;
+struct ParticleEmitter;
+struct Pack;
+
+using TextureHandle = Handle<Texture>;
+using ShaderHandle = Handle<Shader>;
+using SpriteHandle = Handle<Sprite>;
+using SpriteBatchHandle = Handle<SpriteBatch>;
+using CameraHandle = Handle<Camera>;
+using TilemapHandle = Handle<Tilemap>;
+using FontHandle = Handle<Font>;
+using TextHandle = Handle<Text>;
+using ParticleEmitterHandle = Handle<ParticleEmitter>;
+using PackHandle = Handle<Pack>;
+
+// Evicted textures had their gpu copy freed to stay within the texture budget
+// and are loaded again once something draws them.
+enum class TextureState : int {
+  Resident = 0,
+  Loading = 1,
+  Failed = 2,
+  Evicted = 3
+};
+
 struct Texture {
   GLuint id;
   glm::vec2 size;
+  // part of `id` holding the image in texture coordinates, the whole texture
+  // unless the image was packed into an atlas page. Sprite texture views are
+  // relative to this region.
+  struct {
+    glm::vec2 position, scale;
+  } region;
+  // `id` is a shared placeholder unless the texture is resident
+  TextureState state;
+  int atlasPage; // -1 if the texture owns `id`
 };
 
+// called from `Window::update` once an async texture is resident (`loaded`)
+// or failed to load
+using TextureCallback = std::function<void(TextureHandle texture, bool loaded)>;
+
+// Opt-in packing of small images into shared textures, so that sprites using
+// different images can still be drawn in one batch. Each image gets a gutter
+// of `padding` pixels filled with its edge pixels, and is placed on a 4 pixel
+// grid so the first mip levels don't bleed into the neighbours. Since the
+// image is only part of a texture, texture views outside of 0..1 don't repeat
+// it but sample the neighbouring images of the page, so sprites with such
+// views must not use atlas textures.
+struct AtlasOptions {
+  bool enabled = false;
+  int pageSize = 2048;    // width and height of a page
+  int maxImageSize = 256; // larger images get their own texture
+  int padding = 2;
+};
+
+struct AtlasStats {
+  size_t pageCount;
+  size_t imageCount;
+  size_t usedPixels;  // packed images including gutters
+  size_t totalPixels; // all pages
+};
+
+// Shaders can either use the `uTransform` (mat4) and `uTextureView` (vec4)
+// uniforms, which costs one draw call per sprite, or read the same data from
+// per-instance vertex attributes, in which case consecutive sprites sharing the
+// shader and texture are drawn with a single instanced draw call:
+//
+//   in mat4 aTransform;   // model-view-projection of the sprite
+//   in vec4 aTextureView; // xy = texture view position, zw = scale
+//   in vec4 aColor;       // Sprite::color
+//
+// The attribute locations are bound by `newShader`, so no layout qualifiers are
+// needed. A shader is instanced if it has an active `aTransform` attribute.
+//
+// The active camera is also available to every shader through a uniform block,
+// updated only when the camera changes:
+//
+//   layout(std140) uniform GtamCamera {
+//     mat4 view;
+//     mat4 projection;
+//     mat4 viewProjection; // projection * view
+//     vec4 position;       // xyz = camera position
+//   };
+//
+// Shaders using it get model matrices in `aTransform`/`uTransform` instead of
+// model-view-projection ones, so sprites keep theirs while the camera moves.
 struct Shader {
   GLuint id;
   size_t vertexCount;
   bool line;
+  bool instanced;
+  bool cameraBlock; // uses the GtamCamera uniform block
   struct {
     GLint transform;
     GLint texture;
     GLint textureView;
+    GLint color;
   } uniforms;
 };
 
+// An active uniform of a shader's program, as reflected after linking. Array
+// names don't have the trailing "[0]", `size` is their element count.
+struct ShaderUniform {
+  std::string name;
+  GLenum type;    // GL_FLOAT_VEC4, GL_SAMPLER_2D, ...
+  GLint size;
+  GLint location; // -1 for members of uniform blocks
+  GLint block;    // index into the shader's uniform blocks, or -1
+};
+
+struct ShaderUniformBlock {
+  std::string name;
+  GLint size; // bytes
+  GLuint binding;
+};
+
 struct TextureView {
   glm::vec2 position, scale;
-  Texture *source;
+  TextureHandle source;
 };
 
 struct Sprite {
   TextureView texture;
-  Shader *shader;
+  ShaderHandle shader;
   glm::vec4 color;
   glm::vec3 position;
   glm::vec3 scale;
   glm::quat rotation;
 };
 
+// Sprites sharing a texture and shader whose per-sprite data is kept in
+// contiguous arrays, element i belonging to `sprites[i]`, so whole populations
+// can be written at once. `update` copies the arrays into the sprites, so
+// these fields of batch sprites can't be set through `getSprite`. Resizing or
+// deleting the batch reallocates the arrays.
+struct SpriteBatch {
+  TextureHandle texture;
+  ShaderHandle shader;
+  std::vector<SpriteHandle> sprites;
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> scales;
+  std::vector<glm::quat> rotations;
+  std::vector<glm::vec4> colors;
+  std::vector<glm::vec4> textureViews; // position in xy, scale in zw
+};
+
+// A grid of tiles showing cells of an atlas texture, for large static worlds
+// that would be far too many sprites. Tile (x, y) covers `position.xy +
+// (x, y) * tileSize` to `position.xy + (x + 1, y + 1) * tileSize`. A tile is 0
+// for none, or n for the n-th cell of `texture`, counted from 1 row by row
+// from the image's top left, with `atlasSize` cells per row and column.
+//
+// Each layer is drawn at `position.z` plus its depth, in order with the
+// sprites, before sprites at the same depth, and after the layers before it.
+// Tiles are stored in chunks of 32x32, and only chunks the active camera can
+// see are drawn, each with one draw call from a vertex buffer that is only
+// rebuilt when one of its tiles changes. The shader gets the tile corners
+// through
+//
+//   in vec2 aTilePosition; // in tiles
+//   in vec2 aTileUv;       // 0..1 over the texture
+//
+// and `uTransform` (tiles to clip space, or to world space for shaders with
+// the camera block), `uTexture` and `uTextureView` like non-instanced sprites.
+struct Tilemap {
+  TextureHandle texture;
+  ShaderHandle shader;
+  glm::ivec2 size; // tiles, fixed
+  glm::ivec2 atlasSize;
+  glm::vec3 position;
+  glm::vec2 tileSize; // world units
+};
+
+// An asset pack file (see `gtampack`) mapped into memory, whose textures and
+// shaders are created by name.
+struct Pack {
+  size_t textureCount;
+  size_t shaderCount;
+  size_t bytes; // of the file
+};
+
+// Metrics of a TrueType font, in units of the text size, which is the distance
+// from the font's ascent to its descent.
+struct Font {
+  float ascent;     // above the baseline
+  float descent;    // below the baseline, negative
+  float lineHeight; // from one baseline to the next
+  int glyphSize;    // pixels from ascent to descent in the distance fields
+};
+
+// A string drawn with a font in a single draw call. Glyphs are rendered as
+// signed distance fields into the font's atlas the first time any text uses
+// them, and the text is only laid out again (with kerning) when its string or
+// font changes, so unchanged text costs a draw call per frame and nothing
+// else. Texts are drawn in order with the sprites by depth, after sprites and
+// tilemap layers at the same depth. The shader gets the glyph quads through
+//
+//   in vec2 aGlyphPosition; // in units of `size`, baseline at y = 0
+//   in vec2 aGlyphUv;
+//
+// and `uTransform` (to clip space, or to world space for shaders with the
+// camera block), `uColor` and the atlas in `uTexture`. Its red channel is 0.5
+// on the outlines of the glyphs and falls to 0 an eighth of the glyph size
+// outside of them, so the fragment shader can do
+//
+//   float distance = texture(uTexture, sUv).r;
+//   float width = fwidth(distance);
+//   color = vec4(uColor.rgb, uColor.a * smoothstep(0.5 - width, 0.5 + width,
+//                                                  distance));
+struct Text {
+  FontHandle font;
+  ShaderHandle shader;
+  glm::vec3 position; // of the first line's baseline, at its left end
+  glm::quat rotation;
+  float size; // world units from ascent to descent
+  glm::vec4 color;
+};
+
+// A fountain of particles that live entirely in gpu buffers: spawning, motion,
+// aging and death run in a transform feedback pass every `Window::update`, and
+// all of an emitter's particles are drawn with one instanced draw call, so an
+// emitter costs the cpu the same whatever its capacity. Emitters are drawn in
+// order with the sprites by `position.z`, after sprites, tilemap layers and
+// texts at the same depth, and are never culled.
+//
+// Each step spawns `rate * delta` particles (plus those of `emitParticles`)
+// into the next slots of a ring over the capacity. A spawn landing on a live
+// particle is dropped, so the capacity should be at least `rate * lifetime`.
+// Values with a spread get a uniform random offset of up to it either way.
+//
+// The shader draws every particle as an instance of its `vertexCount` vertex
+// triangle strip (dead particles have size 0), with
+//
+//   in vec3 aParticlePosition; // world space
+//   in vec4 aParticleColor;
+//   in float aParticleSize;    // world units
+//
+// and `uTransform` (world to clip space, or the identity for shaders with the
+// camera block), `uTexture` and `uTextureView` like non-instanced sprites.
+struct ParticleEmitter {
+  TextureHandle texture;
+  ShaderHandle shader;
+  glm::vec3 position, positionSpread;
+  glm::vec3 velocity, velocitySpread; // world units per second
+  glm::vec3 acceleration;
+  float rate;                     // particles per second
+  float lifetime, lifetimeSpread; // seconds
+  glm::vec4 startColor, endColor; // over the lifetime
+  float startSize, endSize;
+};
+
 enum class CameraType : int { Orthographic = 0, Perspective = 1 };
 
 struct Camera {
@@ -79,17 +325,106 @@ struct Camera {
   };
 };
 
+// Instance data and async texture rows are streamed through ring buffers of
+// three regions, one per frame in flight, each guarded by a fence. Totals since
+// `Window::init`.
+struct StreamStats {
+  bool persistent;      // mapped once through ARB_buffer_storage
+  size_t capacity;      // bytes, all regions of all buffers
+  size_t bytesStreamed;
+  size_t allocations;
+  size_t reallocations; // a frame didn't fit into its region
+  size_t fenceWaits;    // regions the gpu was still reading when reached
+  double fenceWaitTime; // milliseconds
+};
+
+// Textures with a gl texture of their own, which is all but atlas images.
+// Only those count against the texture budget.
+struct TextureResidencyStats {
+  size_t budget;        // 0 for none
+  size_t residentBytes; // mip levels included
+  size_t residentCount;
+  size_t evictedCount; // not reloaded yet
+  size_t evictions;    // since `init`
+  size_t reloads;
+};
+
+struct ProgramCacheStats {
+  size_t hits;
+  size_t misses;   // compiled from source, rejected binaries included
+  size_t rejected; // binaries the driver refused to load
+  size_t stored;
+};
+
+// When gl errors and driver messages are looked for. Per frame costs one
+// check at the end of `Window::update`, per call one after every draw call as
+// well, which stalls on some drivers and is meant for tracking errors down.
+enum class GlDebugMode : int { Off = 0, PerFrame = 1, PerCall = 2 };
+
+enum class GlDebugSeverity : int { Low = 0, Medium = 1, High = 2 };
+
+// A message from the driver (KHR_debug or ARB_debug_output) or an error found
+// with glGetError on drivers without either. `source`, `type` and `id` are as
+// given by the driver; glGetError errors come as GL_DEBUG_SOURCE_API,
+// GL_DEBUG_TYPE_ERROR and the error code.
+struct GlDebugMessage {
+  GLenum source;
+  GLenum type;
+  GLuint id;
+  GlDebugSeverity severity;
+  const char *text; // only valid during the callback
+};
+
+// Called from `Window::update` (or the draw loop in per call mode), at most
+// once per distinct message. Without a callback messages go to stderr.
+using GlDebugCallback = std::function<void(const GlDebugMessage &message)>;
+
+// What one `Window::update` did. Times are in milliseconds.
+struct FrameStats {
+  uint64_t frame; // counts updates from 0
+  struct {
+    double poll;      // window events
+    double upload;    // async texture uploads
+    double sort;      // atlas mips and draw order
+    double cull;      // spatial index update and frustum culling
+    double transform; // per sprite data
+    double submit;    // buffer upload and draw calls
+    double swap;
+    double total;
+  } cpuTime;
+  // measured with a timer query that is only read back a few frames later, so
+  // it is -1 for the latest frames (and for frames the gpu fell too far behind
+  // on to be timed without stalling)
+  double gpuTime;
+  size_t drawCalls;
+  size_t programBinds;
+  size_t textureBinds;
+  size_t uniformUploads;
+  size_t spritesDrawn;
+  size_t spritesCulled;
+  // gl calls skipped because they wouldn't have changed anything
+  size_t stateChangesFiltered;
+  size_t tileChunksDrawn;
+  size_t textsDrawn;
+  size_t particlesSimulated; // capacity of every emitter
+};
+
 enum class KeyCode;
 
 class Window {
 public:
-  Window(glm::ivec2 size, const char *title) : size(size), title(title) {}
+  // A headless window has no window system behind it: it renders into an
+  // offscreen framebuffer of `size` (see `readPixels`), never receives input
+  // and only closes through `close`.
+  Window(glm::ivec2 size, const char *title, bool headless = false)
+      : size(size), title(title), headless(headless) {}
 
   void init();
   bool shouldClose() const;
   void close();
   void unclose();
   void update(bool depth = false);
+  // frees everything `init` created, worker threads included
   void deinit();
 
   float getTime();
@@ -98,28 +433,223 @@ public:
   bool isMouseDown(int button);
   glm::vec2 getMousePosition();
 
-  Texture *newTexture(const char *path);
-  void delTexture(Texture *texture);
+  // The pointers returned by the getters point into contiguous storage and are
+  // only valid until the next new/del call of the same kind of object. They
+  // are nullptr for stale handles.
+
+  // only affects textures created afterwards
+  void setAtlasOptions(const AtlasOptions &options);
+  AtlasStats getAtlasStats() const;
+
+  // KTX and DDS files are uploaded with their compressed format and mip
+  // levels as they are (decoded on the cpu if the driver can't sample the
+  // format), anything else is decoded to rgba8 and mipmapped.
+  TextureHandle newTexture(const char *path);
+  // Decodes the image on a worker thread and uploads it through pixel buffers
+  // over the following frames. Only the image header is read right away, so
+  // the texture already has its final size and can be used for sprites, which
+  // show a placeholder until it is resident.
+  TextureHandle newTextureAsync(const char *path,
+                                TextureCallback callback = {});
+  // bytes of async texture data uploaded per `update`, at least one row (or
+  // mip level of a KTX/DDS file) of one texture always goes through
+  void setTextureUploadBudget(size_t bytesPerFrame);
+  // async textures not resident yet
+  size_t getPendingTextureCount() const;
+  // Once textures take more than `bytes` of gpu memory (their mip levels
+  // included), the ones drawn the longest time ago are evicted at the end of
+  // `update` until they fit: their gl texture is deleted and sprites show the
+  // placeholder until it is back. The next time anything draws them they are
+  // loaded again, from their file through the async loader or from their
+  // pack. Textures drawn in the current frame, atlas images and textures from
+  // an unloaded pack are never evicted. 0, the default, is no budget.
+  void setTextureBudget(size_t bytes);
+  TextureResidencyStats getTextureResidencyStats() const;
+  void delTexture(TextureHandle texture);
+  Texture *getTexture(TextureHandle texture);
+
+  SpriteHandle newSprite(TextureHandle texture, ShaderHandle shader);
+  void delSprite(SpriteHandle sprite);
+  Sprite *getSprite(SpriteHandle sprite);
+  // `count` sprites at once, their handles go to `sprites`
+  void newSprites(TextureHandle texture, ShaderHandle shader, size_t count,
+                  SpriteHandle *sprites);
+  void delSprites(const SpriteHandle *sprites, size_t count);
+
+  // `count` new sprites, set up like `newSprite` does
+  SpriteBatchHandle newSpriteBatch(TextureHandle texture, ShaderHandle shader,
+                                   size_t count);
+  // deletes the batch's sprites as well
+  void delSpriteBatch(SpriteBatchHandle batch);
+  SpriteBatch *getSpriteBatch(SpriteBatchHandle batch);
+  // adds sprites to or deletes them from the end
+  void resizeSpriteBatch(SpriteBatchHandle batch, size_t count);
 
-  Sprite *newSprite(Texture *texture, Shader *shader);
-  void delSprite(Sprite *sprite);
+  ShaderHandle newShader(const char *vertex, const char *fragment,
+                         size_t vertexCount);
+  // Linked programs are saved to and loaded from `path` (created if needed)
+  // instead of being compiled again on the next launch, keyed by their sources
+  // and the driver. Off with an empty path, the default.
+  void setProgramCacheDirectory(const char *path);
+  ProgramCacheStats getProgramCacheStats() const;
+  void delShader(ShaderHandle shader);
+  Shader *getShader(ShaderHandle shader);
+  const std::vector<ShaderUniform> *
+  getShaderUniforms(ShaderHandle shader) const;
+  const std::vector<ShaderUniformBlock> *
+  getShaderUniformBlocks(ShaderHandle shader) const;
 
-  Shader *newShader(const char *vertex, const char *fragment,
-                    size_t vertexCount);
-  void delShader(Shader *shader);
+  // Maps the pack file, which stays mapped until it is unloaded. Throws
+  // PackLoadFail if it isn't a valid pack.
+  PackHandle loadPack(const char *path);
+  // Textures and shaders created from the pack stay valid, its evicted
+  // textures are uploaded again first.
+  void unloadPack(PackHandle pack);
+  const Pack *getPack(PackHandle pack) const;
+  // Uploads the texture's mip levels straight from the mapping, in their
+  // compressed format unless the driver can't sample it. Like KTX/DDS files it
+  // never goes into the atlas. Throws TextureLoadFail if there is no texture
+  // `name` in the pack.
+  TextureHandle newTextureFromPack(PackHandle pack, const char *name);
+  // throws ShaderLoadFail if there is no shader `name` in the pack
+  ShaderHandle newShaderFromPack(PackHandle pack, const char *name,
+                                 size_t vertexCount);
+  // Sets a uniform of the shader outside of a uniform block, uploaded before
+  // its next draw if the value changed. `count` must be a whole number of
+  // elements of the uniform's type, floats for float vectors and matrices
+  // (column major), ints for int and bool vectors and samplers. False if
+  // there is no such uniform, the type doesn't match, or the uniform is one
+  // the window sets itself (`uTransform`, `uTexture`, `uTextureView`).
+  bool setShaderParameter(ShaderHandle shader, const char *name,
+                          const float *values, size_t count);
+  bool setShaderParameter(ShaderHandle shader, const char *name,
+                          const int *values, size_t count);
+  bool setShaderParameter(ShaderHandle shader, const char *name, float value) {
+    return setShaderParameter(shader, name, &value, 1);
+  }
+  bool setShaderParameter(ShaderHandle shader, const char *name,
+                          glm::vec2 value) {
+    return setShaderParameter(shader, name, &value[0], 2);
+  }
+  bool setShaderParameter(ShaderHandle shader, const char *name,
+                          glm::vec3 value) {
+    return setShaderParameter(shader, name, &value[0], 3);
+  }
+  bool setShaderParameter(ShaderHandle shader, const char *name,
+                          glm::vec4 value) {
+    return setShaderParameter(shader, name, &value[0], 4);
+  }
+  bool setShaderParameter(ShaderHandle shader, const char *name,
+                          const glm::mat4 &value) {
+    return setShaderParameter(shader, name, &value[0][0], 16);
+  }
+  bool setShaderParameter(ShaderHandle shader, const char *name, int value) {
+    return setShaderParameter(shader, name, &value, 1);
+  }
 
-  Camera *newCamera(CameraType type);
-  void delCamera(Camera *camera);
+  // `layerCount` layers of `size` tiles (at most 65535 per side), all empty
+  TilemapHandle newTilemap(TextureHandle texture, ShaderHandle shader,
+                           glm::ivec2 size, glm::ivec2 atlasSize,
+                           size_t layerCount = 1);
+  void delTilemap(TilemapHandle tilemap);
+  Tilemap *getTilemap(TilemapHandle tilemap);
+  size_t getTilemapLayerCount(TilemapHandle tilemap) const;
+  // tiles outside of the map read as 0, setting them does nothing
+  void setTile(TilemapHandle tilemap, size_t layer, glm::ivec2 tile,
+               uint16_t value);
+  uint16_t getTile(TilemapHandle tilemap, size_t layer, glm::ivec2 tile) const;
+  // a block of `size` tiles at `origin`, row by row from `tiles`
+  void setTiles(TilemapHandle tilemap, size_t layer, glm::ivec2 origin,
+                glm::ivec2 size, const uint16_t *tiles);
+  // added to the tilemap's z, 0 by default
+  void setTilemapLayerDepth(TilemapHandle tilemap, size_t layer, float depth);
+  float getTilemapLayerDepth(TilemapHandle tilemap, size_t layer) const;
 
-  Camera *getActiveCamera() const;
-  void setActiveCamera(Camera *camera);
+  // Glyphs are rendered with `glyphSize` pixels from ascent to descent, larger
+  // sizes keep sharper corners when scaled up. Throws FontLoadFail.
+  FontHandle newFont(const char *path, int glyphSize = 48);
+  // texts using the font aren't drawn until they get another one
+  void delFont(FontHandle font);
+  const Font *getFont(FontHandle font) const;
+  // Rendered glyphs are written to `path` when their font is deleted, and
+  // fonts created later read them back instead of rendering them again.
+  // Empty turns it off.
+  void setFontCacheDirectory(const char *path);
+
+  // `string` is utf-8, lines are separated by '\n'
+  TextHandle newText(FontHandle font, ShaderHandle shader,
+                     const char *string = "");
+  void delText(TextHandle text);
+  Text *getText(TextHandle text);
+  void setTextString(TextHandle text, const char *string);
+  // nullptr for stale handles, valid until the string changes
+  const char *getTextString(TextHandle text) const;
+  // width of the longest line and height from the first line's ascent to the
+  // last one's descent, in units of `Text::size`
+  glm::vec2 getTextExtent(TextHandle text);
+
+  // `capacity` particles, all dead and with a rate of 0 to begin with
+  ParticleEmitterHandle newParticleEmitter(TextureHandle texture,
+                                           ShaderHandle shader,
+                                           size_t capacity);
+  void delParticleEmitter(ParticleEmitterHandle emitter);
+  ParticleEmitter *getParticleEmitter(ParticleEmitterHandle emitter);
+  size_t getParticleEmitterCapacity(ParticleEmitterHandle emitter) const;
+  // spawns `count` particles at once with the next step
+  void emitParticles(ParticleEmitterHandle emitter, size_t count);
+  // Seconds particles move per `update`. 0, the default, steps them by the
+  // time since the last update, at most a tenth of a second.
+  void setParticleTimeStep(float seconds);
+
+  CameraHandle newCamera(CameraType type);
+  void delCamera(CameraHandle camera);
+  Camera *getCamera(CameraHandle camera);
+
+  CameraHandle getActiveCamera() const;
+  void setActiveCamera(CameraHandle camera);
+
+  // stats of the last update
+  const FrameStats &getFrameStats() const;
+  // Copies the stats of up to `count` of the most recent frames into `stats`,
+  // oldest first, and returns how many were copied. Only the last
+  // `setFrameStatsHistorySize` (default 240) frames are kept.
+  size_t getFrameStatsHistory(FrameStats *stats, size_t count) const;
+  void setFrameStatsHistorySize(size_t frames);
+  StreamStats getStreamStats() const;
+
+  // Sprites are kept in a spatial index by the bounds of their unit quad (the
+  // quad drawn by a 4 vertex strip as in the example shaders). `update` only
+  // draws sprites whose bounds intersect the active camera's frustum; turn
+  // culling off for shaders that draw outside of the quad.
+  void setCulling(bool enabled);
+  // Threads preparing frames (culling, transforms, sort keys, instance data),
+  // the one calling `update` included. 0 means one per core, the default.
+  void setThreadCount(size_t threads);
+  size_t getThreadCount() const;
+  // `GlDebugMode::PerFrame` by default
+  void setGlDebugMode(GlDebugMode mode);
+  GlDebugMode getGlDebugMode() const;
+  void setGlDebugCallback(GlDebugCallback callback);
+  // queries use world space xy and see sprites as they are right now
+  std::vector<SpriteHandle> getSpritesInRect(glm::vec2 min, glm::vec2 max);
+  // hit sprites ordered topmost (highest z) first
+  std::vector<SpriteHandle> getSpritesAtPoint(glm::vec2 point);
+  // window coordinates, as from `getMousePosition`, to world xy on the z = 0
+  // plane as seen by the active camera
+  glm::vec2 screenToWorld(glm::vec2 position);
 
   glm::vec2 getFramebufferSize() const;
   float getAspectRatio() const;
 
+  bool isHeadless() const { return headless; }
+  // Copies the last rendered frame as rgba8 into `pixels`, which must hold
+  // width * height * 4 bytes. Rows go bottom to top, as everywhere in gl.
+  void readPixels(void *pixels);
+
 private:
   glm::vec2 size;
   std::string title;
+  bool headless;
   struct WindowImpl_ *impl_;
 };
 
@@ -0,0 +1,79 @@
+#include "atlas.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+namespace gtamfx {
+SkylinePacker::SkylinePacker(glm::ivec2 size) : size_(size) { reset(); }
+
+void SkylinePacker::reset() {
+  skyline_.clear();
+  skyline_.push_back({0, 0, size_.x});
+}
+
+int SkylinePacker::fit_(size_t index, glm::ivec2 size) const {
+  if (skyline_[index].x + size.x > size_.x)
+    return -1;
+
+  int y = 0;
+  for (int widthLeft = size.x; widthLeft > 0; ++index) {
+    y = std::max(y, skyline_[index].y);
+    if (y + size.y > size_.y)
+      return -1;
+    widthLeft -= skyline_[index].width;
+  }
+  return y;
+}
+
+bool SkylinePacker::pack(glm::ivec2 size, glm::ivec2 &position) {
+  if (size.x <= 0 || size.y <= 0)
+    return false;
+
+  // lowest top edge wins, ties go to the narrowest node to keep gaps small
+  size_t best = SIZE_MAX;
+  int bestTop = INT_MAX, bestWidth = INT_MAX;
+  for (size_t index = 0; index < skyline_.size(); ++index) {
+    int y = fit_(index, size);
+    if (y < 0)
+      continue;
+    int top = y + size.y;
+    if (top < bestTop || (top == bestTop && skyline_[index].width < bestWidth)) {
+      best = index;
+      bestTop = top;
+      bestWidth = skyline_[index].width;
+      position = {skyline_[index].x, y};
+    }
+  }
+
+  if (best == SIZE_MAX)
+    return false;
+
+  skyline_.insert(skyline_.begin() + best, {position.x, bestTop, size.x});
+
+  // cut the nodes now covered by the new one
+  for (size_t index = best + 1; index < skyline_.size();) {
+    const Node_ &previous = skyline_[index - 1];
+    Node_ &node = skyline_[index];
+    const int overlap = previous.x + previous.width - node.x;
+    if (overlap <= 0)
+      break;
+    node.x += overlap;
+    node.width -= overlap;
+    if (node.width > 0)
+      break;
+    skyline_.erase(skyline_.begin() + index);
+  }
+
+  for (size_t index = 1; index < skyline_.size();) {
+    if (skyline_[index - 1].y == skyline_[index].y) {
+      skyline_[index - 1].width += skyline_[index].width;
+      skyline_.erase(skyline_.begin() + index);
+    } else {
+      ++index;
+    }
+  }
+
+  return true;
+}
+} // namespace gtamfx
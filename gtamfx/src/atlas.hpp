@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace gtamfx {
+// Skyline bottom-left rectangle packer for texture atlas pages. Rectangles
+// can't be freed individually, a page is reset once all of its images are
+// gone.
+class SkylinePacker {
+public:
+  explicit SkylinePacker(glm::ivec2 size);
+
+  // returns false if there is no room left for a rectangle of `size`
+  bool pack(glm::ivec2 size, glm::ivec2 &position);
+  void reset();
+
+  glm::ivec2 getSize() const { return size_; }
+
+private:
+  struct Node_ {
+    int x, y, width;
+  };
+
+  // y at which a `size` rectangle fits on top of the skyline starting at node
+  // `index`, or -1 if it doesn't fit there
+  int fit_(size_t index, glm::ivec2 size) const;
+
+  glm::ivec2 size_;
+  std::vector<Node_> skyline_;
+};
+} // namespace gtamfx
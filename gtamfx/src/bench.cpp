@@ -0,0 +1,501 @@
+#include <gtamfx.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Renders a few scripted scenes headless and prints frame times and draw
+// statistics as json, e.g. `./gtamfx/build/bench > bench.json` from the
+// repository root. Usage: bench [-f frames] [-t threads] [-i image] [-o file]
+// [scene...]
+
+namespace {
+const char *instancedVertexSource = R"glsl(
+#version 330 core
+const vec2[4] corners = vec2[4](
+  vec2(-0.5, -0.5), vec2(+0.5, -0.5), vec2(-0.5, +0.5), vec2(+0.5, +0.5)
+);
+
+in mat4 aTransform;
+in vec4 aTextureView;
+in vec4 aColor;
+
+out vec4 sColor;
+out vec2 sTexCoord;
+
+void main() {
+  vec2 corner = corners[gl_VertexID];
+  gl_Position = aTransform * vec4(corner, 0.0, 1.0);
+  sColor = aColor;
+  sTexCoord = (corner + 0.5) * aTextureView.zw + aTextureView.xy;
+}
+)glsl";
+
+const char *uniformVertexSource = R"glsl(
+#version 330 core
+const vec2[4] corners = vec2[4](
+  vec2(-0.5, -0.5), vec2(+0.5, -0.5), vec2(-0.5, +0.5), vec2(+0.5, +0.5)
+);
+
+uniform mat4 uTransform;
+uniform vec4 uTextureView;
+
+out vec4 sColor;
+out vec2 sTexCoord;
+
+void main() {
+  vec2 corner = corners[gl_VertexID];
+  gl_Position = uTransform * vec4(corner, 0.0, 1.0);
+  sColor = vec4(1.0);
+  sTexCoord = (corner + 0.5) * uTextureView.zw + uTextureView.xy;
+}
+)glsl";
+
+const char *fragmentSource = R"glsl(
+#version 330 core
+in vec4 sColor;
+in vec2 sTexCoord;
+
+out vec4 oColor;
+
+uniform sampler2D uTexture;
+
+void main() {
+  oColor = sColor * texture(uTexture, sTexCoord);
+  if(oColor.a == 0) discard;
+}
+)glsl";
+
+const char *tintedFragmentSource = R"glsl(
+#version 330 core
+in vec4 sColor;
+in vec2 sTexCoord;
+
+out vec4 oColor;
+
+uniform sampler2D uTexture;
+
+void main() {
+  oColor = sColor * texture(uTexture, sTexCoord).bgra;
+  if(oColor.a == 0) discard;
+}
+)glsl";
+
+const glm::ivec2 benchSize = {1280, 720};
+
+struct Options_ {
+  int frames = 200;
+  int warmupFrames = 10;
+  int threads = 0; // one per core
+  const char *image = "example/image.png";
+  const char *output = nullptr;
+  std::vector<std::string> scenes;
+};
+
+struct Bench_ {
+  gtamfx::Window &window;
+  const Options_ &options;
+  std::mt19937 random{1234};
+  std::vector<gtamfx::ShaderHandle> shaders;
+  std::vector<gtamfx::TextureHandle> textures;
+  std::vector<gtamfx::SpriteHandle> sprites;
+  std::vector<gtamfx::CameraHandle> cameras;
+  size_t texturesLoaded = 0;
+
+  float uniform(float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(random);
+  }
+  size_t index(size_t count) {
+    return std::uniform_int_distribution<size_t>(0, count - 1)(random);
+  }
+
+  gtamfx::ShaderHandle newShader(const char *vertex, const char *fragment) {
+    shaders.push_back(window.newShader(vertex, fragment, 4));
+    return shaders.back();
+  }
+
+  // sprites are spread over `worldScale` times the screen in each direction
+  float worldScale = 1;
+
+  gtamfx::SpriteHandle newSprite(gtamfx::TextureHandle texture,
+                                 gtamfx::ShaderHandle shader) {
+    gtamfx::SpriteHandle handle = window.newSprite(texture, shader);
+    gtamfx::Sprite *sprite = window.getSprite(handle);
+    sprite->position = {uniform(-0.5f, 0.5f) * benchSize.x * worldScale,
+                        uniform(-0.5f, 0.5f) * benchSize.y * worldScale,
+                        uniform(-1, 1)};
+    sprite->scale = {16, 16, 1};
+    sprite->rotation = glm::angleAxis(uniform(0, 6.28f), glm::vec3(0, 0, 1));
+    sprites.push_back(handle);
+    return handle;
+  }
+
+  // a few sprites move every frame, like in a game
+  void moveSprites(float fraction) {
+    const size_t count = sprites.size() * fraction;
+    for (size_t i = 0; i < count; ++i) {
+      gtamfx::Sprite *sprite = window.getSprite(sprites[index(sprites.size())]);
+      sprite->position.x += uniform(-4, 4);
+      sprite->position.y += uniform(-4, 4);
+    }
+  }
+};
+
+// one instanced shader and texture, only draw cost and sorting
+void setupSprites_(Bench_ &bench, size_t count) {
+  gtamfx::ShaderHandle shader =
+      bench.newShader(instancedVertexSource, fragmentSource);
+  bench.textures.push_back(bench.window.newTexture(bench.options.image));
+  for (size_t i = 0; i < count; ++i)
+    bench.newSprite(bench.textures[0], shader);
+}
+
+// two instanced shaders, a uniform one and several textures at random depths,
+// so batching depends on the sort
+void setupMixed_(Bench_ &bench) {
+  bench.newShader(instancedVertexSource, fragmentSource);
+  bench.newShader(instancedVertexSource, tintedFragmentSource);
+  gtamfx::ShaderHandle uniformShader =
+      bench.newShader(uniformVertexSource, fragmentSource);
+  for (int i = 0; i < 8; ++i)
+    bench.textures.push_back(bench.window.newTexture(bench.options.image));
+
+  for (size_t i = 0; i < 10000; ++i) {
+    gtamfx::TextureHandle texture =
+        bench.textures[bench.index(bench.textures.size())];
+    bench.newSprite(texture, i % 20 == 0 ? uniformShader
+                                         : bench.shaders[bench.index(2)]);
+  }
+}
+
+void churn_(Bench_ &bench) {
+  for (size_t i = 0; i < 1000; ++i) {
+    const size_t victim = bench.index(bench.sprites.size());
+    bench.window.delSprite(bench.sprites[victim]);
+    bench.sprites[victim] = bench.sprites.back();
+    bench.sprites.pop_back();
+  }
+  for (size_t i = 0; i < 1000; ++i)
+    bench.newSprite(bench.textures[0], bench.shaders[0]);
+}
+
+void setupCameras_(Bench_ &bench) {
+  setupSprites_(bench, 10000);
+  for (int i = 0; i < 16; ++i) {
+    bench.cameras.push_back(
+        bench.window.newCamera(gtamfx::CameraType::Orthographic));
+    gtamfx::Camera *camera = bench.window.getCamera(bench.cameras.back());
+    camera->position = {bench.uniform(-200, 200), bench.uniform(-200, 200), 0};
+  }
+}
+
+// a world much larger than the screen with a camera panning over it
+void setupLargeWorld_(Bench_ &bench) {
+  bench.worldScale = 10;
+  setupSprites_(bench, 100000);
+}
+
+void panCamera_(Bench_ &bench, int frame) {
+  gtamfx::Camera *camera =
+      bench.window.getCamera(bench.window.getActiveCamera());
+  camera->position.x = (frame % 200 - 100) * 16.0f;
+  bench.moveSprites(0.01f);
+}
+
+void switchCamera_(Bench_ &bench, int frame) {
+  gtamfx::CameraHandle handle = bench.cameras[frame % bench.cameras.size()];
+  bench.window.getCamera(handle)->position.x += 1;
+  bench.window.setActiveCamera(handle);
+  bench.moveSprites(0.01f);
+}
+
+// keeps a few async loads in flight and retextures sprites as they land
+void loadTextures_(Bench_ &bench, int frame) {
+  if (bench.window.getPendingTextureCount() < 8) {
+    bench.window.newTextureAsync(
+        bench.options.image,
+        [&bench](gtamfx::TextureHandle texture, bool loaded) {
+          if (!loaded)
+            return;
+          ++bench.texturesLoaded;
+          for (int i = 0; i < 16; ++i) {
+            gtamfx::Sprite *sprite = bench.window.getSprite(
+                bench.sprites[bench.index(bench.sprites.size())]);
+            sprite->texture.source = texture;
+          }
+          bench.textures.push_back(texture);
+        });
+  }
+
+  // old textures go away, sprites still using them are simply skipped
+  if (bench.textures.size() > 32) {
+    bench.window.delTexture(bench.textures[1]);
+    bench.textures.erase(bench.textures.begin() + 1);
+  }
+  (void)frame;
+}
+
+struct Scene_ {
+  const char *name;
+  void (*setup)(Bench_ &bench);
+  void (*step)(Bench_ &bench, int frame);
+};
+
+const Scene_ scenes_[] = {
+    {"sprites-1k", [](Bench_ &bench) { setupSprites_(bench, 1000); },
+     [](Bench_ &bench, int) { bench.moveSprites(0.01f); }},
+    {"sprites-10k", [](Bench_ &bench) { setupSprites_(bench, 10000); },
+     [](Bench_ &bench, int) { bench.moveSprites(0.01f); }},
+    {"sprites-100k", [](Bench_ &bench) { setupSprites_(bench, 100000); },
+     [](Bench_ &bench, int) { bench.moveSprites(0.01f); }},
+    {"mixed", setupMixed_,
+     [](Bench_ &bench, int) { bench.moveSprites(0.01f); }},
+    {"churn", [](Bench_ &bench) { setupSprites_(bench, 10000); },
+     [](Bench_ &bench, int) { churn_(bench); }},
+    {"cameras", setupCameras_, switchCamera_},
+    {"large-world", setupLargeWorld_, panCamera_},
+    {"texture-loading", [](Bench_ &bench) { setupSprites_(bench, 1000); },
+     loadTextures_},
+};
+
+struct Result_ {
+  std::string name;
+  std::string renderer;
+  size_t sprites = 0;
+  size_t texturesLoaded = 0;
+  size_t threads = 0;
+  std::vector<double> frameTimes; // ms
+  gtamfx::FrameStats total{};
+  gtamfx::StreamStats stream{}; // measured frames only
+};
+
+Result_ runScene_(const Scene_ &scene, const Options_ &options) {
+  gtamfx::Window window(benchSize, scene.name, true);
+  window.init();
+  window.setThreadCount(options.threads);
+
+  Result_ result;
+  result.name = scene.name;
+  result.threads = window.getThreadCount();
+  result.renderer = (const char *)glGetString(GL_RENDERER);
+  {
+    Bench_ bench{window, options};
+    window.setActiveCamera(window.newCamera(gtamfx::CameraType::Orthographic));
+    scene.setup(bench);
+
+    using Clock = std::chrono::steady_clock;
+    gtamfx::StreamStats streamStart{};
+    for (int frame = 0; frame < options.warmupFrames + options.frames;
+         ++frame) {
+      if (frame == options.warmupFrames)
+        streamStart = window.getStreamStats();
+      const Clock::time_point start = Clock::now();
+      scene.step(bench, frame);
+      window.update();
+      const Clock::time_point end = Clock::now();
+      // keeps the driver from queueing frames, their gpu time would otherwise
+      // show up in random later frames
+      glFinish();
+
+      if (frame < options.warmupFrames)
+        continue;
+      result.frameTimes.push_back(
+          std::chrono::duration<double, std::milli>(end - start).count());
+      const gtamfx::FrameStats &stats = window.getFrameStats();
+      result.total.drawCalls += stats.drawCalls;
+      result.total.programBinds += stats.programBinds;
+      result.total.textureBinds += stats.textureBinds;
+      result.total.spritesDrawn += stats.spritesDrawn;
+      result.total.spritesCulled += stats.spritesCulled;
+      result.total.stateChangesFiltered += stats.stateChangesFiltered;
+      result.total.cpuTime.sort += stats.cpuTime.sort;
+      result.total.cpuTime.cull += stats.cpuTime.cull;
+      result.total.cpuTime.transform += stats.cpuTime.transform;
+    }
+    result.stream = window.getStreamStats();
+    result.stream.bytesStreamed -= streamStart.bytesStreamed;
+    result.stream.fenceWaitTime -= streamStart.fenceWaitTime;
+    result.sprites = bench.sprites.size();
+    result.texturesLoaded = bench.texturesLoaded;
+  }
+
+  window.deinit();
+  return result;
+}
+
+// nearest rank on sorted times: the smallest one with at least p% of them
+// below or equal
+double percentile_(const std::vector<double> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  const size_t rank = (size_t)std::ceil(p * sorted.size() / 100);
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+// the driver picks the renderer string, so it may hold anything
+std::string jsonEscape_(const std::string &text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if ((unsigned char)c < 0x20) {
+      char code[7];
+      snprintf(code, sizeof(code), "\\u%04x", (unsigned)c);
+      escaped += code;
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+void writeJson_(FILE *file, const std::vector<Result_> &results,
+                const Options_ &options) {
+  fprintf(file, "{\n  \"renderer\": \"%s\",\n",
+          results.empty() ? "" : jsonEscape_(results[0].renderer).c_str());
+  fprintf(file, "  \"width\": %d,\n  \"height\": %d,\n", benchSize.x,
+          benchSize.y);
+  fprintf(file, "  \"threads\": %zu,\n",
+          results.empty() ? 0 : results[0].threads);
+  fprintf(file, "  \"frames\": %d,\n  \"scenes\": [", options.frames);
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result_ &result = results[i];
+    std::vector<double> sorted = result.frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    for (double time : sorted)
+      sum += time;
+    const double frames = std::max<size_t>(sorted.size(), 1);
+
+    fprintf(file, "%s\n    {\n", i ? "," : "");
+    fprintf(file, "      \"name\": \"%s\",\n", result.name.c_str());
+    fprintf(file, "      \"sprites\": %zu,\n", result.sprites);
+    fprintf(file,
+            "      \"frameTimeMs\": {\"mean\": %.4f, \"p50\": %.4f, "
+            "\"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+            sum / frames, percentile_(sorted, 50), percentile_(sorted, 90),
+            percentile_(sorted, 99), sorted.empty() ? 0 : sorted.back());
+    // the multithreaded part of a frame
+    fprintf(file, "      \"prepareMs\": %.4f,\n",
+            (result.total.cpuTime.sort + result.total.cpuTime.cull +
+             result.total.cpuTime.transform) /
+                frames);
+    fprintf(file, "      \"drawCallsPerFrame\": %.2f,\n",
+            result.total.drawCalls / frames);
+    fprintf(file, "      \"stateChangesPerFrame\": %.2f,\n",
+            (result.total.programBinds + result.total.textureBinds) / frames);
+    fprintf(file, "      \"programBindsPerFrame\": %.2f,\n",
+            result.total.programBinds / frames);
+    fprintf(file, "      \"textureBindsPerFrame\": %.2f,\n",
+            result.total.textureBinds / frames);
+    fprintf(file, "      \"spritesDrawnPerFrame\": %.2f,\n",
+            result.total.spritesDrawn / frames);
+    fprintf(file, "      \"spritesCulledPerFrame\": %.2f,\n",
+            result.total.spritesCulled / frames);
+    fprintf(file, "      \"stateChangesFilteredPerFrame\": %.2f,\n",
+            result.total.stateChangesFiltered / frames);
+    fprintf(file, "      \"streamedBytesPerFrame\": %.0f,\n",
+            result.stream.bytesStreamed / frames);
+    fprintf(file, "      \"fenceWaitMsPerFrame\": %.4f,\n",
+            result.stream.fenceWaitTime / frames);
+    fprintf(file, "      \"texturesLoaded\": %zu\n    }",
+            result.texturesLoaded);
+  }
+  fprintf(file, "\n  ]\n}\n");
+}
+
+void usage_(const char *program) {
+  fprintf(stderr,
+          "usage: %s [-f frames] [-w warmup frames] [-t threads] [-i image] "
+          "[-o file] [scene...]\nscenes:",
+          program);
+  for (const Scene_ &scene : scenes_)
+    fprintf(stderr, " %s", scene.name);
+  fputc('\n', stderr);
+}
+
+// threads of the process, 0 where /proc doesn't tell
+size_t threadCount_() {
+  size_t count = 0;
+#ifdef __linux__
+  if (FILE *status = fopen("/proc/self/status", "r")) {
+    char line[256];
+    while (fgets(line, sizeof(line), status))
+      if (sscanf(line, "Threads: %zu", &count) == 1)
+        break;
+    fclose(status);
+  }
+#endif
+  return count;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  Options_ options;
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "-f") && hasValue)
+      options.frames = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-w") && hasValue)
+      options.warmupFrames = std::max(0, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-t") && hasValue)
+      options.threads = std::max(0, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-i") && hasValue)
+      options.image = argv[++i];
+    else if (!strcmp(argv[i], "-o") && hasValue)
+      options.output = argv[++i];
+    else if (argv[i][0] == '-') {
+      usage_(argv[0]);
+      return 1;
+    } else
+      options.scenes.push_back(argv[i]);
+  }
+
+  std::vector<const Scene_ *> selected;
+  for (const Scene_ &scene : scenes_) {
+    if (options.scenes.empty() ||
+        std::find(options.scenes.begin(), options.scenes.end(), scene.name) !=
+            options.scenes.end())
+      selected.push_back(&scene);
+  }
+  if (selected.size() < std::max<size_t>(options.scenes.size(), 1)) {
+    usage_(argv[0]);
+    return 1;
+  }
+
+  std::vector<Result_> results;
+  try {
+    // every scene has to leave the process as it found it, or the ones after
+    // it are measured next to its threads. The driver may keep threads of its
+    // own after the first context, so the count after the first scene is kept
+    size_t threads = 0;
+    for (const Scene_ *scene : selected) {
+      fprintf(stderr, "running %s...\n", scene->name);
+      results.push_back(runScene_(*scene, options));
+      const size_t left = threadCount_();
+      if (threads && left > threads)
+        fprintf(stderr, "warning: %s left %zu threads running\n", scene->name,
+                left - threads);
+      threads = std::max(threads, left);
+    }
+  } catch (gtamfx::Exception e) {
+    fprintf(stderr, "Error: %s\n", e.message.c_str());
+    return 1;
+  }
+
+  FILE *file = options.output ? fopen(options.output, "w") : stdout;
+  if (!file) {
+    perror(options.output);
+    return 1;
+  }
+  writeJson_(file, results, options);
+  if (file != stdout)
+    fclose(file);
+}
@@ -1,51 +1,274 @@
 #include <gtamfx.hpp>
 #include <cgtamfx.h>
+#include <cstring>
 
-struct GtamWindow_T { gtamfx::Window v; };
+struct Error_ {
+  int code;
+  std::string message;
+};
+
+struct GtamWindow_T { gtamfx::Window v; Error_ error{}; };
 // struct GtamTexture_T { gtamfx::Texture v; };
 // struct GtamSprite_T { gtamfx::Sprite v; };
 // struct GtamShader_T { gtamfx::Shader v; };
 // struct GtamCamera_T { gtamfx::Camera v; };
 
-#define E(CODE) try { CODE; } catch(gtamfx::Exception e) { error_.code = (int)e.type; error_.message = e.message; }
+// Every call going through E(window, ) sets the error of its window, if it has one, and
+// the one of the calling thread, so windows used from different threads don't
+// see each other's errors.
+#define E(WINDOW, CODE) try { clearError(WINDOW); CODE; } catch(gtamfx::Exception e) { setError(WINDOW, e); }
 
-static struct {
-  int code;
-  std::string message;
-} error_;
+static thread_local Error_ error_;
+
+static inline void clearError(GtamWindow *window) {
+  if (error_.code) error_ = {};
+  if (window && window->error.code) window->error = {};
+}
+static inline void setError(GtamWindow *window, const gtamfx::Exception &e) {
+  error_ = {(int)e.type, e.message};
+  if (window) window->error = error_;
+}
 
 template<typename T, typename U> static inline void write2(T *v, U w) { v->x = w.x; v->y = w.y; }
 template<typename T, typename U> static inline void write3(T *v, U w) { v->x = w.x; v->y = w.y; v->z = w.z; }
+template<typename T, typename U> static inline T handle(U h) { return T{h.index, h.generation}; }
+// sprite i gets `width` floats from `values + i * stride` bytes at `offset`
+static inline size_t writeSpriteFields(GtamWindow *window, const GtamSpriteHandle *sprites, size_t count, const float *values, size_t stride,
+                                       size_t offset, size_t width) {
+  const char *bytes = (const char*)values;
+  stride = stride ? stride : width * sizeof(float);
+  size_t written = 0;
+  for (size_t i = 0; i < count; ++i) {
+    gtamfx::Sprite *sprite = window->v.getSprite(handle<gtamfx::SpriteHandle>(sprites[i]));
+    if (!sprite) continue;
+    std::memcpy((char*)sprite + offset, bytes + i * stride, width * sizeof(float));
+    ++written;
+  }
+  return written;
+}
+static inline size_t writeSprites(const std::vector<gtamfx::SpriteHandle> &v, GtamSpriteHandle *sprites, size_t capacity) {
+  for (size_t i = 0; i < v.size() && i < capacity; ++i) sprites[i] = handle<GtamSpriteHandle>(v[i]);
+  return v.size();
+}
+
+static_assert(sizeof(GtamSpriteHandle) == sizeof(gtamfx::SpriteHandle), "GtamSpriteHandle must mirror gtamfx::SpriteHandle");
+static_assert(sizeof(GtamFrameStats) == sizeof(gtamfx::FrameStats), "GtamFrameStats must mirror gtamfx::FrameStats");
+static_assert(sizeof(GtamTilemap) == sizeof(gtamfx::Tilemap), "GtamTilemap must mirror gtamfx::Tilemap");
+static_assert(sizeof(GtamPack) == sizeof(gtamfx::Pack), "GtamPack must mirror gtamfx::Pack");
+static_assert(sizeof(GtamFont) == sizeof(gtamfx::Font), "GtamFont must mirror gtamfx::Font");
+static_assert(sizeof(GtamText) == sizeof(gtamfx::Text), "GtamText must mirror gtamfx::Text");
+static_assert(sizeof(GtamParticleEmitter) == sizeof(gtamfx::ParticleEmitter), "GtamParticleEmitter must mirror gtamfx::ParticleEmitter");
 
 extern "C" {
 
 EXPORT int gtamGetError(void) { return error_.code; }
 EXPORT const char *gtamGetErrorMessage(void) { return error_.code ? error_.message.c_str() : NULL; }
-EXPORT GtamWindow *gtamCreateWindow(GtamVec2i size, const char *title) { E(return new GtamWindow { gtamfx::Window({size.x, size.y}, title) }); return NULL; }
+EXPORT int gtamWindowGetError(const GtamWindow *window) { return window->error.code; }
+EXPORT const char *gtamWindowGetErrorMessage(const GtamWindow *window) { return window->error.code ? window->error.message.c_str() : NULL; }
+EXPORT GtamWindow *gtamCreateWindow(GtamVec2i size, const char *title) { E(nullptr, return new GtamWindow { gtamfx::Window({size.x, size.y}, title) }); return NULL; }
+EXPORT GtamWindow *gtamCreateHeadlessWindow(GtamVec2i size) { E(nullptr, return new GtamWindow { gtamfx::Window({size.x, size.y}, "", true) }); return NULL; }
 EXPORT void gtamDestroyWindow(GtamWindow *window) { delete window; }
-EXPORT void gtamInitWindow(GtamWindow *window) { E(window->v.init()); }
+EXPORT void gtamInitWindow(GtamWindow *window) { E(window, window->v.init()); }
 EXPORT int gtamWindowShouldClose(const GtamWindow *window) { return window->v.shouldClose(); }
 EXPORT void gtamCloseWindow(GtamWindow *window) { window->v.close(); }
 EXPORT void gtamUncloseWindow(GtamWindow *window) { window->v.unclose(); }
-EXPORT void gtamUpdateWindow(GtamWindow *window, int depth) { E(window->v.update(depth)); }
-EXPORT void gtamDeinitWindow(GtamWindow *window) { E(window->v.deinit()); }
+EXPORT void gtamUpdateWindow(GtamWindow *window, int depth) { E(window, window->v.update(depth)); }
+EXPORT void gtamDeinitWindow(GtamWindow *window) { E(window, window->v.deinit()); }
 EXPORT float gtamWindowGetTime(GtamWindow *window) { return window->v.getTime(); }
 EXPORT int gtamWindowIsKeyDown(GtamWindow *window, int keycode) { return window->v.isKeyDown((gtamfx::KeyCode)keycode); }
 EXPORT int gtamWindowIsMouseDown(GtamWindow *window, int button) { return window->v.isMouseDown(button); }
 EXPORT void gtamWindowGetMousePosition(GtamWindow *window, GtamVec2 *position) { write2(position, window->v.getMousePosition()); }
-EXPORT GtamTexture *gtamWindowNewTexture(GtamWindow *window, const char *path) { E(return (GtamTexture*)window->v.newTexture(path)); return NULL; }
-EXPORT void gtamWindowDelTexture(GtamWindow *window, GtamTexture *texture) { window->v.delTexture((gtamfx::Texture*)texture); }
-EXPORT GtamShader *gtamWindowNewShader(GtamWindow *window, const char *vertex, const char *fragment, size_t vertexCount)
-  { E(return (GtamShader*)window->v.newShader(vertex, fragment, vertexCount)); return NULL; }
-EXPORT void gtamWindowDelShader(GtamWindow *window, GtamShader *shader) { E(window->v.delShader((gtamfx::Shader*)shader)); }
-EXPORT GtamSprite *gtamWindowNewSprite(GtamWindow *window, GtamTexture *texture, GtamShader *shader)
-  { E(return (GtamSprite*)window->v.newSprite((gtamfx::Texture*)texture, (gtamfx::Shader*)shader)); return NULL; }
-EXPORT void gtamWindowDelSprite(GtamWindow *window, GtamSprite *sprite) { E(window->v.delSprite((gtamfx::Sprite*)sprite)); }
-EXPORT GtamCamera *gtamWindowNewCamera(GtamWindow *window, int type) { E(return (GtamCamera*)window->v.newCamera((gtamfx::CameraType)type)); return NULL; }
-EXPORT void gtamWindowDelCamera(GtamWindow *window, GtamCamera *camera) { E(window->v.delCamera((gtamfx::Camera*)camera)); }
-EXPORT void gtamWindowSetActiveCamera(GtamWindow *window, GtamCamera *camera) { window->v.setActiveCamera((gtamfx::Camera*)camera); }
-EXPORT GtamCamera *gtamWindowGetActiveCamera(const GtamWindow *window) { return (GtamCamera*)window->v.getActiveCamera(); }
+EXPORT void gtamWindowSetAtlasOptions(GtamWindow *window, const GtamAtlasOptions *options)
+  { window->v.setAtlasOptions({options->enabled != 0, options->pageSize, options->maxImageSize, options->padding}); }
+EXPORT void gtamWindowGetAtlasStats(const GtamWindow *window, GtamAtlasStats *stats) {
+  gtamfx::AtlasStats v = window->v.getAtlasStats();
+  *stats = {v.pageCount, v.imageCount, v.usedPixels, v.totalPixels};
+}
+EXPORT GtamTextureHandle gtamWindowNewTexture(GtamWindow *window, const char *path)
+  { E(window, return handle<GtamTextureHandle>(window->v.newTexture(path))); return {}; }
+EXPORT GtamTextureHandle gtamWindowNewTextureAsync(GtamWindow *window, const char *path, GtamTextureCallback callback, void *user) {
+  gtamfx::TextureCallback wrapped;
+  if (callback)
+    wrapped = [callback, user](gtamfx::TextureHandle texture, bool loaded) { callback(handle<GtamTextureHandle>(texture), loaded, user); };
+  E(window, return handle<GtamTextureHandle>(window->v.newTextureAsync(path, std::move(wrapped)))); return {};
+}
+EXPORT void gtamWindowSetTextureUploadBudget(GtamWindow *window, size_t bytesPerFrame) { window->v.setTextureUploadBudget(bytesPerFrame); }
+EXPORT size_t gtamWindowGetPendingTextureCount(const GtamWindow *window) { return window->v.getPendingTextureCount(); }
+EXPORT void gtamWindowSetTextureBudget(GtamWindow *window, size_t bytes) { window->v.setTextureBudget(bytes); }
+EXPORT void gtamWindowGetTextureResidencyStats(const GtamWindow *window, GtamTextureResidencyStats *stats) {
+  gtamfx::TextureResidencyStats v = window->v.getTextureResidencyStats();
+  *stats = {v.budget, v.residentBytes, v.residentCount, v.evictedCount, v.evictions, v.reloads};
+}
+EXPORT void gtamWindowDelTexture(GtamWindow *window, GtamTextureHandle texture) { window->v.delTexture(handle<gtamfx::TextureHandle>(texture)); }
+EXPORT GtamTexture *gtamWindowGetTexture(GtamWindow *window, GtamTextureHandle texture)
+  { return (GtamTexture*)window->v.getTexture(handle<gtamfx::TextureHandle>(texture)); }
+EXPORT GtamShaderHandle gtamWindowNewShader(GtamWindow *window, const char *vertex, const char *fragment, size_t vertexCount)
+  { E(window, return handle<GtamShaderHandle>(window->v.newShader(vertex, fragment, vertexCount))); return {}; }
+EXPORT void gtamWindowDelShader(GtamWindow *window, GtamShaderHandle shader) { E(window, window->v.delShader(handle<gtamfx::ShaderHandle>(shader))); }
+EXPORT void gtamWindowSetProgramCacheDirectory(GtamWindow *window, const char *path) { window->v.setProgramCacheDirectory(path); }
+EXPORT void gtamWindowGetProgramCacheStats(const GtamWindow *window, GtamProgramCacheStats *stats) {
+  gtamfx::ProgramCacheStats v = window->v.getProgramCacheStats();
+  *stats = {v.hits, v.misses, v.rejected, v.stored};
+}
+EXPORT GtamShader *gtamWindowGetShader(GtamWindow *window, GtamShaderHandle shader)
+  { return (GtamShader*)window->v.getShader(handle<gtamfx::ShaderHandle>(shader)); }
+EXPORT size_t gtamWindowGetShaderUniformCount(const GtamWindow *window, GtamShaderHandle shader) {
+  const auto *v = window->v.getShaderUniforms(handle<gtamfx::ShaderHandle>(shader));
+  return v ? v->size() : 0;
+}
+EXPORT int gtamWindowGetShaderUniform(const GtamWindow *window, GtamShaderHandle shader, size_t index, GtamShaderUniform *uniform) {
+  const auto *v = window->v.getShaderUniforms(handle<gtamfx::ShaderHandle>(shader));
+  if (!v || index >= v->size()) return 0;
+  const gtamfx::ShaderUniform &u = (*v)[index];
+  *uniform = {u.name.c_str(), u.type, u.size, u.location, u.block};
+  return 1;
+}
+EXPORT size_t gtamWindowGetShaderUniformBlockCount(const GtamWindow *window, GtamShaderHandle shader) {
+  const auto *v = window->v.getShaderUniformBlocks(handle<gtamfx::ShaderHandle>(shader));
+  return v ? v->size() : 0;
+}
+EXPORT int gtamWindowGetShaderUniformBlock(const GtamWindow *window, GtamShaderHandle shader, size_t index, GtamShaderUniformBlock *block) {
+  const auto *v = window->v.getShaderUniformBlocks(handle<gtamfx::ShaderHandle>(shader));
+  if (!v || index >= v->size()) return 0;
+  const gtamfx::ShaderUniformBlock &b = (*v)[index];
+  *block = {b.name.c_str(), b.size, b.binding};
+  return 1;
+}
+EXPORT int gtamWindowSetShaderParameter(GtamWindow *window, GtamShaderHandle shader, const char *name, const float *values, size_t count)
+  { return window->v.setShaderParameter(handle<gtamfx::ShaderHandle>(shader), name, values, count); }
+EXPORT int gtamWindowSetShaderParameterInt(GtamWindow *window, GtamShaderHandle shader, const char *name, const int *values, size_t count)
+  { return window->v.setShaderParameter(handle<gtamfx::ShaderHandle>(shader), name, values, count); }
+EXPORT GtamSpriteHandle gtamWindowNewSprite(GtamWindow *window, GtamTextureHandle texture, GtamShaderHandle shader)
+  { E(window, return handle<GtamSpriteHandle>(window->v.newSprite(handle<gtamfx::TextureHandle>(texture), handle<gtamfx::ShaderHandle>(shader)))); return {}; }
+EXPORT void gtamWindowDelSprite(GtamWindow *window, GtamSpriteHandle sprite) { E(window, window->v.delSprite(handle<gtamfx::SpriteHandle>(sprite))); }
+EXPORT GtamSprite *gtamWindowGetSprite(GtamWindow *window, GtamSpriteHandle sprite)
+  { return (GtamSprite*)window->v.getSprite(handle<gtamfx::SpriteHandle>(sprite)); }
+EXPORT size_t gtamWindowNewSprites(GtamWindow *window, GtamTextureHandle texture, GtamShaderHandle shader, size_t count, GtamSpriteHandle *sprites) {
+  E(window, window->v.newSprites(handle<gtamfx::TextureHandle>(texture), handle<gtamfx::ShaderHandle>(shader), count, (gtamfx::SpriteHandle*)sprites); return count);
+  return 0;
+}
+EXPORT void gtamWindowDelSprites(GtamWindow *window, const GtamSpriteHandle *sprites, size_t count)
+  { E(window, window->v.delSprites((const gtamfx::SpriteHandle*)sprites, count)); }
+EXPORT size_t gtamWindowSetSpritePositions(GtamWindow *window, const GtamSpriteHandle *sprites, size_t count, const float *values, size_t stride)
+  { return writeSpriteFields(window, sprites, count, values, stride, offsetof(gtamfx::Sprite, position), 3); }
+EXPORT size_t gtamWindowSetSpriteScales(GtamWindow *window, const GtamSpriteHandle *sprites, size_t count, const float *values, size_t stride)
+  { return writeSpriteFields(window, sprites, count, values, stride, offsetof(gtamfx::Sprite, scale), 3); }
+EXPORT size_t gtamWindowSetSpriteRotations(GtamWindow *window, const GtamSpriteHandle *sprites, size_t count, const float *values, size_t stride)
+  { return writeSpriteFields(window, sprites, count, values, stride, offsetof(gtamfx::Sprite, rotation), 4); }
+EXPORT size_t gtamWindowSetSpriteColors(GtamWindow *window, const GtamSpriteHandle *sprites, size_t count, const float *values, size_t stride)
+  { return writeSpriteFields(window, sprites, count, values, stride, offsetof(gtamfx::Sprite, color), 4); }
+EXPORT size_t gtamWindowSetSpriteTextureViews(GtamWindow *window, const GtamSpriteHandle *sprites, size_t count, const float *values, size_t stride)
+  { return writeSpriteFields(window, sprites, count, values, stride, offsetof(gtamfx::Sprite, texture), 4); }
+EXPORT GtamSpriteBatchHandle gtamWindowNewSpriteBatch(GtamWindow *window, GtamTextureHandle texture, GtamShaderHandle shader, size_t count)
+  { E(window, return handle<GtamSpriteBatchHandle>(window->v.newSpriteBatch(handle<gtamfx::TextureHandle>(texture), handle<gtamfx::ShaderHandle>(shader), count))); return {}; }
+EXPORT void gtamWindowDelSpriteBatch(GtamWindow *window, GtamSpriteBatchHandle batch) { E(window, window->v.delSpriteBatch(handle<gtamfx::SpriteBatchHandle>(batch))); }
+EXPORT int gtamWindowGetSpriteBatch(GtamWindow *window, GtamSpriteBatchHandle batch, GtamSpriteBatch *arrays) {
+  gtamfx::SpriteBatch *v = window->v.getSpriteBatch(handle<gtamfx::SpriteBatchHandle>(batch));
+  if (!v) return 0;
+  *arrays = {v->sprites.size(), (const GtamSpriteHandle*)v->sprites.data(), (GtamVec3*)v->positions.data(), (GtamVec3*)v->scales.data(),
+             (GtamQuat*)v->rotations.data(), (GtamVec4*)v->colors.data(), (GtamVec4*)v->textureViews.data()};
+  return 1;
+}
+EXPORT void gtamWindowResizeSpriteBatch(GtamWindow *window, GtamSpriteBatchHandle batch, size_t count) { E(window, window->v.resizeSpriteBatch(handle<gtamfx::SpriteBatchHandle>(batch), count)); }
+EXPORT GtamTilemapHandle gtamWindowNewTilemap(GtamWindow *window, GtamTextureHandle texture, GtamShaderHandle shader, GtamVec2i size, GtamVec2i atlasSize, size_t layerCount) {
+  E(window, return handle<GtamTilemapHandle>(window->v.newTilemap(handle<gtamfx::TextureHandle>(texture), handle<gtamfx::ShaderHandle>(shader),
+                                                                  {size.x, size.y}, {atlasSize.x, atlasSize.y}, layerCount)));
+  return {};
+}
+EXPORT void gtamWindowDelTilemap(GtamWindow *window, GtamTilemapHandle tilemap) { window->v.delTilemap(handle<gtamfx::TilemapHandle>(tilemap)); }
+EXPORT GtamTilemap *gtamWindowGetTilemap(GtamWindow *window, GtamTilemapHandle tilemap)
+  { return (GtamTilemap*)window->v.getTilemap(handle<gtamfx::TilemapHandle>(tilemap)); }
+EXPORT size_t gtamWindowGetTilemapLayerCount(const GtamWindow *window, GtamTilemapHandle tilemap)
+  { return window->v.getTilemapLayerCount(handle<gtamfx::TilemapHandle>(tilemap)); }
+EXPORT void gtamWindowSetTile(GtamWindow *window, GtamTilemapHandle tilemap, size_t layer, GtamVec2i tile, uint16_t value)
+  { E(window, window->v.setTile(handle<gtamfx::TilemapHandle>(tilemap), layer, {tile.x, tile.y}, value)); }
+EXPORT uint16_t gtamWindowGetTile(const GtamWindow *window, GtamTilemapHandle tilemap, size_t layer, GtamVec2i tile)
+  { return window->v.getTile(handle<gtamfx::TilemapHandle>(tilemap), layer, {tile.x, tile.y}); }
+EXPORT void gtamWindowSetTiles(GtamWindow *window, GtamTilemapHandle tilemap, size_t layer, GtamVec2i origin, GtamVec2i size, const uint16_t *tiles)
+  { E(window, window->v.setTiles(handle<gtamfx::TilemapHandle>(tilemap), layer, {origin.x, origin.y}, {size.x, size.y}, tiles)); }
+EXPORT void gtamWindowSetTilemapLayerDepth(GtamWindow *window, GtamTilemapHandle tilemap, size_t layer, float depth)
+  { E(window, window->v.setTilemapLayerDepth(handle<gtamfx::TilemapHandle>(tilemap), layer, depth)); }
+EXPORT float gtamWindowGetTilemapLayerDepth(const GtamWindow *window, GtamTilemapHandle tilemap, size_t layer)
+  { return window->v.getTilemapLayerDepth(handle<gtamfx::TilemapHandle>(tilemap), layer); }
+EXPORT GtamPackHandle gtamWindowLoadPack(GtamWindow *window, const char *path)
+  { E(window, return handle<GtamPackHandle>(window->v.loadPack(path))); return {}; }
+EXPORT void gtamWindowUnloadPack(GtamWindow *window, GtamPackHandle pack) { window->v.unloadPack(handle<gtamfx::PackHandle>(pack)); }
+EXPORT const GtamPack *gtamWindowGetPack(const GtamWindow *window, GtamPackHandle pack)
+  { return (const GtamPack*)window->v.getPack(handle<gtamfx::PackHandle>(pack)); }
+EXPORT GtamTextureHandle gtamWindowNewTextureFromPack(GtamWindow *window, GtamPackHandle pack, const char *name)
+  { E(window, return handle<GtamTextureHandle>(window->v.newTextureFromPack(handle<gtamfx::PackHandle>(pack), name))); return {}; }
+EXPORT GtamShaderHandle gtamWindowNewShaderFromPack(GtamWindow *window, GtamPackHandle pack, const char *name, size_t vertexCount)
+  { E(window, return handle<GtamShaderHandle>(window->v.newShaderFromPack(handle<gtamfx::PackHandle>(pack), name, vertexCount))); return {}; }
+EXPORT GtamFontHandle gtamWindowNewFont(GtamWindow *window, const char *path, int glyphSize) {
+  E(window, return handle<GtamFontHandle>(window->v.newFont(path, glyphSize)));
+  return {};
+}
+EXPORT void gtamWindowDelFont(GtamWindow *window, GtamFontHandle font) { window->v.delFont(handle<gtamfx::FontHandle>(font)); }
+EXPORT const GtamFont *gtamWindowGetFont(const GtamWindow *window, GtamFontHandle font)
+  { return (const GtamFont*)window->v.getFont(handle<gtamfx::FontHandle>(font)); }
+EXPORT void gtamWindowSetFontCacheDirectory(GtamWindow *window, const char *path) { window->v.setFontCacheDirectory(path); }
+EXPORT GtamTextHandle gtamWindowNewText(GtamWindow *window, GtamFontHandle font, GtamShaderHandle shader, const char *string) {
+  E(window, return handle<GtamTextHandle>(window->v.newText(handle<gtamfx::FontHandle>(font), handle<gtamfx::ShaderHandle>(shader), string)));
+  return {};
+}
+EXPORT void gtamWindowDelText(GtamWindow *window, GtamTextHandle text) { window->v.delText(handle<gtamfx::TextHandle>(text)); }
+EXPORT GtamText *gtamWindowGetText(GtamWindow *window, GtamTextHandle text)
+  { return (GtamText*)window->v.getText(handle<gtamfx::TextHandle>(text)); }
+EXPORT void gtamWindowSetTextString(GtamWindow *window, GtamTextHandle text, const char *string)
+  { E(window, window->v.setTextString(handle<gtamfx::TextHandle>(text), string)); }
+EXPORT const char *gtamWindowGetTextString(const GtamWindow *window, GtamTextHandle text)
+  { return window->v.getTextString(handle<gtamfx::TextHandle>(text)); }
+EXPORT void gtamWindowGetTextExtent(GtamWindow *window, GtamTextHandle text, GtamVec2 *extent)
+  { write2(extent, window->v.getTextExtent(handle<gtamfx::TextHandle>(text))); }
+
+EXPORT GtamParticleEmitterHandle gtamWindowNewParticleEmitter(GtamWindow *window, GtamTextureHandle texture, GtamShaderHandle shader, size_t capacity) {
+  E(window, return handle<GtamParticleEmitterHandle>(window->v.newParticleEmitter(handle<gtamfx::TextureHandle>(texture), handle<gtamfx::ShaderHandle>(shader), capacity)));
+  return {};
+}
+EXPORT void gtamWindowDelParticleEmitter(GtamWindow *window, GtamParticleEmitterHandle emitter) { window->v.delParticleEmitter(handle<gtamfx::ParticleEmitterHandle>(emitter)); }
+EXPORT GtamParticleEmitter *gtamWindowGetParticleEmitter(GtamWindow *window, GtamParticleEmitterHandle emitter)
+  { return (GtamParticleEmitter*)window->v.getParticleEmitter(handle<gtamfx::ParticleEmitterHandle>(emitter)); }
+EXPORT size_t gtamWindowGetParticleEmitterCapacity(const GtamWindow *window, GtamParticleEmitterHandle emitter)
+  { return window->v.getParticleEmitterCapacity(handle<gtamfx::ParticleEmitterHandle>(emitter)); }
+EXPORT void gtamWindowEmitParticles(GtamWindow *window, GtamParticleEmitterHandle emitter, size_t count)
+  { E(window, window->v.emitParticles(handle<gtamfx::ParticleEmitterHandle>(emitter), count)); }
+EXPORT void gtamWindowSetParticleTimeStep(GtamWindow *window, float seconds) { window->v.setParticleTimeStep(seconds); }
+EXPORT GtamCameraHandle gtamWindowNewCamera(GtamWindow *window, int type) { E(window, return handle<GtamCameraHandle>(window->v.newCamera((gtamfx::CameraType)type))); return {}; }
+EXPORT void gtamWindowDelCamera(GtamWindow *window, GtamCameraHandle camera) { E(window, window->v.delCamera(handle<gtamfx::CameraHandle>(camera))); }
+EXPORT GtamCamera *gtamWindowGetCamera(GtamWindow *window, GtamCameraHandle camera)
+  { return (GtamCamera*)window->v.getCamera(handle<gtamfx::CameraHandle>(camera)); }
+EXPORT void gtamWindowSetActiveCamera(GtamWindow *window, GtamCameraHandle camera) { window->v.setActiveCamera(handle<gtamfx::CameraHandle>(camera)); }
+EXPORT GtamCameraHandle gtamWindowGetActiveCamera(const GtamWindow *window) { return handle<GtamCameraHandle>(window->v.getActiveCamera()); }
+EXPORT void gtamWindowSetCulling(GtamWindow *window, int enabled) { window->v.setCulling(enabled); }
+EXPORT void gtamWindowSetThreadCount(GtamWindow *window, size_t threads) { window->v.setThreadCount(threads); }
+EXPORT size_t gtamWindowGetThreadCount(const GtamWindow *window) { return window->v.getThreadCount(); }
+EXPORT void gtamWindowSetGlDebugMode(GtamWindow *window, int mode) { window->v.setGlDebugMode((gtamfx::GlDebugMode)mode); }
+EXPORT int gtamWindowGetGlDebugMode(const GtamWindow *window) { return (int)window->v.getGlDebugMode(); }
+EXPORT void gtamWindowSetGlDebugCallback(GtamWindow *window, GtamGlDebugCallback callback, void *user) {
+  gtamfx::GlDebugCallback wrapped;
+  if (callback)
+    wrapped = [callback, user](const gtamfx::GlDebugMessage &m) {
+      const GtamGlDebugMessage message = {m.source, m.type, m.id, (int)m.severity, m.text};
+      callback(&message, user);
+    };
+  window->v.setGlDebugCallback(std::move(wrapped));
+}
+EXPORT size_t gtamWindowGetSpritesInRect(GtamWindow *window, GtamVec2 min, GtamVec2 max, GtamSpriteHandle *sprites, size_t capacity)
+  { return writeSprites(window->v.getSpritesInRect({min.x, min.y}, {max.x, max.y}), sprites, capacity); }
+EXPORT size_t gtamWindowGetSpritesAtPoint(GtamWindow *window, GtamVec2 point, GtamSpriteHandle *sprites, size_t capacity)
+  { return writeSprites(window->v.getSpritesAtPoint({point.x, point.y}), sprites, capacity); }
+EXPORT void gtamWindowScreenToWorld(GtamWindow *window, GtamVec2 position, GtamVec2 *world) { E(window, write2(world, window->v.screenToWorld({position.x, position.y}))); }
 EXPORT void gtamWindowGetFramebufferSize(const GtamWindow *window, GtamVec2 *framebufferSize) { write2(framebufferSize, window->v.getFramebufferSize()); }
 EXPORT float gtamWindowGetAspectRatio(const GtamWindow *window) { return window->v.getAspectRatio(); }
+EXPORT void gtamWindowGetFrameStats(const GtamWindow *window, GtamFrameStats *stats) { std::memcpy(stats, &window->v.getFrameStats(), sizeof(*stats)); }
+EXPORT size_t gtamWindowGetFrameStatsHistory(const GtamWindow *window, GtamFrameStats *stats, size_t count)
+  { return window->v.getFrameStatsHistory((gtamfx::FrameStats*)stats, count); }
+EXPORT void gtamWindowGetStreamStats(const GtamWindow *window, GtamStreamStats *stats) {
+  gtamfx::StreamStats v = window->v.getStreamStats();
+  *stats = {v.persistent, v.capacity, v.bytesStreamed, v.allocations, v.reallocations, v.fenceWaits, v.fenceWaitTime};
+}
+EXPORT void gtamWindowSetFrameStatsHistorySize(GtamWindow *window, size_t frames) { window->v.setFrameStatsHistorySize(frames); }
+EXPORT int gtamWindowIsHeadless(const GtamWindow *window) { return window->v.isHeadless(); }
+EXPORT void gtamWindowReadPixels(GtamWindow *window, void *pixels) { window->v.readPixels(pixels); }
 
 }
@@ -0,0 +1,383 @@
+#include "font.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+extern "C" {
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+}
+
+namespace gtamfx {
+namespace {
+// bump when the rendering of the glyphs changes
+constexpr uint32_t cacheVersion_ = 1;
+constexpr char cacheMagic_[4] = {'G', 'T', 'S', 'F'};
+
+struct CacheHeader_ {
+  char magic[4];
+  uint32_t version;
+  uint32_t glyphSize;
+  uint32_t count;
+  uint64_t dataSize; // of the font file
+};
+
+// followed by width * height pixels
+struct CacheGlyph_ {
+  int32_t index;
+  int16_t width, height;
+  int16_t x, y;
+};
+
+// anything bigger is a broken file
+constexpr int maxBitmapSize_ = 1024;
+
+// distance field value on the outline
+constexpr unsigned char edgeValue_ = 128;
+
+// FNV-1a
+uint64_t hash_(const void *data, size_t size, uint64_t hash) {
+  for (size_t i = 0; i < size; ++i)
+    hash = (hash ^ ((const unsigned char *)data)[i]) * 0x100000001b3;
+  return hash;
+}
+
+uint16_t normalized_(float value) {
+  return (uint16_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 65535);
+}
+
+// Codepoint starting at byte `i`, which is moved past it. Malformed sequences
+// read as U+FFFD one byte at a time.
+uint32_t decodeUtf8_(std::string_view text, size_t &i) {
+  const unsigned char first = text[i++];
+  if (first < 0x80)
+    return first;
+  if (first < 0xc0 || first >= 0xf8)
+    return 0xfffd;
+
+  const int length = first >= 0xf0 ? 3 : first >= 0xe0 ? 2 : 1;
+  uint32_t codepoint = first & (0x3f >> length);
+  for (int k = 0; k < length; ++k) {
+    if (i >= text.size() || ((unsigned char)text[i] & 0xc0) != 0x80)
+      return 0xfffd;
+    codepoint = codepoint << 6 | ((unsigned char)text[i++] & 0x3f);
+  }
+  return codepoint;
+}
+} // namespace
+
+FontFace::FontFace(const char *path, int glyphSize,
+                   const std::string &cacheDirectory)
+    : glyphSize_(std::clamp(glyphSize, 8, 256)),
+      spread_(std::max(glyphSize_ / 8, 2)) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    throw Exception{ExceptionType::FontLoadFail,
+                    std::string("can't open ") + path};
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  data_.resize(size > 0 ? size : 0);
+  const bool read =
+      size > 0 && fread(data_.data(), 1, data_.size(), file) == data_.size();
+  fclose(file);
+
+  const int offset = read ? stbtt_GetFontOffsetForIndex(data_.data(), 0) : -1;
+  if (offset < 0 || !stbtt_InitFont(&info_, data_.data(), offset))
+    throw Exception{ExceptionType::FontLoadFail,
+                    std::string("not a TrueType font: ") + path};
+
+  int ascent, descent, lineGap;
+  stbtt_GetFontVMetrics(&info_, &ascent, &descent, &lineGap);
+  const float height = ascent > descent ? ascent - descent : 1;
+  scale_ = glyphSize_ / height;
+  metrics_ = {ascent / height, descent / height, (height + lineGap) / height,
+              glyphSize_};
+  atlas_.resize((size_t)atlasWidth * atlasHeight_);
+
+  if (cacheDirectory.empty())
+    return;
+  std::error_code error;
+  std::filesystem::create_directories(cacheDirectory, error);
+  const uint32_t key[2] = {cacheVersion_, (uint32_t)glyphSize_};
+  const uint64_t hash =
+      hash_(key, sizeof(key),
+            hash_(data_.data(), data_.size(), 0xcbf29ce484222325));
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.sdf", (unsigned long long)hash);
+  cachePath_ = (std::filesystem::path(cacheDirectory) / name).string();
+  readCache_();
+}
+
+void FontFace::deinit(GlState &state) {
+  if (cacheDirty_ && !cachePath_.empty())
+    writeCache_();
+  cacheDirty_ = false;
+  if (texture_) {
+    state.forgetTexture(texture_);
+    glDeleteTextures(1, &texture_);
+    texture_ = 0;
+  }
+}
+
+const FontFace::Glyph &FontFace::glyph(uint32_t codepoint) {
+  const auto found = glyphs_.find(codepoint);
+  if (found != glyphs_.end())
+    return found->second;
+
+  Glyph glyph{};
+  glyph.index = stbtt_FindGlyphIndex(&info_, codepoint);
+  int advance, bearing;
+  stbtt_GetGlyphHMetrics(&info_, glyph.index, &advance, &bearing);
+  glyph.advance = advance * scale_ / glyphSize_;
+
+  // a texel of room between glyphs, so filtering never reaches the next one
+  const Bitmap_ &bitmap = render_(glyph.index);
+  if (bitmap.size.x > 0 && bitmap.size.y > 0 &&
+      packer_.pack(bitmap.size + 1, glyph.position)) {
+    glyph.size = bitmap.size;
+    glyph.min = glm::vec2(bitmap.offset.x, -(bitmap.offset.y + bitmap.size.y)) /
+                (float)glyphSize_;
+    glyph.max =
+        glm::vec2(bitmap.offset.x + bitmap.size.x, -bitmap.offset.y) /
+        (float)glyphSize_;
+
+    const int bottom = glyph.position.y + glyph.size.y;
+    if (bottom > atlasHeight_) {
+      while (bottom > atlasHeight_)
+        atlasHeight_ *= 2;
+      atlas_.resize((size_t)atlasWidth * atlasHeight_);
+      ++version_;
+    }
+    for (int y = 0; y < glyph.size.y; ++y)
+      memcpy(&atlas_[(size_t)(glyph.position.y + y) * atlasWidth +
+                     glyph.position.x],
+             &bitmap.pixels[(size_t)y * glyph.size.x], glyph.size.x);
+    dirtyBegin_ = dirtyEnd_ > dirtyBegin_
+                      ? std::min(dirtyBegin_, glyph.position.y)
+                      : glyph.position.y;
+    dirtyEnd_ = std::max(dirtyEnd_, bottom);
+  }
+  return glyphs_.emplace(codepoint, glyph).first->second;
+}
+
+float FontFace::kerning(const Glyph &left, const Glyph &right) const {
+  return stbtt_GetGlyphKernAdvance(&info_, left.index, right.index) * scale_ /
+         glyphSize_;
+}
+
+void FontFace::upload(GlState &state) {
+  if (texture_ && uploadedHeight_ == atlasHeight_ && dirtyEnd_ <= dirtyBegin_)
+    return;
+
+  if (!texture_) {
+    glGenTextures(1, &texture_);
+    state.bindTexture(0, texture_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+  state.bindTexture(0, texture_);
+  if (uploadedHeight_ != atlasHeight_) {
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight_, 0, GL_RED,
+                 GL_UNSIGNED_BYTE, atlas_.data());
+    uploadedHeight_ = atlasHeight_;
+  } else {
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirtyBegin_, atlasWidth,
+                    dirtyEnd_ - dirtyBegin_, GL_RED, GL_UNSIGNED_BYTE,
+                    &atlas_[(size_t)dirtyBegin_ * atlasWidth]);
+  }
+  dirtyBegin_ = dirtyEnd_ = 0;
+}
+
+const FontFace::Bitmap_ &FontFace::render_(int index) {
+  const auto found = bitmaps_.find(index);
+  if (found != bitmaps_.end())
+    return found->second;
+
+  // the field falls from `edgeValue_` on the outline to 0 `spread_` pixels
+  // outside of it
+  Bitmap_ bitmap{};
+  int width = 0, height = 0;
+  unsigned char *pixels = stbtt_GetGlyphSDF(
+      &info_, scale_, index, spread_, edgeValue_, (float)edgeValue_ / spread_,
+      &width, &height, &bitmap.offset.x, &bitmap.offset.y);
+  if (pixels) {
+    bitmap.size = {width, height};
+    bitmap.pixels.assign(pixels, pixels + (size_t)width * height);
+    stbtt_FreeSDF(pixels, nullptr);
+  }
+  cacheDirty_ = true;
+  return bitmaps_.emplace(index, std::move(bitmap)).first->second;
+}
+
+void FontFace::readCache_() {
+  FILE *file = fopen(cachePath_.c_str(), "rb");
+  if (!file)
+    return;
+
+  // glyphs up to a broken record are kept, the file is rewritten on deinit
+  CacheHeader_ header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.magic, cacheMagic_, sizeof(cacheMagic_)) ||
+      header.version != cacheVersion_ ||
+      header.glyphSize != (uint32_t)glyphSize_ ||
+      header.dataSize != data_.size()) {
+    fclose(file);
+    cacheDirty_ = true;
+    return;
+  }
+  for (uint32_t i = 0; i < header.count; ++i) {
+    CacheGlyph_ glyph;
+    Bitmap_ bitmap;
+    if (fread(&glyph, sizeof(glyph), 1, file) != 1 || glyph.width < 0 ||
+        glyph.height < 0 || glyph.width > maxBitmapSize_ ||
+        glyph.height > maxBitmapSize_) {
+      cacheDirty_ = true;
+      break;
+    }
+    bitmap.size = {glyph.width, glyph.height};
+    bitmap.offset = {glyph.x, glyph.y};
+    bitmap.pixels.resize((size_t)glyph.width * glyph.height);
+    if (fread(bitmap.pixels.data(), 1, bitmap.pixels.size(), file) !=
+        bitmap.pixels.size()) {
+      cacheDirty_ = true;
+      break;
+    }
+    bitmaps_.emplace(glyph.index, std::move(bitmap));
+  }
+  fclose(file);
+}
+
+// written next to the final file and renamed, like the program cache
+void FontFace::writeCache_() {
+  const std::string temporary = cachePath_ + ".tmp";
+  FILE *file = fopen(temporary.c_str(), "wb");
+  if (!file)
+    return;
+
+  CacheHeader_ header = {{},
+                         cacheVersion_,
+                         (uint32_t)glyphSize_,
+                         (uint32_t)bitmaps_.size(),
+                         data_.size()};
+  memcpy(header.magic, cacheMagic_, sizeof(cacheMagic_));
+  bool complete = fwrite(&header, sizeof(header), 1, file) == 1;
+  for (const auto &[index, bitmap] : bitmaps_) {
+    const CacheGlyph_ glyph = {index, (int16_t)bitmap.size.x,
+                               (int16_t)bitmap.size.y, (int16_t)bitmap.offset.x,
+                               (int16_t)bitmap.offset.y};
+    complete = complete && fwrite(&glyph, sizeof(glyph), 1, file) == 1 &&
+               fwrite(bitmap.pixels.data(), 1, bitmap.pixels.size(), file) ==
+                   bitmap.pixels.size();
+  }
+  if (fclose(file) != 0 || !complete ||
+      std::rename(temporary.c_str(), cachePath_.c_str()) != 0)
+    std::remove(temporary.c_str());
+}
+
+void TextBlock::deinit(GlState &state) {
+  if (!vao_)
+    return;
+  state.forgetVertexArray(vao_);
+  glDeleteVertexArrays(1, &vao_);
+  glDeleteBuffers(1, &buffer_);
+  vao_ = buffer_ = 0;
+}
+
+void TextBlock::setString(std::string_view string) {
+  if (string_ == string)
+    return;
+  string_ = string;
+  dirty_ = true;
+}
+
+void TextBlock::layout(FontHandle handle, FontFace &font) {
+  if (!dirty_ && handle == font_ && font.getVersion() == fontVersion_)
+    return;
+
+  // packing a glyph can grow the atlas, which moves the texture coordinates
+  // of all others, so every glyph is packed before any quad is placed
+  for (size_t i = 0; i < string_.size();)
+    font.glyph(decodeUtf8_(string_, i));
+
+  const Font &metrics = font.getMetrics();
+  const glm::vec2 texel =
+      1.0f / glm::vec2(FontFace::atlasWidth, font.getAtlasHeight());
+  vertices_.clear();
+  glm::vec2 pen(0);
+  float width = 0;
+  int lines = 1;
+  const FontFace::Glyph *previous = nullptr;
+  for (size_t i = 0; i < string_.size();) {
+    const uint32_t codepoint = decodeUtf8_(string_, i);
+    if (codepoint == '\n') {
+      width = std::max(width, pen.x);
+      pen = {0, pen.y - metrics.lineHeight};
+      previous = nullptr;
+      ++lines;
+      continue;
+    }
+
+    const FontFace::Glyph &glyph = font.glyph(codepoint);
+    if (previous)
+      pen.x += font.kerning(*previous, glyph);
+    previous = &glyph;
+    if (glyph.size.x) {
+      const glm::vec2 min = pen + glyph.min, max = pen + glyph.max;
+      // bitmap rows go down, so the top of the quad gets the smaller v
+      const glm::vec2 uvMin = glm::vec2(glyph.position) * texel;
+      const glm::vec2 uvMax = glm::vec2(glyph.position + glyph.size) * texel;
+      const uint16_t u0 = normalized_(uvMin.x), u1 = normalized_(uvMax.x);
+      const uint16_t v0 = normalized_(uvMin.y), v1 = normalized_(uvMax.y);
+      const Vertex_ corners[4] = {{min.x, min.y, u0, v1},
+                                  {max.x, min.y, u1, v1},
+                                  {min.x, max.y, u0, v0},
+                                  {max.x, max.y, u1, v0}};
+      for (int corner : {0, 1, 2, 2, 1, 3})
+        vertices_.push_back(corners[corner]);
+    }
+    pen.x += glyph.advance;
+  }
+  width = std::max(width, pen.x);
+
+  extent_ = {width, metrics.ascent - metrics.descent +
+                        (lines - 1) * metrics.lineHeight};
+  font_ = handle;
+  fontVersion_ = font.getVersion();
+  dirty_ = uploaded_ = false;
+}
+
+GLsizei TextBlock::prepare(GlState &state) {
+  if (uploaded_)
+    return vertexCount_;
+  uploaded_ = true;
+  vertexCount_ = vertices_.size();
+  if (!vertexCount_)
+    return 0;
+
+  if (!vao_) {
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &buffer_);
+    state.bindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+    glEnableVertexAttribArray(positionLocation);
+    glVertexAttribPointer(positionLocation, 2, GL_FLOAT, GL_FALSE,
+                          sizeof(Vertex_), (const void *)offsetof(Vertex_, x));
+    glEnableVertexAttribArray(uvLocation);
+    glVertexAttribPointer(uvLocation, 2, GL_UNSIGNED_SHORT, GL_TRUE,
+                          sizeof(Vertex_), (const void *)offsetof(Vertex_, u));
+  } else {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+  }
+  glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(Vertex_),
+               vertices_.data(), GL_STATIC_DRAW);
+  return vertexCount_;
+}
+} // namespace gtamfx
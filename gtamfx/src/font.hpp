@@ -0,0 +1,128 @@
+#pragma once
+
+#include "atlas.hpp"
+#include "glstate.hpp"
+
+#include <gtamfx.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include <stb_truetype.h>
+}
+
+namespace gtamfx {
+// A TrueType font whose glyphs are rendered as signed distance fields into a
+// single channel atlas texture the first time a text uses them. Rendered
+// glyphs stay in memory, and with a cache directory they are written to a file
+// named after the font data and glyph size when the font is deleted, so later
+// runs only read them back.
+class FontFace {
+public:
+  static constexpr int atlasWidth = 512;
+  static constexpr int maxAtlasHeight = 4096;
+
+  struct Glyph {
+    int index; // in the font, 0 for missing glyphs
+    float advance;
+    glm::vec2 min, max;  // quad around the pen, in units of the text size
+    glm::ivec2 position; // in the atlas
+    glm::ivec2 size;     // 0 for glyphs without a quad, like spaces
+  };
+
+  // throws FontLoadFail, `cacheDirectory` may be empty
+  FontFace(const char *path, int glyphSize, const std::string &cacheDirectory);
+  FontFace(const FontFace &) = delete;
+  FontFace &operator=(const FontFace &) = delete;
+  // writes the cache if glyphs were rendered since it was read
+  void deinit(GlState &state);
+
+  const Font &getMetrics() const { return metrics_; }
+  // renders and packs the glyph if this is its first use, glyphs that don't
+  // fit into the atlas anymore get no quad
+  const Glyph &glyph(uint32_t codepoint);
+  float kerning(const Glyph &left, const Glyph &right) const;
+
+  // Texture coordinates of packed glyphs change when the atlas grows, which
+  // changes the version. Texts laid out with an older one need a new layout.
+  uint64_t getVersion() const { return version_; }
+  int getAtlasHeight() const { return atlasHeight_; }
+  // Moves the glyphs packed since the last call to the texture, growing it if
+  // needed. Changes the texture binding of unit 0.
+  void upload(GlState &state);
+  GLuint getTexture() const { return texture_; }
+
+private:
+  struct Bitmap_ {
+    glm::ivec2 size, offset; // offset from the pen, in pixels with y down
+    std::vector<unsigned char> pixels;
+  };
+
+  void readCache_();
+  void writeCache_();
+  const Bitmap_ &render_(int index);
+
+  std::vector<unsigned char> data_; // `info_` points into it
+  stbtt_fontinfo info_{};
+  float scale_; // font units to pixels
+  int glyphSize_, spread_;
+  Font metrics_{};
+  std::string cachePath_;
+  bool cacheDirty_ = false;
+
+  std::unordered_map<uint32_t, Glyph> glyphs_; // by codepoint
+  std::unordered_map<int, Bitmap_> bitmaps_;   // by glyph index
+
+  SkylinePacker packer_{{atlasWidth, maxAtlasHeight}};
+  std::vector<unsigned char> atlas_; // atlasWidth x atlasHeight_
+  int atlasHeight_ = 64;
+  int uploadedHeight_ = 0;            // of the texture
+  int dirtyBegin_ = 0, dirtyEnd_ = 0; // rows to upload
+  uint64_t version_ = 0;
+  GLuint texture_ = 0;
+};
+
+// The vertex buffer of one text, six vertices per glyph quad. It is only laid
+// out again when the string or the font changes, and only uploaded after that,
+// so text that stays the same costs a draw call per frame and nothing else.
+class TextBlock {
+public:
+  // attribute locations, bound by `newShader`
+  static constexpr GLuint positionLocation = 8;
+  static constexpr GLuint uvLocation = 9;
+
+  void deinit(GlState &state);
+
+  void setString(std::string_view string);
+  const std::string &getString() const { return string_; }
+
+  // lays the string out again if it or the font changed since the last time
+  void layout(FontHandle handle, FontFace &font);
+  // width of the longest line and height from the top of the first line to
+  // the bottom of the last one, as of the last layout
+  glm::vec2 getExtent() const { return extent_; }
+  // Uploads the last layout if it wasn't yet, and returns the number of
+  // vertices to draw. Changes the GL_ARRAY_BUFFER and vertex array bindings.
+  GLsizei prepare(GlState &state);
+  GLuint getVertexArray() const { return vao_; }
+
+private:
+  struct Vertex_ {
+    float x, y;    // units of the text size, pen starts at 0 on the baseline
+    uint16_t u, v; // normalized
+  };
+
+  std::string string_;
+  FontHandle font_; // of the last layout
+  uint64_t fontVersion_ = 0;
+  bool dirty_ = true, uploaded_ = false;
+  std::vector<Vertex_> vertices_;
+  glm::vec2 extent_{0, 0};
+  GLuint vao_ = 0, buffer_ = 0;
+  GLsizei vertexCount_ = 0;
+};
+} // namespace gtamfx
@@ -0,0 +1,194 @@
+#include "gldebug.hpp"
+#include "glstate.hpp"
+
+#include <cstdio>
+
+namespace gtamfx {
+namespace {
+struct GlError {
+  const char *name, *description;
+};
+GlError getGlError_(GLenum code) {
+  switch (code) {
+  case GL_NO_ERROR:
+    return {"No Error", "No error has been recorded. The value of this "
+                        "symbolic constant is guaranteed to be 0."};
+  case GL_INVALID_ENUM:
+    return {"Invalid Enum",
+            "An unacceptable value is specified for an enumerated argument. "
+            "The offending command is ignored and has no other sideeffect than "
+            "to set the error flag."};
+  case GL_INVALID_VALUE:
+    return {"Invalid Value",
+            "A numeric argument is out of range. The offending command is "
+            "ignored and has no other side effect than to set the error flag."};
+  case GL_INVALID_OPERATION:
+    return {"Invalid Operation",
+            "The specified operation is not allowed in the current state. The "
+            "offending command is ignored and has no other side effect than to "
+            "set the error flag."};
+  case GL_INVALID_FRAMEBUFFER_OPERATION:
+    return {"Invalid Framebuffer Operation",
+            "The framebuffer object is not complete. The offending command is "
+            "ignored and has no other side effect than to set the error flag."};
+  case GL_OUT_OF_MEMORY:
+    return {"Out Of Memory",
+            "There is not enough memory left to execute the command. The state "
+            "of the GL is undefined, except for the state of the error flags, "
+            "after this error is recorded."};
+  case GL_STACK_UNDERFLOW:
+    return {"Stack Underflow",
+            "An attempt has been made to perform an operation that would cause "
+            "an internal stack to underflow."};
+  case GL_STACK_OVERFLOW:
+    return {"Stack Overflow",
+            "An attempt has been made to perform an operation that would cause "
+            "an internal stack to overflow."};
+  }
+  return {"?", "Unknown"};
+}
+
+const char *getSeverityName_(GlDebugSeverity severity) {
+  switch (severity) {
+  case GlDebugSeverity::Low:
+    return "Low";
+  case GlDebugSeverity::Medium:
+    return "Medium";
+  case GlDebugSeverity::High:
+    return "High";
+  }
+  return "?";
+}
+
+// past this many distinct messages the oldest ones may show up again
+constexpr size_t maxSeenMessages_ = 4096;
+// drivers can spam, messages beyond this per check are dropped
+constexpr size_t maxQueuedMessages_ = 1024;
+} // namespace
+
+void GlDebug::init() {
+  khr_ = hasGlExtension("GL_KHR_debug");
+  arb_ = !khr_ && hasGlExtension("GL_ARB_debug_output");
+  if (khr_) {
+    glDebugMessageCallback(&GlDebug::receive_, this);
+    // buffer usage hints and the like
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE,
+                          GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr,
+                          GL_FALSE);
+  } else if (arb_) {
+    glDebugMessageCallbackARB(&GlDebug::receive_, this);
+  }
+  applyMode_();
+}
+
+void GlDebug::deinit() {
+  if (khr_) {
+    glDisable(GL_DEBUG_OUTPUT);
+    glDebugMessageCallback(nullptr, nullptr);
+  } else if (arb_) {
+    glDebugMessageCallbackARB(nullptr, nullptr);
+  }
+  khr_ = arb_ = false;
+  std::lock_guard lock(mutex_);
+  queue_.clear();
+}
+
+void GlDebug::setMode(GlDebugMode mode) {
+  mode_ = mode;
+  applyMode_();
+}
+
+void GlDebug::applyMode_() {
+  const bool enabled = mode_ != GlDebugMode::Off;
+  if (khr_) {
+    if (enabled)
+      glEnable(GL_DEBUG_OUTPUT);
+    else
+      glDisable(GL_DEBUG_OUTPUT);
+  } else if (arb_) {
+    // ARB_debug_output can't be switched off as a whole
+    glDebugMessageControlARB(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0,
+                             nullptr, enabled);
+  } else {
+    // errors from before are not what the new mode is looking for
+    while (glGetError() != GL_NO_ERROR)
+      ;
+    return;
+  }
+
+  // synchronous output makes the driver call back from inside the offending
+  // call, otherwise it may batch messages up on its own threads
+  if (mode_ == GlDebugMode::PerCall)
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  else
+    glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+}
+
+void APIENTRY GlDebug::receive_(GLenum source, GLenum type, GLuint id,
+                                GLenum severity, GLsizei length,
+                                const GLchar *text, const void *user) {
+  GlDebugSeverity level;
+  switch (severity) {
+  case GL_DEBUG_SEVERITY_HIGH:
+    level = GlDebugSeverity::High;
+    break;
+  case GL_DEBUG_SEVERITY_MEDIUM:
+    level = GlDebugSeverity::Medium;
+    break;
+  case GL_DEBUG_SEVERITY_LOW:
+    level = GlDebugSeverity::Low;
+    break;
+  default:
+    return;
+  }
+
+  GlDebug &debug = *(GlDebug *)user;
+  std::lock_guard lock(debug.mutex_);
+  if (debug.queue_.size() >= maxQueuedMessages_)
+    return;
+  debug.queue_.push_back({source, type, id, level,
+                          length < 0 ? std::string(text)
+                                     : std::string(text, length)});
+}
+
+void GlDebug::check_() {
+  delivering_.clear();
+  if (khr_ || arb_) {
+    std::lock_guard lock(mutex_);
+    if (queue_.empty())
+      return;
+    std::swap(queue_, delivering_);
+  } else {
+    // there can be one error flag per kind of error
+    for (GLenum code; (code = glGetError()) != GL_NO_ERROR;) {
+      const GlError error = getGlError_(code);
+      delivering_.push_back(
+          {GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_ERROR, code,
+           GlDebugSeverity::High,
+           std::string(error.name) + ": " + error.description});
+    }
+  }
+
+  for (const Message_ &message : delivering_)
+    deliver_(message);
+}
+
+void GlDebug::deliver_(const Message_ &message) {
+  std::string key = std::to_string(message.type) + ":" +
+                    std::to_string(message.id) + ":" + message.text;
+  if (seen_.size() >= maxSeenMessages_)
+    seen_.clear();
+  if (!seen_.insert(std::move(key)).second)
+    return;
+
+  if (!callback_) {
+    fprintf(stderr, "OpenGL %s: %s\n", getSeverityName_(message.severity),
+            message.text.c_str());
+    return;
+  }
+  // the callback may replace itself
+  const GlDebugCallback callback = callback_;
+  callback({message.source, message.type, message.id, message.severity,
+            message.text.c_str()});
+}
+} // namespace gtamfx
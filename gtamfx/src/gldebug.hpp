@@ -0,0 +1,63 @@
+#pragma once
+
+#include <gtamfx.hpp>
+
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace gtamfx {
+// Collects gl errors and driver messages and hands them to the user callback.
+// With KHR_debug or ARB_debug_output the driver reports them through a
+// callback, which may run on any of its threads, so they are only queued
+// there; without either, glGetError is polled instead. Delivery happens in
+// `checkFrame`/`checkCall` on the thread doing the gl calls.
+class GlDebug {
+public:
+  // needs the gl functions to be loaded
+  void init();
+  void deinit();
+
+  void setMode(GlDebugMode mode);
+  GlDebugMode getMode() const { return mode_; }
+  void setCallback(GlDebugCallback callback) {
+    callback_ = std::move(callback);
+  }
+
+  // after every draw call, does nothing unless in per call mode
+  void checkCall() {
+    if (mode_ == GlDebugMode::PerCall)
+      check_();
+  }
+  // once at the end of a frame
+  void checkFrame() {
+    if (mode_ != GlDebugMode::Off)
+      check_();
+  }
+
+private:
+  struct Message_ {
+    GLenum source, type;
+    GLuint id;
+    GlDebugSeverity severity;
+    std::string text;
+  };
+
+  static void APIENTRY receive_(GLenum source, GLenum type, GLuint id,
+                                GLenum severity, GLsizei length,
+                                const GLchar *text, const void *user);
+  void applyMode_();
+  void check_();
+  void deliver_(const Message_ &message);
+
+  GlDebugMode mode_ = GlDebugMode::PerFrame;
+  GlDebugCallback callback_;
+  bool khr_ = false, arb_ = false; // which debug output the driver has
+
+  std::mutex mutex_; // guards `queue_`
+  std::vector<Message_> queue_;
+  std::vector<Message_> delivering_;
+  std::unordered_set<std::string> seen_; // messages already delivered
+};
+} // namespace gtamfx
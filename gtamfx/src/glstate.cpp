@@ -0,0 +1,158 @@
+#include "glstate.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace gtamfx {
+bool hasGlExtension(const char *name) {
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (GLint i = 0; i < count; ++i)
+    if (!strcmp((const char *)glGetStringi(GL_EXTENSIONS, i), name))
+      return true;
+  return false;
+}
+
+void GlState::invalidate() {
+  program_ = unknown_;
+  activeUnit_ = unknown_;
+  std::fill(std::begin(textures_), std::end(textures_), unknown_);
+  vao_ = unknown_;
+  polygonMode_ = unknown_;
+  blend_ = blendSource_ = blendDestination_ = unknown_;
+  depthTest_ = unknown_;
+  uniforms_.clear();
+  programUniforms_ = nullptr;
+}
+
+void GlState::forgetProgram(GLuint program) {
+  uniforms_.erase(program);
+  // a deleted program stays in use until another one is, but its uniforms
+  // can't be trusted anymore
+  if (program_ == program) {
+    program_ = unknown_;
+    programUniforms_ = nullptr;
+  }
+}
+
+void GlState::forgetTexture(GLuint texture) {
+  for (GLuint &bound : textures_)
+    if (bound == texture)
+      bound = 0;
+}
+
+void GlState::forgetVertexArray(GLuint vao) {
+  if (vao_ == vao)
+    vao_ = 0;
+}
+
+bool GlState::useProgram(GLuint program) {
+  if (program_ == program)
+    return filtered_();
+  glUseProgram(program_ = program);
+  programUniforms_ = &uniforms_[program];
+  return true;
+}
+
+bool GlState::bindTexture(GLuint unit, GLuint texture) {
+  if (unit >= textureUnitCount) {
+    glActiveTexture(GL_TEXTURE0 + (activeUnit_ = unit));
+    glBindTexture(GL_TEXTURE_2D, texture);
+    return true;
+  }
+  if (textures_[unit] == texture)
+    return filtered_();
+  if (activeUnit_ != unit)
+    glActiveTexture(GL_TEXTURE0 + (activeUnit_ = unit));
+  glBindTexture(GL_TEXTURE_2D, textures_[unit] = texture);
+  return true;
+}
+
+bool GlState::bindVertexArray(GLuint vao) {
+  if (vao_ == vao)
+    return filtered_();
+  glBindVertexArray(vao_ = vao);
+  return true;
+}
+
+bool GlState::setPolygonMode(GLenum mode) {
+  if (polygonMode_ == mode)
+    return filtered_();
+  glPolygonMode(GL_FRONT_AND_BACK, polygonMode_ = mode);
+  return true;
+}
+
+bool GlState::setBlend(bool enabled) {
+  return setCapability_(GL_BLEND, blend_, enabled);
+}
+
+bool GlState::setBlendFunc(GLenum source, GLenum destination) {
+  if (blendSource_ == source && blendDestination_ == destination)
+    return filtered_();
+  glBlendFunc(blendSource_ = source, blendDestination_ = destination);
+  return true;
+}
+
+bool GlState::setDepthTest(bool enabled) {
+  return setCapability_(GL_DEPTH_TEST, depthTest_, enabled);
+}
+
+bool GlState::uniform1i(GLint location, GLint value) {
+  if (!setUniform_(location, GL_INT, &value, sizeof(value)))
+    return false;
+  glUniform1i(location, value);
+  return true;
+}
+
+bool GlState::uniform4f(GLint location, const glm::vec4 &value) {
+  if (!setUniform_(location, GL_FLOAT_VEC4, &value, sizeof(value)))
+    return false;
+  glUniform4f(location, value.x, value.y, value.z, value.w);
+  return true;
+}
+
+bool GlState::uniformMatrix4fv(GLint location, const glm::mat4 &value) {
+  if (!setUniform_(location, GL_FLOAT_MAT4, &value, sizeof(value)))
+    return false;
+  glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+  return true;
+}
+
+size_t GlState::takeFilteredCount() {
+  return std::exchange(filteredCount_, 0);
+}
+
+// true if the caller has to issue the call, the cache is already updated then
+bool GlState::setUniform_(GLint location, GLenum type, const void *value,
+                          size_t bytes) {
+  // nothing to compare against if the program in use isn't known
+  if (!programUniforms_)
+    return true;
+  Uniform_ &uniform = (*programUniforms_)[location];
+  if (uniform.type == type && !std::memcmp(uniform.values, value, bytes))
+    return filtered_();
+  uniform.type = type;
+  std::memcpy(uniform.values, value, bytes);
+  return true;
+}
+
+bool GlState::setCapability_(GLenum capability, GLuint &current,
+                             bool enabled) {
+  if (current == (GLuint)enabled)
+    return filtered_();
+  current = enabled;
+  if (enabled)
+    glEnable(capability);
+  else
+    glDisable(capability);
+  return true;
+}
+
+bool GlState::filtered_() {
+  ++filteredCount_;
+  return false;
+}
+} // namespace gtamfx
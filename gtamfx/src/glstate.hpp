@@ -0,0 +1,75 @@
+#pragma once
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <unordered_map>
+
+namespace gtamfx {
+// of the current context
+bool hasGlExtension(const char *name);
+
+// Shadow copy of the gl state the renderer touches. Every setter compares
+// against what it last set and skips the gl call if nothing would change,
+// returning whether it issued one. All of it starts out unknown, so the first
+// call of each always goes through. Anything that changes this state behind
+// the tracker's back has to `invalidate` it.
+class GlState {
+public:
+  static constexpr GLuint textureUnitCount = 16;
+
+  GlState() { invalidate(); }
+
+  // forget everything, the next call of every setter is issued
+  void invalidate();
+  // names deleted by gl are unbound, and may come back for new objects
+  void forgetProgram(GLuint program);
+  void forgetTexture(GLuint texture);
+  void forgetVertexArray(GLuint vao);
+
+  bool useProgram(GLuint program);
+  // GL_TEXTURE_2D only, switches the active unit on the way if needed
+  bool bindTexture(GLuint unit, GLuint texture);
+  bool bindVertexArray(GLuint vao);
+  bool setPolygonMode(GLenum mode); // for GL_FRONT_AND_BACK
+  bool setBlend(bool enabled);
+  bool setBlendFunc(GLenum source, GLenum destination);
+  bool setDepthTest(bool enabled);
+
+  // values are cached per program and location, so these set the uniforms of
+  // the program in use
+  bool uniform1i(GLint location, GLint value);
+  bool uniform4f(GLint location, const glm::vec4 &value);
+  bool uniformMatrix4fv(GLint location, const glm::mat4 &value);
+
+  // calls skipped since the last time this was called
+  size_t takeFilteredCount();
+
+private:
+  // a name and enum gl never hands out
+  static constexpr GLuint unknown_ = ~0u;
+
+  struct Uniform_ {
+    GLenum type;
+    float values[16];
+  };
+  using Uniforms_ = std::unordered_map<GLint, Uniform_>;
+
+  bool setUniform_(GLint location, GLenum type, const void *value,
+                   size_t bytes);
+  bool setCapability_(GLenum capability, GLuint &current, bool enabled);
+  bool filtered_();
+
+  GLuint program_;
+  GLuint activeUnit_;
+  GLuint textures_[textureUnitCount];
+  GLuint vao_;
+  GLuint polygonMode_;
+  GLuint blend_, blendSource_, blendDestination_;
+  GLuint depthTest_;
+  std::unordered_map<GLuint, Uniforms_> uniforms_; // by program
+  Uniforms_ *programUniforms_ = nullptr;           // of `program_`
+  size_t filteredCount_ = 0;
+};
+} // namespace gtamfx
@@ -2,13 +2,36 @@
 #include <GL/gl3w.h>
 #include <GLFW/glfw3.h>
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <glm/gtc/type_ptr.hpp>
 #include <gtamfx.hpp>
 #include <memory>
-#include <ranges>
+#include <type_traits>
+
+#include "atlas.hpp"
+#include "font.hpp"
+#include "gldebug.hpp"
+#include "glstate.hpp"
+#include "headless.hpp"
+#include "jobs.hpp"
+#include "loader.hpp"
+#include "pack.hpp"
+#include "particles.hpp"
+#include "programcache.hpp"
+#include "slotmap.hpp"
+#include "spatial.hpp"
+#include "stream.hpp"
+#include "texfile.hpp"
+#include "tilemap.hpp"
+#include "transform.hpp"
+
+#include <chrono>
+#include <deque>
+#include <thread>
 
 extern "C" {
 #define STB_IMAGE_IMPLEMENTATION
@@ -16,133 +39,1984 @@ extern "C" {
 }
 
 namespace {
-struct GlError {
-  const char *name, *description;
+std::string getGlfwError_() {
+  const char *description;
+  glfwGetError(&description);
+  return description;
+}
+
+// translate * rotate * scale, without multiplying the three matrices out
+glm::mat4 computeModelMatrix_(const gtamfx::Sprite *sprite) {
+  glm::mat4 model = glm::mat4_cast(sprite->rotation);
+  model[0] *= sprite->scale.x;
+  model[1] *= sprite->scale.y;
+  model[2] *= sprite->scale.z;
+  model[3] = glm::vec4(sprite->position, 1.0f);
+  return model;
+}
+
+glm::mat4 computeViewMatrix_(const gtamfx::Camera *camera) {
+  glm::mat4 view = glm::mat4(1.0f);
+  view *= glm::mat4_cast(glm::conjugate(camera->rotation));
+  view *= glm::translate(glm::mat4(1.0f), -camera->position);
+  return view;
+}
+
+glm::mat4 computeProjectionMatrix_(const gtamfx::Camera *camera) {
+  switch (camera->type) {
+  case gtamfx::CameraType::Orthographic:
+    return glm::ortho(camera->orthographic.size.x * camera->orthographic.left,
+                      camera->orthographic.size.x * camera->orthographic.right,
+                      camera->orthographic.size.y * camera->orthographic.bottom,
+                      camera->orthographic.size.y * camera->orthographic.top);
+  case gtamfx::CameraType::Perspective:
+    return glm::perspective(
+        camera->perspective.fov, camera->perspective.aspect,
+        camera->perspective.zNear, camera->perspective.zFar);
+  default:
+    return glm::mat4(1.0f);
+  }
+}
+
+// projection * view
+glm::mat4 computeCameraMatrix_(const gtamfx::Camera *camera) {
+  return computeProjectionMatrix_(camera) * computeViewMatrix_(camera);
+}
+
+// a sprite showing all of `source` at its size
+gtamfx::Sprite newSprite_(gtamfx::TextureHandle texture,
+                          const gtamfx::Texture *source,
+                          gtamfx::ShaderHandle shader) {
+  gtamfx::Sprite sprite{};
+  sprite.texture.source = texture;
+  sprite.texture.position = {0, 0};
+  sprite.texture.scale = {1, 1};
+  sprite.position = {0, 0, 0};
+  sprite.scale = {source ? source->size : glm::vec2(1), 1};
+  sprite.rotation = glm::identity<glm::quat>();
+  sprite.color = {1, 1, 1, 1};
+  sprite.shader = shader;
+  return sprite;
+}
+
+// world space bounds of the sprite's unit quad
+gtamfx::Bounds spriteBounds_(const gtamfx::Sprite &sprite) {
+  const glm::vec3 x = sprite.rotation * glm::vec3(sprite.scale.x * 0.5f, 0, 0);
+  const glm::vec3 y = sprite.rotation * glm::vec3(0, sprite.scale.y * 0.5f, 0);
+  const glm::vec3 extent = glm::abs(x) + glm::abs(y);
+  return {sprite.position - extent, sprite.position + extent};
+}
+
+// the parts of a sprite its model matrix and bounds depend on
+struct SpriteTransform_ {
+  glm::vec3 position;
+  glm::vec3 scale;
+  glm::quat rotation;
+
+  bool operator==(const SpriteTransform_ &) const = default;
+};
+
+struct SpriteCache_ {
+  SpriteTransform_ transform; // the sprite's transform `clip` was built from
+  glm::mat4 clip;             // camera matrix * model matrix
+  uint64_t clipVersion = 0;   // camera matrix version of `clip`, 0 when stale
+};
+
+// `clipVersion` of a `clip` that is only the model matrix, for shaders with
+// the camera block, which no camera change makes stale
+constexpr uint64_t modelOnlyVersion_ = UINT64_MAX;
+
+SpriteTransform_ spriteTransform_(const gtamfx::Sprite &sprite) {
+  return {sprite.position, sprite.scale, sprite.rotation};
+}
+
+// clip space planes of a camera matrix, pointing inwards
+struct Frustum_ {
+  glm::vec4 planes[6];
+
+  explicit Frustum_(const glm::mat4 &m) {
+    const glm::vec4 row[4] = {
+        {m[0][0], m[1][0], m[2][0], m[3][0]},
+        {m[0][1], m[1][1], m[2][1], m[3][1]},
+        {m[0][2], m[1][2], m[2][2], m[3][2]},
+        {m[0][3], m[1][3], m[2][3], m[3][3]},
+    };
+    for (int i = 0; i < 3; ++i) {
+      planes[i * 2] = row[3] + row[i];
+      planes[i * 2 + 1] = row[3] - row[i];
+    }
+  }
+
+  bool intersects(const gtamfx::Bounds &bounds) const {
+    for (const glm::vec4 &plane : planes) {
+      // corner furthest along the plane normal
+      const glm::vec3 corner = {plane.x > 0 ? bounds.max.x : bounds.min.x,
+                                plane.y > 0 ? bounds.max.y : bounds.min.y,
+                                plane.z > 0 ? bounds.max.z : bounds.min.z};
+      if (glm::dot(glm::vec3(plane), corner) + plane.w < 0)
+        return false;
+    }
+    return true;
+  }
+};
+
+// xy bounds of everything a camera matrix can see
+gtamfx::Bounds frustumBounds_(const glm::mat4 &cameraMatrix) {
+  const glm::mat4 inverse = glm::inverse(cameraMatrix);
+  gtamfx::Bounds bounds = {glm::vec3(INFINITY), glm::vec3(-INFINITY)};
+  for (int i = 0; i < 8; ++i) {
+    glm::vec4 corner = inverse * glm::vec4(i & 1 ? 1 : -1, i & 2 ? 1 : -1,
+                                           i & 4 ? 1 : -1, 1);
+    const glm::vec3 point = glm::vec3(corner) / corner.w;
+    bounds.min = glm::min(bounds.min, point);
+    bounds.max = glm::max(bounds.max, point);
+  }
+  return bounds;
+}
+
+// world bounds of a text's lines
+gtamfx::Bounds textBounds_(const gtamfx::Text &text, float ascent,
+                           glm::vec2 extent) {
+  gtamfx::Bounds bounds = {glm::vec3(INFINITY), glm::vec3(-INFINITY)};
+  for (int i = 0; i < 4; ++i) {
+    const glm::vec3 corner(i & 1 ? extent.x : 0,
+                           i & 2 ? ascent - extent.y : ascent, 0);
+    const glm::vec3 point =
+        text.position + text.rotation * (corner * text.size);
+    bounds.min = glm::min(bounds.min, point);
+    bounds.max = glm::max(bounds.max, point);
+  }
+  return bounds;
+}
+
+// per-instance data of instanced shaders, see the comment above `Shader`
+struct SpriteInstance_ {
+  glm::mat4 transform;
+  glm::vec4 textureView;
+  glm::vec4 color;
+};
+
+constexpr GLuint instanceTransformLocation_ = 0; // mat4, takes 4 locations
+constexpr GLuint instanceTextureViewLocation_ = 4;
+constexpr GLuint instanceColorLocation_ = 5;
+
+// the GtamCamera uniform block, see the comment above `Shader`
+struct CameraBlock_ {
+  glm::mat4 view;
+  glm::mat4 projection;
+  glm::mat4 viewProjection;
+  glm::vec4 position;
+};
+
+constexpr const char *cameraBlockName_ = "GtamCamera";
+constexpr GLuint cameraBlockBinding_ = 0;
+
+// gl 3.3 has no base instance, so the attributes are re-pointed at the first
+// instance of every batch instead. `base` is in bytes, attributes come from
+// the buffer bound to GL_ARRAY_BUFFER.
+void setInstanceOffset_(size_t base) {
+  const GLsizei stride = sizeof(SpriteInstance_);
+  for (GLuint i = 0; i < 4; ++i)
+    glVertexAttribPointer(
+        instanceTransformLocation_ + i, 4, GL_FLOAT, GL_FALSE, stride,
+        (const void *)(base + offsetof(SpriteInstance_, transform) +
+                       i * sizeof(glm::vec4)));
+  glVertexAttribPointer(
+      instanceTextureViewLocation_, 4, GL_FLOAT, GL_FALSE, stride,
+      (const void *)(base + offsetof(SpriteInstance_, textureView)));
+  glVertexAttribPointer(instanceColorLocation_, 4, GL_FLOAT, GL_FALSE, stride,
+                        (const void *)(base + offsetof(SpriteInstance_, color)));
+}
+
+// a sprite with its handles resolved for the current frame
+struct DrawItem_ {
+  uint32_t slot;
+  const gtamfx::Sprite *sprite;
+  const gtamfx::Shader *shader;
+  const gtamfx::Texture *texture;
+};
+
+void drawSprites_(const gtamfx::Shader *shader, GLsizei instanceCount) {
+  if (shader->vertexCount >= 3)
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, shader->vertexCount,
+                          instanceCount);
+  else if (shader->vertexCount == 2)
+    glDrawArraysInstanced(GL_LINES, 0, 2, instanceCount);
+}
+
+bool canBatch_(const DrawItem_ &a, const DrawItem_ &b) {
+  return a.shader == b.shader && a.texture->id == b.texture->id;
+}
+
+// sprite texture view mapped into the texture's region
+glm::vec4 textureView_(const gtamfx::Sprite *sprite,
+                       const gtamfx::Texture *texture) {
+  glm::vec2 position = texture->region.position +
+                       sprite->texture.position * texture->region.scale;
+  glm::vec2 scale = sprite->texture.scale * texture->region.scale;
+  return {position.x, position.y, scale.x, scale.y};
+}
+
+// async texture whose pixels are being streamed into `id` row by row, or
+// level by level for KTX/DDS files
+struct TextureUpload_ {
+  gtamfx::DecodedImage image;
+  GLuint id;
+  int rowsDone;
+  size_t levelsDone;
+};
+
+// formats of KTX/DDS files the context samples as they are
+uint32_t getSupportedTextureFormats_() {
+  using gtamfx::formatBit, gtamfx::TextureFormat;
+  uint32_t formats = formatBit(TextureFormat::Rgba8) |
+                     formatBit(TextureFormat::Bc4) |
+                     formatBit(TextureFormat::Bc5); // rgtc is core
+  if (gtamfx::hasGlExtension("GL_EXT_texture_compression_s3tc"))
+    formats |= formatBit(TextureFormat::Bc1) | formatBit(TextureFormat::Bc2) |
+               formatBit(TextureFormat::Bc3) |
+               formatBit(TextureFormat::Bc1Rgb);
+  if (gtamfx::hasGlExtension("GL_ARB_texture_compression_bptc"))
+    formats |= formatBit(TextureFormat::Bc7);
+  if (gtamfx::hasGlExtension("GL_ARB_ES3_compatibility"))
+    formats |= formatBit(TextureFormat::Etc2Rgb) |
+               formatBit(TextureFormat::Etc2Rgba);
+  return formats;
+}
+
+// `pixels` is an offset while a pixel unpack buffer is bound
+void uploadTextureLevel_(gtamfx::TextureFormat format,
+                         const gtamfx::TextureLevel &data, size_t level,
+                         const void *pixels) {
+  if (format == gtamfx::TextureFormat::Rgba8)
+    glTexImage2D(GL_TEXTURE_2D, (GLint)level, GL_RGBA, data.size.x,
+                 data.size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+  else
+    glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level,
+                           gtamfx::getGlInternalFormat(format), data.size.x,
+                           data.size.y, 0, (GLsizei)data.bytes, pixels);
+}
+
+size_t levelBytes_(const std::vector<gtamfx::TextureLevel> &levels) {
+  size_t bytes = 0;
+  for (const gtamfx::TextureLevel &level : levels)
+    bytes += level.bytes;
+  return bytes;
+}
+
+// an rgba8 texture with all the mip levels glGenerateMipmap makes
+size_t mipChainBytes_(glm::ivec2 size) {
+  size_t bytes = (size_t)size.x * size.y * 4;
+  while (size.x > 1 || size.y > 1) {
+    size = glm::max(size / 2, glm::ivec2(1));
+    bytes += (size_t)size.x * size.y * 4;
+  }
+  return bytes;
+}
+
+// a resident texture owning all of `id`
+gtamfx::Texture ownTexture_(GLuint id, glm::ivec2 size) {
+  gtamfx::Texture texture{};
+  texture.id = id;
+  texture.size = size;
+  texture.region.position = {0, 0};
+  texture.region.scale = {1, 1};
+  texture.state = gtamfx::TextureState::Resident;
+  texture.atlasPage = -1;
+  return texture;
+}
+
+// What a texture with a gl texture of its own costs, and where it is loaded
+// from again after it was evicted.
+struct TextureResidency_ {
+  size_t bytes = 0;       // 0 unless resident with a gl texture of its own
+  uint64_t lastDrawn = 0; // frame
+  std::string path;       // its file, or its name in `pack`
+  gtamfx::PackHandle pack;
+  size_t atlasPixels = 0; // of its cell, padding included, if in an atlas page
+  bool reloading = false;  // goes back into a gl texture of its own
+};
+
+struct AtlasPage_ {
+  GLuint id;
+  gtamfx::SkylinePacker packer;
+  size_t imageCount;
+  size_t usedPixels;
+  bool mipsDirty;
+};
+
+// Draw order is depth first, then shader and texture so that sprites at the
+// same depth end up next to each other in as few batches as possible:
+//   [63..32] depth (bits of position.z mapped to an unsigned order)
+//   [31..16] gl program name
+//   [15..0]  gl texture name (shared by images in the same atlas page)
+// Names are truncated to 16 bits, which only affects batching.
+struct SortEntry_ {
+  uint64_t key;
+  gtamfx::SpriteHandle sprite;
+};
+
+uint32_t depthBits_(float z) {
+  z += 0.0f; // -0 -> +0
+  uint32_t bits;
+  std::memcpy(&bits, &z, sizeof(bits));
+  return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+uint64_t sortKey_(const gtamfx::Sprite &sprite, const gtamfx::Shader *shader,
+                  const gtamfx::Texture *texture) {
+  return (uint64_t)depthBits_(sprite.position.z) << 32 |
+         (uint64_t)((shader ? shader->id : 0) & 0xffff) << 16 |
+         (uint64_t)((texture ? texture->id : 0) & 0xffff);
+}
+
+bool sortEntryLess_(const SortEntry_ &a, const SortEntry_ &b) {
+  return a.key < b.key;
+}
+
+// stable lsd radix sort over the bytes of the key, skipping bytes that are the
+// same for every entry (e.g. the texture byte in a single texture scene)
+void radixSort_(std::vector<SortEntry_> &entries,
+                std::vector<SortEntry_> &scratch) {
+  size_t counts[8][256] = {};
+  for (const SortEntry_ &entry : entries)
+    for (int byte = 0; byte < 8; ++byte)
+      ++counts[byte][(entry.key >> (byte * 8)) & 0xff];
+
+  scratch.resize(entries.size());
+  for (int byte = 0; byte < 8; ++byte) {
+    size_t *count = counts[byte];
+    if (count[(entries[0].key >> (byte * 8)) & 0xff] == entries.size())
+      continue;
+
+    size_t offset = 0;
+    for (int digit = 0; digit < 256; ++digit) {
+      size_t n = count[digit];
+      count[digit] = offset;
+      offset += n;
+    }
+
+    for (const SortEntry_ &entry : entries)
+      scratch[count[(entry.key >> (byte * 8)) & 0xff]++] = entry;
+    entries.swap(scratch);
+  }
+}
+using Clock_ = std::chrono::steady_clock;
+
+struct Stopwatch_ {
+  Clock_::time_point mark = Clock_::now();
+
+  // milliseconds since the last lap
+  double lap() {
+    const Clock_::time_point now = Clock_::now();
+    const double ms =
+        std::chrono::duration<double, std::milli>(now - mark).count();
+    mark = now;
+    return ms;
+  }
+};
+
+// throws `Exception` if either shader or the program fails
+GLuint compileProgram_(const char *vertex_source, const char *fragment_source,
+                       bool retrievable) {
+  GLuint vshader = glCreateShader(GL_VERTEX_SHADER);
+  glShaderSource(vshader, 1, &vertex_source, NULL);
+  glCompileShader(vshader);
+
+  GLint vertex_compiled;
+  glGetShaderiv(vshader, GL_COMPILE_STATUS, &vertex_compiled);
+  if (vertex_compiled != GL_TRUE) {
+    GLchar message[1024];
+    glGetShaderInfoLog(vshader, 1024, NULL, message);
+    throw gtamfx::Exception{gtamfx::ExceptionType::ShaderLoadFail,
+                            "[vertex shader] " + std::string(message)};
+  }
+
+  GLuint fshader = glCreateShader(GL_FRAGMENT_SHADER);
+  glShaderSource(fshader, 1, &fragment_source, NULL);
+  glCompileShader(fshader);
+
+  GLint fragment_compiled;
+  glGetShaderiv(fshader, GL_COMPILE_STATUS, &fragment_compiled);
+  if (fragment_compiled != GL_TRUE) {
+    GLchar message[1024];
+    glGetShaderInfoLog(fshader, 1024, NULL, message);
+    throw gtamfx::Exception{gtamfx::ExceptionType::ShaderLoadFail,
+                            "[fragment shader] " + std::string(message)};
+  }
+
+  GLuint program = glCreateProgram();
+  glAttachShader(program, vshader);
+  glAttachShader(program, fshader);
+  glBindAttribLocation(program, instanceTransformLocation_, "aTransform");
+  glBindAttribLocation(program, instanceTextureViewLocation_, "aTextureView");
+  glBindAttribLocation(program, instanceColorLocation_, "aColor");
+  glBindAttribLocation(program, gtamfx::TileLayer::positionLocation,
+                       "aTilePosition");
+  glBindAttribLocation(program, gtamfx::TileLayer::uvLocation, "aTileUv");
+  glBindAttribLocation(program, gtamfx::TextBlock::positionLocation,
+                       "aGlyphPosition");
+  glBindAttribLocation(program, gtamfx::TextBlock::uvLocation, "aGlyphUv");
+  glBindAttribLocation(program, gtamfx::ParticleBuffers::positionLocation,
+                       "aParticlePosition");
+  glBindAttribLocation(program, gtamfx::ParticleBuffers::colorLocation,
+                       "aParticleColor");
+  glBindAttribLocation(program, gtamfx::ParticleBuffers::sizeLocation,
+                       "aParticleSize");
+  if (retrievable)
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  glLinkProgram(program);
+
+  GLint program_linked;
+  glGetProgramiv(program, GL_LINK_STATUS, &program_linked);
+  if (program_linked != GL_TRUE) {
+    GLchar message[1024];
+    glGetProgramInfoLog(program, 1024, NULL, message);
+    throw gtamfx::Exception{gtamfx::ExceptionType::ShaderLoadFail,
+                            "[program] " + std::string(message)};
+  }
+
+  glDeleteShader(vshader);
+  glDeleteShader(fshader);
+
+  return program;
+}
+
+// a value set with `setShaderParameter`, kept to tell whether the next one
+// changes anything
+struct ShaderParameter_ {
+  std::vector<float> floats; // or `ints`, by the uniform's type
+  std::vector<GLint> ints;
+  bool dirty = false;
+};
+
+// what `newShader` reflected from the program
+struct ShaderInfo_ {
+  std::vector<gtamfx::ShaderUniform> uniforms;
+  std::vector<gtamfx::ShaderUniformBlock> blocks;
+  std::vector<ShaderParameter_> parameters; // by uniform
+  bool parametersDirty = false;
+};
+
+// components of one element of a uniform type parameters can be set for, 0
+// for the others
+int parameterComponents_(GLenum type, bool &integer) {
+  integer = false;
+  switch (type) {
+  case GL_FLOAT:
+    return 1;
+  case GL_FLOAT_VEC2:
+    return 2;
+  case GL_FLOAT_VEC3:
+    return 3;
+  case GL_FLOAT_VEC4:
+  case GL_FLOAT_MAT2:
+    return 4;
+  case GL_FLOAT_MAT3:
+    return 9;
+  case GL_FLOAT_MAT4:
+    return 16;
+  }
+
+  integer = true;
+  switch (type) {
+  case GL_INT:
+  case GL_BOOL:
+  case GL_SAMPLER_2D:
+  case GL_SAMPLER_2D_ARRAY:
+  case GL_SAMPLER_3D:
+  case GL_SAMPLER_CUBE:
+  case GL_SAMPLER_BUFFER:
+    return 1;
+  case GL_INT_VEC2:
+  case GL_BOOL_VEC2:
+    return 2;
+  case GL_INT_VEC3:
+  case GL_BOOL_VEC3:
+    return 3;
+  case GL_INT_VEC4:
+  case GL_BOOL_VEC4:
+    return 4;
+  }
+  return 0;
+}
+
+// the program must be in use, returns the number of uploads
+size_t uploadParameters_(ShaderInfo_ &info) {
+  size_t uploads = 0;
+  for (size_t index = 0; index < info.uniforms.size(); ++index) {
+    ShaderParameter_ &parameter = info.parameters[index];
+    if (!parameter.dirty)
+      continue;
+    parameter.dirty = false;
+    ++uploads;
+
+    const gtamfx::ShaderUniform &uniform = info.uniforms[index];
+    bool integer;
+    const GLsizei components = parameterComponents_(uniform.type, integer);
+    const GLint location = uniform.location;
+    const float *floats = parameter.floats.data();
+    const GLint *ints = parameter.ints.data();
+    const GLsizei count =
+        (integer ? parameter.ints.size() : parameter.floats.size()) /
+        components;
+    switch (uniform.type) {
+    case GL_FLOAT_MAT2:
+      glUniformMatrix2fv(location, count, GL_FALSE, floats);
+      continue;
+    case GL_FLOAT_MAT3:
+      glUniformMatrix3fv(location, count, GL_FALSE, floats);
+      continue;
+    case GL_FLOAT_MAT4:
+      glUniformMatrix4fv(location, count, GL_FALSE, floats);
+      continue;
+    }
+    if (integer) {
+      switch (components) {
+      case 1:
+        glUniform1iv(location, count, ints);
+        break;
+      case 2:
+        glUniform2iv(location, count, ints);
+        break;
+      case 3:
+        glUniform3iv(location, count, ints);
+        break;
+      case 4:
+        glUniform4iv(location, count, ints);
+        break;
+      }
+      continue;
+    }
+    switch (components) {
+    case 1:
+      glUniform1fv(location, count, floats);
+      break;
+    case 2:
+      glUniform2fv(location, count, floats);
+      break;
+    case 3:
+      glUniform3fv(location, count, floats);
+      break;
+    case 4:
+      glUniform4fv(location, count, floats);
+      break;
+    }
+  }
+  info.parametersDirty = false;
+  return uploads;
+}
+
+// Active uniforms and uniform blocks of a linked program. The camera block is
+// pointed at its binding point here, since that isn't part of the program
+// binary everywhere.
+ShaderInfo_ reflectProgram_(GLuint program) {
+  ShaderInfo_ info;
+  GLint count = 0, maxLength = 0;
+  std::vector<GLchar> name;
+
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+  name.resize(std::max(maxLength, 1));
+  for (GLuint index = 0; index < (GLuint)count; ++index) {
+    glGetActiveUniformBlockName(program, index, name.size(), nullptr,
+                                name.data());
+    gtamfx::ShaderUniformBlock block{name.data()};
+    if (block.name == cameraBlockName_)
+      glUniformBlockBinding(program, index, cameraBlockBinding_);
+    GLint binding = 0;
+    glGetActiveUniformBlockiv(program, index, GL_UNIFORM_BLOCK_DATA_SIZE,
+                              &block.size);
+    glGetActiveUniformBlockiv(program, index, GL_UNIFORM_BLOCK_BINDING,
+                              &binding);
+    block.binding = binding;
+    info.blocks.push_back(std::move(block));
+  }
+
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  name.resize(std::max(maxLength, 1));
+  for (GLuint index = 0; index < (GLuint)count; ++index) {
+    gtamfx::ShaderUniform uniform{};
+    glGetActiveUniform(program, index, name.size(), nullptr, &uniform.size,
+                       &uniform.type, name.data());
+    glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_BLOCK_INDEX,
+                          &uniform.block);
+    uniform.location =
+        uniform.block == -1 ? glGetUniformLocation(program, name.data()) : -1;
+    uniform.name = name.data();
+    if (uniform.name.ends_with("[0]"))
+      uniform.name.resize(uniform.name.size() - 3);
+    info.uniforms.push_back(std::move(uniform));
+  }
+  info.parameters.resize(info.uniforms.size());
+  return info;
+}
+
+// gpu frame times are read back this many frames late at most
+constexpr size_t timerQueryCount_ = 4;
+
+struct TimerQuery_ {
+  GLuint id = 0;
+  uint64_t frame = 0;
+  bool pending = false;
+};
+
+// a tilemap layer with chunks visible this frame
+struct TileLayerDraw_ {
+  float z;
+  const gtamfx::Tilemap *tilemap;
+  const gtamfx::Shader *shader;
+  const gtamfx::Texture *texture;
+  size_t chunksBegin, chunksEnd; // into `WindowImpl_::tileChunkDraws`
+};
+
+struct TileChunkDraw_ {
+  GLuint vao;
+  GLsizei indexCount;
+};
+
+constexpr int maxTilemapSize_ = 65535; // tile corners are 16 bit
+
+// a text in view with glyphs to draw
+struct TextDraw_ {
+  float z;
+  const gtamfx::Text *text;
+  const gtamfx::Shader *shader;
+  GLuint texture; // font atlas
+  GLuint vao;
+  GLsizei vertexCount;
+};
+
+// an emitter with a shader and texture to draw its particles with
+struct ParticleDraw_ {
+  float z;
+  const gtamfx::ParticleEmitter *emitter;
+  const gtamfx::Shader *shader;
+  const gtamfx::Texture *texture;
+  GLuint vao;
+  GLsizei instanceCount;
+};
+
+enum class LayerKind_ { TileLayer, Text, Particles };
+
+// something drawn in between the sprites, `index` into the draws of its kind
+struct LayerDraw_ {
+  float z;
+  LayerKind_ kind;
+  size_t index;
 };
-GlError getGlError_(GLenum code) {
-  switch (code) {
-  case GL_NO_ERROR:
-    return {"No Error", "No error has been recorded. The value of this "
-                        "symbolic constant is guaranteed to be 0."};
-  case GL_INVALID_ENUM:
-    return {"Invalid Enum",
-            "An unacceptable value is specified for an enumerated argument. "
-            "The offending command is ignored and has no other sideeffect than "
-            "to set the error flag."};
-  case GL_INVALID_VALUE:
-    return {"Invalid Value",
-            "A numeric argument is out of range. The offending command is "
-            "ignored and has no other side effect than to set the error flag."};
-  case GL_INVALID_OPERATION:
-    return {"Invalid Operation",
-            "The specified operation is not allowed in the current state. The "
-            "offending command is ignored and has no other side effect than to "
-            "set the error flag."};
-  case GL_INVALID_FRAMEBUFFER_OPERATION:
-    return {"Invalid Framebuffer Operation",
-            "The framebuffer object is not complete. The offending command is "
-            "ignored and has no other side effect than to set the error flag."};
-  case GL_OUT_OF_MEMORY:
-    return {"Out Of Memory",
-            "There is not enough memory left to execute the command. The state "
-            "of the GL is undefined, except for the state of the error flags, "
-            "after this error is recorded."};
-  case GL_STACK_UNDERFLOW:
-    return {"Stack Underflow",
-            "An attempt has been made to perform an operation that would cause "
-            "an internal stack to underflow."};
-  case GL_STACK_OVERFLOW:
-    return {"Stack Overflow",
-            "An attempt has been made to perform an operation that would cause "
-            "an internal stack to overflow."};
-  }
-  return {"?", "Unknown"};
-}
-
-void reportGlErrors_() {
-  GLenum code = glGetError();
-  if (code == GL_NO_ERROR)
+
+// instances whose matrices the transform kernel builds with the same matrix
+struct TransformBatch_ {
+  std::vector<uint32_t> slots;   // sprites to run the kernel on
+  std::vector<uint32_t> targets; // and their instance index
+
+  void clear() {
+    slots.clear();
+    targets.clear();
+  }
+};
+} // namespace
+
+namespace gtamfx {
+struct WindowImpl_ {
+  SlotMap<Texture> textures;
+  SlotMap<Sprite> sprites;
+  SlotMap<SpriteBatch> spriteBatches;
+  SlotMap<Shader> shaders;
+  std::vector<ShaderInfo_> shaderInfos; // by slot
+  SlotMap<Camera> cameras;
+  SlotMap<Tilemap> tilemaps;
+  std::vector<std::vector<TileLayer>> tileLayers; // by tilemap slot
+  CameraHandle activeCamera;
+  GLFWwindow *window = nullptr;
+  std::unique_ptr<HeadlessContext> headless;
+  std::chrono::steady_clock::time_point headlessStart;
+  bool headlessShouldClose = false;
+  GLuint vao = 0;
+  StreamBuffer instanceStream;
+  GlState glState;
+  GlDebug glDebug;
+  ProgramCache programCache;
+  std::vector<DrawItem_> drawItems;
+  std::vector<SpriteInstance_> instances;
+
+  // sprites in draw order, kept sorted between frames
+  std::vector<SortEntry_> drawOrder;
+  std::vector<SortEntry_> dirtySprites, sortScratch;
+  std::vector<uint64_t> spriteKeys; // by slot index, key at the last sort
+  std::vector<uint64_t> denseKeys;  // by dense index, key of this frame
+  bool didDeleteSprites = false;
+
+  // sprite bounds by slot index, kept up to date by `updateSpatialIndex`
+  SpatialGrid spriteGrid;
+  std::vector<SpriteCache_> spriteCaches;   // by slot
+  std::vector<uint64_t> spriteVisibleFrame; // by slot, frame + 1
+  std::vector<uint8_t> spriteMoved;         // by dense index
+  std::vector<uint32_t> queryScratch;
+  bool culling = true;
+
+  // only rebuilt when the active camera changed
+  CameraHandle cachedCamera;
+  Camera cachedCameraValue{};
+  glm::mat4 cameraMatrix = glm::mat4(1.0f);
+  uint64_t cameraVersion = 0;
+  GLuint cameraBuffer = 0; // GtamCamera uniform block
+
+  TransformKernel transformKernel = getBestTransformKernel();
+  std::vector<float> transformScratch;
+  TransformBatch_ clipTransforms;      // by the camera matrix
+  TransformBatch_ modelTransforms;     // for shaders with the camera block
+  std::vector<uint32_t> instanceItems; // draw item of each instance
+
+  GLuint tileIndexBuffer = 0;
+  std::vector<TileLayerDraw_> tileLayerDraws;
+  std::vector<TileChunkDraw_> tileChunkDraws;
+
+  SlotMap<Font> fonts;
+  std::vector<std::unique_ptr<FontFace>> fontFaces; // by slot
+  std::string fontCacheDirectory;
+  SlotMap<Text> texts;
+  std::vector<TextBlock> textBlocks; // by slot
+  std::vector<TextDraw_> textDraws;
+
+  SlotMap<ParticleEmitter> particleEmitters;
+  std::vector<std::unique_ptr<ParticleBuffers>> particleBuffers; // by slot
+  ParticleSimulator particleSimulator; // compiled with the first emitter
+  float particleTimeStep = 0;          // 0 for real time
+  float particleTime = -1;             // of the last step, -1 before it
+  float particleDelta = 0;             // of this frame's step
+  std::vector<ParticleDraw_> particleDraws;
+
+  SlotMap<Pack> packs;
+  std::vector<std::unique_ptr<AssetPack>> packFiles; // by slot
+
+  // tilemap layers, texts and particles by depth
+  std::vector<LayerDraw_> layerDraws;
+
+  // frame preparation is spread over these, gl calls stay on this thread
+  std::unique_ptr<JobSystem> jobs =
+      std::make_unique<JobSystem>(std::thread::hardware_concurrency());
+
+  AtlasOptions atlasOptions;
+  std::vector<AtlasPage_> atlasPages; // id 0 for pages free for reuse
+
+  std::unique_ptr<TextureLoader> loader; // started by the first async load
+  std::vector<DecodedImage> decodedImages;
+  std::deque<TextureUpload_> uploads;
+  size_t uploadBudget = 8 << 20;
+  StreamBuffer uploadStream; // pixel unpack buffer
+  GLuint placeholderTexture = 0;
+  uint32_t textureFormats = 0; // `formatBit`s of KTX/DDS files sampled as is
+
+  std::vector<TextureResidency_> textureResidency; // by slot
+  std::vector<TextureHandle> textureReloads; // evicted textures drawn again
+  std::vector<TextureHandle> evictionOrder;
+  size_t textureBudget = 0; // 0 for none
+  size_t residentBytes = 0;
+  size_t evictions = 0;
+  size_t reloads = 0;
+
+  bool didReportNoActiveCamera = false;
+
+  FrameStats frameStats{};
+  uint64_t frameCount = 0;
+  std::vector<FrameStats> statsHistory = std::vector<FrameStats>(240);
+  TimerQuery_ timerQueries[timerQueryCount_];
+  size_t nextTimerQuery = 0;
+  bool isTiming = false;
+
+  uint64_t sortKey(const Sprite &sprite) const {
+    return sortKey_(sprite, shaders.get(sprite.shader),
+                    textures.get(sprite.texture.source));
+  }
+  void sortSprites();
+  void deleteTexture(GLuint id);
+  bool packIntoAtlas(const unsigned char *data, glm::ivec2 size,
+                     Texture &texture, size_t &cellPixels);
+  void releaseFromAtlas(TextureHandle handle);
+  GLuint createLevelTexture(TextureFormat format,
+                            const std::vector<TextureLevel> &levels,
+                            const unsigned char *data);
+  GLuint uploadPackTexture(const AssetPack &pack, const char *name,
+                           std::vector<TextureLevel> &levels,
+                           std::string &error);
+  TextureHandle insertTexture(const Texture &texture, size_t bytes);
+  void setResident(TextureHandle handle, size_t bytes);
+  // keeps the texture from being evicted this frame, and loads it again if it
+  // was
+  void markDrawn(TextureHandle handle, Texture &texture) {
+    textureResidency[handle.index].lastDrawn = frameCount;
+    if (texture.state == TextureState::Evicted) {
+      texture.state = TextureState::Loading;
+      textureReloads.push_back(handle);
+    }
+  }
+  void startLoader();
+  void reloadTextures();
+  void reloadFromPack(TextureHandle handle, Texture &texture);
+  void evictTextures();
+  void generateAtlasMips();
+  void uploadTextures();
+  void updateSprite(SpriteHandle handle, const Sprite &sprite);
+  SpriteHandle insertSprite(const Sprite &sprite);
+  void applySpriteBatches();
+  void updateSprites();
+  void updateCameraMatrix(CameraHandle handle, const Camera &camera);
+  uint64_t clipVersion(const Shader &shader) const {
+    return shader.cameraBlock ? modelOnlyVersion_ : cameraVersion;
+  }
+  const glm::mat4 &clipMatrix(uint32_t slot, const Sprite &sprite,
+                              const Shader &shader);
+  void transformInstances(const TransformBatch_ &batch,
+                          const glm::mat4 &matrix, uint64_t version,
+                          size_t begin, size_t end);
+  void transformBatch(const TransformBatch_ &batch, const glm::mat4 &matrix,
+                      uint64_t version);
+  template <typename T>
+  bool setShaderParameter(ShaderHandle handle, const char *name,
+                          const T *values, size_t count);
+  void cullSprites();
+  TileLayer *tileLayer(TilemapHandle tilemap, size_t layer);
+  void prepareTilemaps();
+  void bindMaterial(ShaderHandle handle, const Shader &shader, GLuint texture);
+  void drawTileLayer(const TileLayerDraw_ &draw);
+  AssetPack *assetPack(PackHandle pack);
+  FontFace *fontFace(FontHandle font);
+  void prepareTexts();
+  void drawText(const TextDraw_ &draw);
+  ParticleBuffers *particles(ParticleEmitterHandle emitter);
+  void prepareParticles();
+  void drawParticles(const ParticleDraw_ &draw);
+  void sortLayers();
+  void drawLayer(const LayerDraw_ &draw);
+  void drawSprites(Stopwatch_ &stopwatch);
+  void beginGpuTimer();
+  void endGpuTimer();
+  void readGpuTimers();
+  void endFrame();
+  void recordFrameStats();
+};
+
+// Moves decoded images to the gpu, at most `uploadBudget` bytes per frame.
+// Rows are copied into an orphaned pixel buffer so the driver can do the
+// actual transfer without stalling, the texture only switches over from the
+// placeholder once every row and the mips are in. KTX/DDS files go through
+// the same buffer a whole mip level at a time.
+void WindowImpl_::uploadTextures() {
+  std::vector<std::pair<TextureCallback, TextureHandle>> loaded, failed;
+
+  reloadTextures();
+  if (loader)
+    loader->poll(decodedImages);
+  for (DecodedImage &image : decodedImages) {
+    Texture *texture = textures.get(image.texture);
+    if (!texture) {
+      stbi_image_free(image.pixels);
+      continue;
+    }
+
+    if (!image.pixels && !image.file) {
+      texture->state = TextureState::Failed;
+      fprintf(stderr, "Failed to load texture: %s\n", image.error.c_str());
+      failed.emplace_back(std::move(image.callback), image.texture);
+      continue;
+    }
+
+    texture->size = image.size;
+    // evicted textures had a gl texture of their own and get one back, views
+    // outside of 0..1 would sample the neighbours in an atlas page
+    if (image.pixels && atlasOptions.enabled &&
+        !textureResidency[image.texture.index].reloading &&
+        image.size.x <= atlasOptions.maxImageSize &&
+        image.size.y <= atlasOptions.maxImageSize &&
+        packIntoAtlas(image.pixels, image.size, *texture,
+                      textureResidency[image.texture.index].atlasPixels)) {
+      texture->state = TextureState::Resident;
+      stbi_image_free(image.pixels);
+      loaded.emplace_back(std::move(image.callback), image.texture);
+      continue;
+    }
+
+    uploads.push_back({std::move(image), 0, 0, 0});
+  }
+  decodedImages.clear();
+
+  size_t spent = 0;
+  while (!uploads.empty() && (spent < uploadBudget || spent == 0)) {
+    TextureUpload_ &upload = uploads.front();
+    DecodedImage &image = upload.image;
+    Texture *texture = textures.get(image.texture);
+    if (!texture) {
+      deleteTexture(upload.id);
+      stbi_image_free(image.pixels);
+      uploads.pop_front();
+      continue;
+    }
+
+    if (!upload.id) {
+      glGenTextures(1, &upload.id);
+      glState.bindTexture(0, upload.id);
+      if (!image.file)
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.size.x, image.size.y, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+      else
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                        (GLint)image.file->levels.size() - 1);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    if (image.file) {
+      const TextureFile &file = *image.file;
+      const TextureLevel &level = file.levels[upload.levelsDone];
+      size_t offset;
+      void *mapped = uploadStream.map(level.bytes, offset);
+      std::memcpy(mapped, file.data.data() + level.offset, level.bytes);
+      uploadStream.unmap();
+
+      glState.bindTexture(0, upload.id);
+      uploadTextureLevel_(file.format, level, upload.levelsDone,
+                          (const void *)offset);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+      spent += level.bytes;
+      if (++upload.levelsDone < file.levels.size())
+        continue;
+    } else {
+      const size_t rowBytes = (size_t)image.size.x * 4;
+      const int rowsLeft = image.size.y - upload.rowsDone;
+      const int rows = (int)glm::clamp<size_t>(
+          (uploadBudget > spent ? uploadBudget - spent : 0) / rowBytes, 1,
+          rowsLeft);
+      const size_t bytes = rowBytes * rows;
+
+      size_t offset;
+      void *mapped = uploadStream.map(bytes, offset);
+      std::memcpy(mapped, image.pixels + rowBytes * upload.rowsDone, bytes);
+      uploadStream.unmap();
+
+      glState.bindTexture(0, upload.id);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, upload.rowsDone, image.size.x,
+                      rows, GL_RGBA, GL_UNSIGNED_BYTE, (const void *)offset);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+      spent += bytes;
+      upload.rowsDone += rows;
+      if (upload.rowsDone < image.size.y)
+        continue;
+
+      glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    texture->id = upload.id;
+    texture->state = TextureState::Resident;
+    setResident(image.texture, image.file ? levelBytes_(image.file->levels)
+                                          : mipChainBytes_(image.size));
+    stbi_image_free(image.pixels);
+    loaded.emplace_back(std::move(image.callback), image.texture);
+    uploads.pop_front();
+  }
+
+  // callbacks last, they may create or delete textures
+  for (auto &[callback, texture] : loaded)
+    if (callback)
+      callback(texture, true);
+  for (auto &[callback, texture] : failed)
+    if (callback)
+      callback(texture, false);
+}
+
+// the padding may change later, so `cellPixels` is kept for the release
+bool WindowImpl_::packIntoAtlas(const unsigned char *data, glm::ivec2 size,
+                                Texture &texture, size_t &cellPixels) {
+  const int padding = atlasOptions.padding;
+  const glm::ivec2 padded = size + 2 * padding;
+  // keep every image on a 4 pixel grid
+  const glm::ivec2 cell = (padded + 3) / 4 * 4;
+
+  glm::ivec2 position;
+  size_t page;
+  for (page = 0; page < atlasPages.size(); ++page)
+    if (atlasPages[page].id && atlasPages[page].packer.pack(cell, position))
+      break;
+
+  if (page == atlasPages.size()) {
+    const glm::ivec2 pageSize(atlasOptions.pageSize);
+    for (page = 0; page < atlasPages.size(); ++page)
+      if (!atlasPages[page].id)
+        break;
+    if (page == atlasPages.size())
+      atlasPages.push_back({0, SkylinePacker(pageSize), 0, 0, false});
+
+    AtlasPage_ &atlasPage = atlasPages[page];
+    atlasPage.packer = SkylinePacker(pageSize);
+    if (!atlasPage.packer.pack(cell, position))
+      return false;
+
+    glGenTextures(1, &atlasPage.id);
+    glState.bindTexture(0, atlasPage.id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pageSize.x, pageSize.y, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  }
+
+  // the gutter repeats the edge pixels of the image
+  std::vector<unsigned char> pixels((size_t)padded.x * padded.y * 4);
+  for (int y = 0; y < padded.y; ++y) {
+    const int sourceY = glm::clamp(y - padding, 0, size.y - 1);
+    for (int x = 0; x < padded.x; ++x) {
+      const int sourceX = glm::clamp(x - padding, 0, size.x - 1);
+      std::memcpy(&pixels[((size_t)y * padded.x + x) * 4],
+                  &data[((size_t)sourceY * size.x + sourceX) * 4], 4);
+    }
+  }
+
+  AtlasPage_ &atlasPage = atlasPages[page];
+  glState.bindTexture(0, atlasPage.id);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, position.x, position.y, padded.x,
+                  padded.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+  atlasPage.imageCount += 1;
+  cellPixels = (size_t)cell.x * cell.y;
+  atlasPage.usedPixels += cellPixels;
+  atlasPage.mipsDirty = true;
+
+  const glm::vec2 pageSize = atlasPage.packer.getSize();
+  texture.id = atlasPage.id;
+  texture.region.position = glm::vec2(position + padding) / pageSize;
+  texture.region.scale = glm::vec2(size) / pageSize;
+  texture.atlasPage = page;
+  return true;
+}
+
+// a gl texture with every level of `data` uploaded right away
+GLuint WindowImpl_::createLevelTexture(TextureFormat format,
+                                       const std::vector<TextureLevel> &levels,
+                                       const unsigned char *data) {
+  GLuint id;
+  glGenTextures(1, &id);
+  glState.bindTexture(0, id);
+  for (size_t level = 0; level < levels.size(); ++level)
+    uploadTextureLevel_(format, levels[level], level,
+                        data + levels[level].offset);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                  (GLint)levels.size() - 1);
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  return id;
+}
+
+// Levels the driver can sample go from the mapping to gl without a copy,
+// others are copied out to be transcoded. 0 if that fails.
+GLuint WindowImpl_::uploadPackTexture(const AssetPack &pack, const char *name,
+                                      std::vector<TextureLevel> &levels,
+                                      std::string &error) {
+  AssetPack::TextureData data;
+  if (!pack.findTexture(name, data)) {
+    error = std::string("no texture in the pack named ") + name;
+    return 0;
+  }
+  if (textureFormats & formatBit(data.format)) {
+    levels = data.levels;
+    return createLevelTexture(data.format, data.levels, data.data);
+  }
+
+  const TextureLevel &last = data.levels.back();
+  TextureFile transcoded{data.format, data.levels,
+                         std::vector<unsigned char>(
+                             data.data, data.data + last.offset + last.bytes)};
+  if (!makeUploadable(transcoded, textureFormats, error))
+    return 0;
+  levels = transcoded.levels;
+  return createLevelTexture(transcoded.format, transcoded.levels,
+                            transcoded.data.data());
+}
+
+// `bytes` is 0 for textures without a gl texture of their own yet
+TextureHandle WindowImpl_::insertTexture(const Texture &texture,
+                                         size_t bytes) {
+  const TextureHandle handle = textures.insert(texture);
+  if (textureResidency.size() <= handle.index)
+    textureResidency.resize(handle.index + 1);
+  textureResidency[handle.index] = {};
+  setResident(handle, bytes);
+  return handle;
+}
+
+void WindowImpl_::setResident(TextureHandle handle, size_t bytes) {
+  TextureResidency_ &entry = textureResidency[handle.index];
+  entry.bytes = bytes;
+  entry.lastDrawn = frameCount;
+  entry.reloading = false;
+  residentBytes += bytes;
+}
+
+void WindowImpl_::startLoader() {
+  if (loader)
+    return;
+  // set once up front, stbi keeps this in a global
+  stbi_set_flip_vertically_on_load(true);
+  loader = std::make_unique<TextureLoader>(
+      std::clamp(std::thread::hardware_concurrency(), 1u, 4u), textureFormats);
+}
+
+// Evicted textures drawn in the last frame: files go through the async loader
+// like `newTextureAsync`, pack textures are uploaded from the mapping.
+void WindowImpl_::reloadTextures() {
+  for (TextureHandle handle : textureReloads) {
+    Texture *texture = textures.get(handle);
+    if (!texture || texture->state != TextureState::Loading)
+      continue;
+    TextureResidency_ &entry = textureResidency[handle.index];
+    if (entry.pack) {
+      reloadFromPack(handle, *texture);
+      continue;
+    }
+    ++reloads;
+    entry.reloading = true;
+    startLoader();
+    loader->load(handle, entry.path.c_str(), {});
+  }
+  textureReloads.clear();
+}
+
+// `unloadPack` reloads the pack's evicted textures before unmapping it, so
+// the pack is only missing here if that failed
+void WindowImpl_::reloadFromPack(TextureHandle handle, Texture &texture) {
+  const TextureResidency_ &entry = textureResidency[handle.index];
+  const AssetPack *pack = assetPack(entry.pack);
+  std::vector<TextureLevel> levels;
+  std::string error = "its pack was unloaded";
+  ++reloads;
+  const GLuint id =
+      pack ? uploadPackTexture(*pack, entry.path.c_str(), levels, error) : 0;
+  if (!id) {
+    texture.state = TextureState::Failed;
+    fprintf(stderr, "Failed to reload texture: %s\n", error.c_str());
     return;
-  GlError error = getGlError_(code);
-  fprintf(stderr, "OpenGL Error: %s (#%u): %s\n", error.name, code,
-          error.description);
+  }
+  texture.id = id;
+  texture.state = TextureState::Resident;
+  setResident(handle, levelBytes_(levels));
+}
+
+// Frees the gl textures drawn the longest time ago until the rest fit into
+// the budget. They keep their size and region, so sprites only notice the
+// placeholder.
+void WindowImpl_::evictTextures() {
+  if (!textureBudget || residentBytes <= textureBudget)
+    return;
+
+  evictionOrder.clear();
+  for (size_t i = 0; i < textures.size(); ++i) {
+    const TextureHandle handle = textures.handleAt(i);
+    const TextureResidency_ &entry = textureResidency[handle.index];
+    if (textures.data()[i].state == TextureState::Resident && entry.bytes &&
+        entry.lastDrawn < frameCount &&
+        (entry.pack ? packs.valid(entry.pack) : !entry.path.empty()))
+      evictionOrder.push_back(handle);
+  }
+  std::sort(evictionOrder.begin(), evictionOrder.end(),
+            [this](TextureHandle a, TextureHandle b) {
+              return textureResidency[a.index].lastDrawn <
+                     textureResidency[b.index].lastDrawn;
+            });
+
+  for (TextureHandle handle : evictionOrder) {
+    if (residentBytes <= textureBudget)
+      break;
+    Texture &texture = *textures.get(handle);
+    TextureResidency_ &entry = textureResidency[handle.index];
+    deleteTexture(texture.id);
+    texture.id = placeholderTexture;
+    texture.state = TextureState::Evicted;
+    residentBytes -= entry.bytes;
+    entry.bytes = 0;
+    ++evictions;
+  }
+}
+
+void WindowImpl_::releaseFromAtlas(TextureHandle handle) {
+  AtlasPage_ &page = atlasPages[textures.get(handle)->atlasPage];
+  size_t &cellPixels = textureResidency[handle.index].atlasPixels;
+  page.usedPixels -= std::min(page.usedPixels, cellPixels);
+  cellPixels = 0;
+
+  if (--page.imageCount == 0) {
+    deleteTexture(page.id);
+    page.id = 0;
+    page.usedPixels = 0;
+    page.mipsDirty = false;
+  }
+}
+
+// the name may be reused right away, so the state cache must not keep it
+void WindowImpl_::deleteTexture(GLuint id) {
+  glState.forgetTexture(id);
+  glDeleteTextures(1, &id);
+}
+
+// mips of a page are rebuilt once per frame instead of once per image
+void WindowImpl_::generateAtlasMips() {
+  for (AtlasPage_ &page : atlasPages) {
+    if (!page.mipsDirty)
+      continue;
+    glState.bindTexture(0, page.id);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    page.mipsDirty = false;
+  }
+}
+
+// Sprites are plain structs that can be written from anywhere, so changes are
+// found by comparing every key against the one from the last frame. Only the
+// sprites whose key changed are re-inserted; if nothing changed (and nothing
+// was deleted) the previous order is reused as is.
+void WindowImpl_::sortSprites() {
+  denseKeys.resize(sprites.size());
+  jobs->parallelFor(sprites.size(), 4096, [this](size_t begin, size_t end) {
+    for (size_t index = begin; index < end; ++index)
+      denseKeys[index] = sortKey(sprites.data()[index]);
+  });
+
+  dirtySprites.clear();
+  for (size_t index = 0; index < sprites.size(); ++index) {
+    const uint64_t key = denseKeys[index];
+    const SpriteHandle sprite = sprites.handleAt(index);
+    if (spriteKeys[sprite.index] != key) {
+      spriteKeys[sprite.index] = key;
+      dirtySprites.push_back({key, sprite});
+    }
+  }
+
+  if (dirtySprites.empty() && !didDeleteSprites)
+    return;
+  didDeleteSprites = false;
+
+  std::erase_if(drawOrder, [this](const SortEntry_ &entry) {
+    return !sprites.valid(entry.sprite) ||
+           spriteKeys[entry.sprite.index] != entry.key;
+  });
+
+  if (dirtySprites.empty())
+    return;
+
+  const size_t sorted = drawOrder.size();
+  drawOrder.insert(drawOrder.end(), dirtySprites.begin(), dirtySprites.end());
+  if (dirtySprites.size() * 4 >= drawOrder.size()) {
+    radixSort_(drawOrder, sortScratch);
+  } else {
+    std::sort(drawOrder.begin() + sorted, drawOrder.end(), sortEntryLess_);
+    std::inplace_merge(drawOrder.begin(), drawOrder.begin() + sorted,
+                       drawOrder.end(), sortEntryLess_);
+  }
+}
+
+void WindowImpl_::updateSprite(SpriteHandle handle, const Sprite &sprite) {
+  if (spriteCaches.size() <= handle.index)
+    spriteCaches.resize(handle.index + 1);
+  SpriteCache_ &cache = spriteCaches[handle.index];
+  cache.transform = spriteTransform_(sprite);
+  cache.clipVersion = 0;
+  spriteGrid.set(handle.index, spriteBounds_(sprite));
+}
+
+SpriteHandle WindowImpl_::insertSprite(const Sprite &sprite) {
+  SpriteHandle handle = sprites.insert(sprite);
+  // anything but the real key, so the next sort picks the sprite up
+  if (spriteKeys.size() <= handle.index)
+    spriteKeys.resize(handle.index + 1);
+  spriteKeys[handle.index] = ~sortKey(sprite);
+  updateSprite(handle, sprite);
+  return handle;
+}
+
+void WindowImpl_::applySpriteBatches() {
+  for (const SpriteBatch &batch : spriteBatches) {
+    jobs->parallelFor(
+        batch.sprites.size(), 4096, [this, &batch](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            Sprite *sprite = sprites.get(batch.sprites[i]);
+            if (!sprite)
+              continue;
+            sprite->position = batch.positions[i];
+            sprite->scale = batch.scales[i];
+            sprite->rotation = batch.rotations[i];
+            sprite->color = batch.colors[i];
+            sprite->texture.position = glm::vec2(batch.textureViews[i]);
+            sprite->texture.scale = {batch.textureViews[i].z,
+                                     batch.textureViews[i].w};
+          }
+        });
+  }
+}
+
+// Sprites are changed through plain pointers, so moved ones are found by
+// comparing against the transform their cached matrix was built from. The
+// spatial index isn't thread safe, moved sprites are put in it afterwards.
+void WindowImpl_::updateSprites() {
+  applySpriteBatches();
+
+  spriteMoved.resize(sprites.size());
+  jobs->parallelFor(sprites.size(), 4096, [this](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const SpriteTransform_ transform = spriteTransform_(sprites.data()[i]);
+      SpriteCache_ &cache = spriteCaches[sprites.handleAt(i).index];
+      spriteMoved[i] = cache.transform != transform;
+      if (spriteMoved[i]) {
+        cache.transform = transform;
+        cache.clipVersion = 0;
+      }
+    }
+  });
+
+  for (size_t i = 0; i < sprites.size(); ++i)
+    if (spriteMoved[i])
+      spriteGrid.set(sprites.handleAt(i).index,
+                     spriteBounds_(sprites.data()[i]));
+}
+
+// The camera block is bound once per frame for all programs, its contents only
+// change with the camera.
+void WindowImpl_::updateCameraMatrix(CameraHandle handle,
+                                     const Camera &camera) {
+  glBindBufferBase(GL_UNIFORM_BUFFER, cameraBlockBinding_, cameraBuffer);
+  if (cameraVersion && handle == cachedCamera &&
+      !std::memcmp(&camera, &cachedCameraValue, sizeof(Camera)))
+    return;
+  cachedCamera = handle;
+  cachedCameraValue = camera;
+
+  CameraBlock_ block;
+  block.view = computeViewMatrix_(&camera);
+  block.projection = computeProjectionMatrix_(&camera);
+  block.viewProjection = block.projection * block.view;
+  block.position = glm::vec4(camera.position, 1);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+  cameraMatrix = block.viewProjection;
+  ++cameraVersion;
+}
+
+// clip matrices of sprites that didn't move under a camera that didn't move
+// are reused as they are, model matrices as long as the sprite doesn't move
+const glm::mat4 &WindowImpl_::clipMatrix(uint32_t slot, const Sprite &sprite,
+                                         const Shader &shader) {
+  SpriteCache_ &cache = spriteCaches[slot];
+  const uint64_t version = clipVersion(shader);
+  if (cache.clipVersion != version) {
+    cache.clip = computeModelMatrix_(&sprite);
+    if (!shader.cameraBlock)
+      cache.clip = cameraMatrix * cache.clip;
+    cache.clipVersion = version;
+  }
+  return cache.clip;
+}
+
+// Instances whose clip matrix is stale get it from the batch transform kernel,
+// which writes right into the instance array. The transforms are gathered into
+// structure of arrays scratch for it first, `transformScratch` must hold 10
+// floats per stale instance of the batch.
+void WindowImpl_::transformInstances(const TransformBatch_ &batch,
+                                     const glm::mat4 &matrix, uint64_t version,
+                                     size_t begin, size_t end) {
+  const size_t count = batch.slots.size();
+  float *soa[10];
+  for (int i = 0; i < 10; ++i)
+    soa[i] = transformScratch.data() + i * count + begin;
+
+  for (size_t i = 0; i < end - begin; ++i) {
+    const SpriteTransform_ &transform =
+        spriteCaches[batch.slots[begin + i]].transform;
+    for (int axis = 0; axis < 3; ++axis) {
+      soa[axis][i] = transform.position[axis];
+      soa[7 + axis][i] = transform.scale[axis];
+    }
+    soa[3][i] = transform.rotation.x;
+    soa[4][i] = transform.rotation.y;
+    soa[5][i] = transform.rotation.z;
+    soa[6][i] = transform.rotation.w;
+  }
+
+  const SpriteTransforms in = {{soa[0], soa[1], soa[2]},
+                               {soa[3], soa[4], soa[5], soa[6]},
+                               {soa[7], soa[8], soa[9]}};
+  transformSprites(transformKernel, matrix, in, end - begin,
+                   &instances.data()->transform, sizeof(SpriteInstance_),
+                   batch.targets.data() + begin);
+
+  for (size_t i = begin; i < end; ++i) {
+    SpriteCache_ &cache = spriteCaches[batch.slots[i]];
+    cache.clip = instances[batch.targets[i]].transform;
+    cache.clipVersion = version;
+  }
+}
+
+void WindowImpl_::transformBatch(const TransformBatch_ &batch,
+                                 const glm::mat4 &matrix, uint64_t version) {
+  transformScratch.resize(batch.slots.size() * 10);
+  jobs->parallelFor(batch.slots.size(), 1024, [&](size_t begin, size_t end) {
+    transformInstances(batch, matrix, version, begin, end);
+  });
+}
+
+template <typename T>
+bool WindowImpl_::setShaderParameter(ShaderHandle handle, const char *name,
+                                     const T *values, size_t count) {
+  const Shader *shader = shaders.get(handle);
+  if (!shader)
+    return false;
+  ShaderInfo_ &info = shaderInfos[handle.index];
+
+  for (size_t index = 0; index < info.uniforms.size(); ++index) {
+    const ShaderUniform &uniform = info.uniforms[index];
+    if (uniform.name != name)
+      continue;
+
+    bool integer;
+    const size_t components = parameterComponents_(uniform.type, integer);
+    const GLint location = uniform.location;
+    if (!components || integer != std::is_same_v<T, GLint> ||
+        location == -1 || location == shader->uniforms.transform ||
+        location == shader->uniforms.texture ||
+        location == shader->uniforms.textureView || count == 0 ||
+        count % components || count / components > (size_t)uniform.size)
+      return false;
+
+    ShaderParameter_ &parameter = info.parameters[index];
+    std::vector<T> *value;
+    if constexpr (std::is_same_v<T, GLint>)
+      value = &parameter.ints;
+    else
+      value = &parameter.floats;
+    if (value->size() == count &&
+        std::equal(values, values + count, value->begin()))
+      return true;
+    value->assign(values, values + count);
+    parameter.dirty = info.parametersDirty = true;
+    return true;
+  }
+  return false;
+}
+
+void WindowImpl_::cullSprites() {
+  const Frustum_ frustum(cameraMatrix);
+  const Bounds area = frustumBounds_(cameraMatrix);
+
+  queryScratch.clear();
+  spriteGrid.query(glm::vec2(area.min), glm::vec2(area.max), queryScratch);
+  if (spriteVisibleFrame.size() < spriteCaches.size())
+    spriteVisibleFrame.resize(spriteCaches.size());
+  jobs->parallelFor(queryScratch.size(), 4096, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const uint32_t index = queryScratch[i];
+      if (frustum.intersects(spriteGrid.getBounds(index)))
+        spriteVisibleFrame[index] = frameStats.frame + 1;
+    }
+  });
+}
+
+TileLayer *WindowImpl_::tileLayer(TilemapHandle tilemap, size_t layer) {
+  if (!tilemaps.get(tilemap) || layer >= tileLayers[tilemap.index].size())
+    return nullptr;
+  return &tileLayers[tilemap.index][layer];
+}
+
+// Finds the chunks of every tilemap layer the camera can see.
+// Chunks are rebuilt here rather than while drawing, since that changes the
+// GL_ARRAY_BUFFER binding the instance data is streamed through.
+void WindowImpl_::prepareTilemaps() {
+  tileLayerDraws.clear();
+  tileChunkDraws.clear();
+  const Bounds area = frustumBounds_(cameraMatrix);
+
+  for (size_t i = 0; i < tilemaps.size(); ++i) {
+    const Tilemap &tilemap = tilemaps.data()[i];
+    const Shader *shader = shaders.get(tilemap.shader);
+    Texture *texture = textures.get(tilemap.texture);
+    if (!shader || !texture || tilemap.tileSize.x == 0 ||
+        tilemap.tileSize.y == 0)
+      continue;
+    markDrawn(tilemap.texture, *texture);
+
+    // tiles in view, the whole map without culling
+    glm::vec2 first(0), last(tilemap.size);
+    if (culling) {
+      const glm::vec2 origin(tilemap.position);
+      const glm::vec2 a = (glm::vec2(area.min) - origin) / tilemap.tileSize;
+      const glm::vec2 b = (glm::vec2(area.max) - origin) / tilemap.tileSize;
+      first = glm::clamp(glm::floor(glm::min(a, b)), first, last);
+      last = glm::clamp(glm::floor(glm::max(a, b)) + 1.0f, first, last);
+    }
+    const glm::ivec2 firstChunk = glm::ivec2(first) / TileLayer::chunkSize;
+    const glm::ivec2 endChunk =
+        (glm::ivec2(last) + TileLayer::chunkSize - 1) / TileLayer::chunkSize;
+
+    std::vector<TileLayer> &layers = tileLayers[tilemaps.handleAt(i).index];
+    for (TileLayer &layer : layers) {
+      TileLayerDraw_ draw = {tilemap.position.z + layer.depth,
+                             &tilemap,
+                             shader,
+                             texture,
+                             tileChunkDraws.size(),
+                             0};
+      for (int y = firstChunk.y; y < endChunk.y; ++y) {
+        for (int x = firstChunk.x; x < endChunk.x; ++x) {
+          const GLsizei count = layer.prepare({x, y}, tilemap.atlasSize,
+                                              tileIndexBuffer, glState);
+          if (count)
+            tileChunkDraws.push_back({layer.getVertexArray({x, y}), count});
+        }
+      }
+      draw.chunksEnd = tileChunkDraws.size();
+      if (draw.chunksEnd > draw.chunksBegin)
+        tileLayerDraws.push_back(draw);
+    }
+  }
+}
+
+// state shared by everything drawn with a shader and texture, redundant calls
+// are dropped by `glState` and only issued ones are counted
+void WindowImpl_::bindMaterial(ShaderHandle handle, const Shader &shader,
+                               GLuint texture) {
+  FrameStats &stats = frameStats;
+  stats.programBinds += glState.useProgram(shader.id);
+  ShaderInfo_ &info = shaderInfos[handle.index];
+  if (info.parametersDirty)
+    stats.uniformUploads += uploadParameters_(info);
+  stats.textureBinds += glState.bindTexture(0, texture);
+  if (shader.uniforms.texture != -1)
+    stats.uniformUploads += glState.uniform1i(shader.uniforms.texture, 0);
+  glState.setPolygonMode(shader.line ? GL_LINE : GL_FILL);
+}
+
+void WindowImpl_::drawTileLayer(const TileLayerDraw_ &draw) {
+  FrameStats &stats = frameStats;
+  const Tilemap &tilemap = *draw.tilemap;
+  const Shader &shader = *draw.shader;
+  const Texture &texture = *draw.texture;
+  bindMaterial(tilemap.shader, shader, texture.id);
+
+  if (shader.uniforms.transform != -1) {
+    glm::mat4 model = glm::mat4(1.0f);
+    model[0][0] = tilemap.tileSize.x;
+    model[1][1] = tilemap.tileSize.y;
+    model[3] = glm::vec4(glm::vec2(tilemap.position), draw.z, 1.0f);
+    stats.uniformUploads += glState.uniformMatrix4fv(
+        shader.uniforms.transform,
+        shader.cameraBlock ? model : cameraMatrix * model);
+  }
+  if (shader.uniforms.textureView != -1) {
+    stats.uniformUploads += glState.uniform4f(
+        shader.uniforms.textureView,
+        {texture.region.position, texture.region.scale});
+  }
+
+  for (size_t i = draw.chunksBegin; i < draw.chunksEnd; ++i) {
+    glState.bindVertexArray(tileChunkDraws[i].vao);
+    glDrawElements(GL_TRIANGLES, tileChunkDraws[i].indexCount,
+                   GL_UNSIGNED_SHORT, nullptr);
+    glDebug.checkCall();
+    ++stats.drawCalls;
+    ++stats.tileChunksDrawn;
+  }
+}
+
+AssetPack *WindowImpl_::assetPack(PackHandle pack) {
+  return packs.get(pack) ? packFiles[pack.index].get() : nullptr;
+}
+
+FontFace *WindowImpl_::fontFace(FontHandle font) {
+  return fonts.get(font) ? fontFaces[font.index].get() : nullptr;
+}
+
+// Lays out changed texts, moves new glyphs to the font atlases and finds the
+// texts in view. Glyphs a text adds can grow an atlas and move the glyphs of
+// texts laid out before it, which are laid out again after the upload.
+void WindowImpl_::prepareTexts() {
+  textDraws.clear();
+  for (size_t i = 0; i < texts.size(); ++i) {
+    const Text &text = texts.data()[i];
+    FontFace *font = fontFace(text.font);
+    if (font && shaders.get(text.shader))
+      textBlocks[texts.handleAt(i).index].layout(text.font, *font);
+  }
+  for (const std::unique_ptr<FontFace> &font : fontFaces)
+    if (font)
+      font->upload(glState);
+
+  const Frustum_ frustum(cameraMatrix);
+  for (size_t i = 0; i < texts.size(); ++i) {
+    const Text &text = texts.data()[i];
+    FontFace *font = fontFace(text.font);
+    const Shader *shader = shaders.get(text.shader);
+    if (!font || !shader)
+      continue;
+
+    TextBlock &block = textBlocks[texts.handleAt(i).index];
+    block.layout(text.font, *font); // only if an atlas grew
+    if (culling &&
+        !frustum.intersects(textBounds_(text, font->getMetrics().ascent,
+                                        block.getExtent())))
+      continue;
+    const GLsizei count = block.prepare(glState);
+    if (count) {
+      textDraws.push_back({text.position.z, &text, shader, font->getTexture(),
+                           block.getVertexArray(), count});
+    }
+  }
+}
+
+void WindowImpl_::drawText(const TextDraw_ &draw) {
+  FrameStats &stats = frameStats;
+  const Text &text = *draw.text;
+  const Shader &shader = *draw.shader;
+  bindMaterial(text.shader, shader, draw.texture);
+
+  if (shader.uniforms.transform != -1) {
+    glm::mat4 model = glm::mat4_cast(text.rotation);
+    model[0] *= text.size;
+    model[1] *= text.size;
+    model[2] *= text.size;
+    model[3] = glm::vec4(text.position, 1.0f);
+    stats.uniformUploads += glState.uniformMatrix4fv(
+        shader.uniforms.transform,
+        shader.cameraBlock ? model : cameraMatrix * model);
+  }
+  if (shader.uniforms.color != -1) {
+    stats.uniformUploads +=
+        glState.uniform4f(shader.uniforms.color, text.color);
+  }
+
+  glState.bindVertexArray(draw.vao);
+  glDrawArrays(GL_TRIANGLES, 0, draw.vertexCount);
+  glDebug.checkCall();
+  ++stats.drawCalls;
+  ++stats.textsDrawn;
+}
+
+ParticleBuffers *WindowImpl_::particles(ParticleEmitterHandle emitter) {
+  return particleEmitters.get(emitter) ? particleBuffers[emitter.index].get()
+                                       : nullptr;
+}
+
+// Steps every emitter by `particleDelta` on the gpu, whether it is in view or
+// not, since nothing on the cpu knows where its particles are. Costs the same
+// few calls per emitter however many particles it has.
+void WindowImpl_::prepareParticles() {
+  particleDraws.clear();
+  if (!particleSimulator.isReady())
+    return;
+  // one seed per frame, the shader mixes in the particle
+  const uint32_t seed = (uint32_t)frameStats.frame;
+  for (size_t i = 0; i < particleEmitters.size(); ++i) {
+    const ParticleEmitter &emitter = particleEmitters.data()[i];
+    ParticleBuffers &buffers =
+        *particleBuffers[particleEmitters.handleAt(i).index];
+    particleSimulator.simulate(emitter, buffers, particleDelta, seed + i,
+                               glState);
+    frameStats.particlesSimulated += buffers.getCapacity();
+
+    const Shader *shader = shaders.get(emitter.shader);
+    Texture *texture = textures.get(emitter.texture);
+    if (!shader || !texture || shader->vertexCount < 3)
+      continue;
+    markDrawn(emitter.texture, *texture);
+    particleDraws.push_back({emitter.position.z, &emitter, shader, texture,
+                             buffers.getRenderVertexArray(),
+                             (GLsizei)buffers.getCapacity()});
+  }
+}
+
+void WindowImpl_::drawParticles(const ParticleDraw_ &draw) {
+  FrameStats &stats = frameStats;
+  const Shader &shader = *draw.shader;
+  const Texture &texture = *draw.texture;
+  bindMaterial(draw.emitter->shader, shader, texture.id);
+
+  // particles are in world space already
+  if (shader.uniforms.transform != -1) {
+    stats.uniformUploads += glState.uniformMatrix4fv(
+        shader.uniforms.transform,
+        shader.cameraBlock ? glm::mat4(1.0f) : cameraMatrix);
+  }
+  if (shader.uniforms.textureView != -1) {
+    stats.uniformUploads += glState.uniform4f(
+        shader.uniforms.textureView,
+        {texture.region.position, texture.region.scale});
+  }
+
+  // dead particles have size 0 and no area
+  glState.bindVertexArray(draw.vao);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, shader.vertexCount,
+                        draw.instanceCount);
+  glDebug.checkCall();
+  ++stats.drawCalls;
+}
+
+// Merges the layers of every kind by depth. The sort is stable, so at the
+// same depth tilemap layers come before texts and texts before particles,
+// each in the order they were prepared in.
+void WindowImpl_::sortLayers() {
+  layerDraws.clear();
+  for (size_t i = 0; i < tileLayerDraws.size(); ++i)
+    layerDraws.push_back({tileLayerDraws[i].z, LayerKind_::TileLayer, i});
+  for (size_t i = 0; i < textDraws.size(); ++i)
+    layerDraws.push_back({textDraws[i].z, LayerKind_::Text, i});
+  for (size_t i = 0; i < particleDraws.size(); ++i)
+    layerDraws.push_back({particleDraws[i].z, LayerKind_::Particles, i});
+  std::stable_sort(
+      layerDraws.begin(), layerDraws.end(),
+      [](const LayerDraw_ &a, const LayerDraw_ &b) { return a.z < b.z; });
+}
+
+void WindowImpl_::drawLayer(const LayerDraw_ &draw) {
+  switch (draw.kind) {
+  case LayerKind_::TileLayer:
+    drawTileLayer(tileLayerDraws[draw.index]);
+    break;
+  case LayerKind_::Text:
+    drawText(textDraws[draw.index]);
+    break;
+  case LayerKind_::Particles:
+    drawParticles(particleDraws[draw.index]);
+    break;
+  }
 }
 
-std::string getGlfwError_() {
-  const char *description;
-  glfwGetError(&description);
-  return description;
-}
+// tilemap layers, texts and particles are drawn in between the sprites, by
+// depth
+void WindowImpl_::drawSprites(Stopwatch_ &stopwatch) {
+  FrameStats &stats = frameStats;
+
+  generateAtlasMips();
+  sortSprites();
+  stats.cpuTime.sort = stopwatch.lap();
+
+  updateSprites();
+  if (culling)
+    cullSprites();
+  stats.cpuTime.cull = stopwatch.lap();
+
+  // sprites whose shader or texture was deleted are skipped
+  auto &items = drawItems;
+  items.clear();
+  instanceItems.clear();
+  clipTransforms.clear();
+  modelTransforms.clear();
+  for (const SortEntry_ &entry : drawOrder) {
+    if (culling && spriteVisibleFrame[entry.sprite.index] != stats.frame + 1) {
+      ++stats.spritesCulled;
+      continue;
+    }
+    const Sprite *sprite = sprites.get(entry.sprite);
+    const Shader *shader = shaders.get(sprite->shader);
+    Texture *texture = textures.get(sprite->texture.source);
+    if (!shader || !texture)
+      continue;
+    markDrawn(sprite->texture.source, *texture);
+
+    // all instanced sprites of the frame go to the gpu in a single upload
+    if (shader->instanced) {
+      if (spriteCaches[entry.sprite.index].clipVersion !=
+          clipVersion(*shader)) {
+        TransformBatch_ &batch =
+            shader->cameraBlock ? modelTransforms : clipTransforms;
+        batch.slots.push_back(entry.sprite.index);
+        batch.targets.push_back(instanceItems.size());
+      }
+      instanceItems.push_back(items.size());
+    }
+    items.push_back({entry.sprite.index, sprite, shader, texture});
+  }
 
-glm::mat4 computeTransformMatrix(const gtamfx::Sprite *sprite,
-                                 const gtamfx::Camera *camera) {
-  glm::mat4 model = glm::mat4(1.0f);
-  model *= glm::translate(glm::mat4(1.0f), sprite->position);
-  model *= glm::mat4_cast(sprite->rotation);
-  model *= glm::scale(glm::mat4(1.0f), sprite->scale);
+  instances.resize(instanceItems.size());
+  jobs->parallelFor(instances.size(), 2048, [this](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const DrawItem_ &item = drawItems[instanceItems[i]];
+      // stale clip matrices are overwritten by `transformInstances`
+      instances[i] = {spriteCaches[item.slot].clip,
+                      textureView_(item.sprite, item.texture),
+                      item.sprite->color};
+    }
+  });
+
+  transformBatch(clipTransforms, cameraMatrix, cameraVersion);
+  transformBatch(modelTransforms, glm::mat4(1.0f), modelOnlyVersion_);
+  prepareTilemaps();
+  prepareTexts();
+  prepareParticles();
+  sortLayers();
+
+  stats.cpuTime.transform = stopwatch.lap();
+
+  size_t instanceOffset = 0;
+  if (!instances.empty()) {
+    const size_t bytes = instances.size() * sizeof(SpriteInstance_);
+    std::memcpy(instanceStream.map(bytes, instanceOffset), instances.data(),
+                bytes);
+    instanceStream.unmap();
+  }
 
-  glm::mat4 view = glm::mat4(1.0f);
-  view *= glm::mat4_cast(glm::conjugate(camera->rotation));
-  view *= glm::translate(glm::mat4(1.0f), -camera->position);
+  // depth of the next layer to draw
+  size_t layer = 0;
+  auto nextLayerZ = [&] {
+    return layer < layerDraws.size() ? layerDraws[layer].z : INFINITY;
+  };
+  // draws the layers up to and including depth `z`
+  auto drawLayers = [&](float z) {
+    while (layer < layerDraws.size() && layerDraws[layer].z <= z)
+      drawLayer(layerDraws[layer++]);
+  };
+
+  size_t instance = 0;
+  for (size_t index = 0; index < items.size();) {
+    const Sprite *sprite = items[index].sprite;
+    const Shader *shader = items[index].shader;
+    const Texture *texture = items[index].texture;
+
+    drawLayers(sprite->position.z);
+    bindMaterial(sprite->shader, *shader, texture->id);
+    glState.bindVertexArray(vao);
+
+    if (shader->instanced) {
+      // batches end where a layer goes in between
+      const float end = nextLayerZ();
+      size_t count = 1;
+      while (index + count < items.size() &&
+             canBatch_(items[index], items[index + count]) &&
+             items[index + count].sprite->position.z < end)
+        ++count;
+
+      setInstanceOffset_(instanceOffset + instance * sizeof(SpriteInstance_));
+      drawSprites_(shader, count);
+      glDebug.checkCall();
+      ++stats.drawCalls;
+      stats.spritesDrawn += count;
+
+      instance += count;
+      index += count;
+      continue;
+    }
 
-  glm::mat4 projection;
-  switch (camera->type) {
-  case gtamfx::CameraType::Orthographic:
-    projection =
-        glm::ortho(camera->orthographic.size.x * camera->orthographic.left,
-                   camera->orthographic.size.x * camera->orthographic.right,
-                   camera->orthographic.size.y * camera->orthographic.bottom,
-                   camera->orthographic.size.y * camera->orthographic.top);
-    break;
-  case gtamfx::CameraType::Perspective:
-    projection =
-        glm::perspective(camera->perspective.fov, camera->perspective.aspect,
-                         camera->perspective.zNear, camera->perspective.zFar);
-    break;
-  default:
-    projection = glm::mat4(1.0f);
+    if (shader->uniforms.transform != -1) {
+      const glm::mat4 &clip = clipMatrix(items[index].slot, *sprite, *shader);
+      stats.uniformUploads +=
+          glState.uniformMatrix4fv(shader->uniforms.transform, clip);
+    }
+
+    if (shader->uniforms.textureView != -1) {
+      stats.uniformUploads += glState.uniform4f(
+          shader->uniforms.textureView, textureView_(sprite, texture));
+    }
+
+    // fprintf(stderr, "Drawing %zu vertex(es), %zu element(s)\n",
+    //   shader->vertexCount,
+    //   shader->vertexCount < 2 ? 0 : shader->vertexCount - 2
+    // );
+
+    if (shader->vertexCount >= 3) {
+      glDrawArrays(GL_TRIANGLE_STRIP, 0, shader->vertexCount);
+    } else if (shader->vertexCount == 2) {
+      glDrawArrays(GL_LINES, 0, 2);
+    }
+    glDebug.checkCall();
+    ++stats.drawCalls;
+    ++stats.spritesDrawn;
+    ++index;
   }
+  drawLayers(INFINITY);
+}
 
-  return projection * view * model;
+// Each frame is timed with its own query, results are only read once the gpu
+// says they are available so nothing ever waits on it.
+void WindowImpl_::beginGpuTimer() {
+  TimerQuery_ &query = timerQueries[nextTimerQuery];
+  if (query.pending)
+    return; // gpu is too far behind, this frame goes untimed
+  glBeginQuery(GL_TIME_ELAPSED, query.id);
+  query.frame = frameStats.frame;
+  query.pending = isTiming = true;
 }
-} // namespace
 
-namespace gtamfx {
-struct WindowImpl_ {
-  std::vector<std::unique_ptr<Texture>> textures;
-  std::vector<std::unique_ptr<Sprite>> sprites;
-  std::vector<std::unique_ptr<Shader>> shaders;
-  std::vector<std::unique_ptr<Camera>> cameras;
-  Camera *activeCamera = nullptr;
-  GLFWwindow *window = nullptr;
-  GLuint vao = 0;
+void WindowImpl_::endGpuTimer() {
+  if (!isTiming)
+    return;
+  glEndQuery(GL_TIME_ELAPSED);
+  nextTimerQuery = (nextTimerQuery + 1) % timerQueryCount_;
+  isTiming = false;
+}
 
-  bool didReportNoActiveCamera = false;
-};
+void WindowImpl_::readGpuTimers() {
+  for (TimerQuery_ &query : timerQueries) {
+    if (!query.pending)
+      continue;
+    GLint available = 0;
+    glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      continue;
+
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &nanoseconds);
+    query.pending = false;
+    FrameStats &stats = statsHistory[query.frame % statsHistory.size()];
+    if (stats.frame == query.frame)
+      stats.gpuTime = nanoseconds / 1e6;
+  }
+}
+
+// after the last gl call of an update
+void WindowImpl_::endFrame() {
+  evictTextures();
+  instanceStream.endFrame();
+  uploadStream.endFrame();
+  glDebug.checkFrame();
+}
+
+void WindowImpl_::recordFrameStats() {
+  frameStats.stateChangesFiltered = glState.takeFilteredCount();
+  statsHistory[frameCount % statsHistory.size()] = frameStats;
+  ++frameCount;
+}
 
 void Window::init() {
   impl_ = new WindowImpl_;
 
-  if (!glfwInit())
-    throw Exception{ExceptionType::GlfwFailedInit, getGlfwError_()};
+  int res;
+  if (headless) {
+    impl_->headless = std::make_unique<HeadlessContext>();
+    impl_->headless->init();
+    impl_->headlessStart = std::chrono::steady_clock::now();
+    res = gl3wInit2(&HeadlessContext::getProcAddress);
+  } else {
+    if (!glfwInit())
+      throw Exception{ExceptionType::GlfwFailedInit, getGlfwError_()};
 
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef __APPLE__
-  // glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    // glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-  impl_->window =
-      glfwCreateWindow(size.x, size.y, title.c_str(), nullptr, nullptr);
-  if (!impl_->window)
-    throw Exception{ExceptionType::GlfwFailedCreateWindow, getGlfwError_()};
+    impl_->window =
+        glfwCreateWindow(size.x, size.y, title.c_str(), nullptr, nullptr);
+    if (!impl_->window)
+      throw Exception{ExceptionType::GlfwFailedCreateWindow, getGlfwError_()};
 
-  glfwMakeContextCurrent(impl_->window);
+    glfwMakeContextCurrent(impl_->window);
 
-  // does nothing that stops us from calling this function multiple times
-  int res = gl3wInit2(&glfwGetProcAddress);
+    // does nothing that stops us from calling this function multiple times
+    res = gl3wInit2(&glfwGetProcAddress);
+  }
 
   if (res < 0)
     throw Exception{ExceptionType::Gl3wFailedInit, "?"};
@@ -158,132 +2032,295 @@ void Window::init() {
                     std::to_string(version.major) + "." +
                         std::to_string(version.minor)};
 
+  if (impl_->headless)
+    impl_->headless->createFramebuffer(size);
+
+  // whatever the context had bound before is unknown
+  impl_->glState.invalidate();
+  impl_->glDebug.init();
+  impl_->programCache.init();
+  impl_->textureFormats = getSupportedTextureFormats_();
+
   glGenVertexArrays(1, &impl_->vao);
-  glBindVertexArray(impl_->vao);
+  impl_->glState.bindVertexArray(impl_->vao);
+
+  glGenBuffers(1, &impl_->cameraBuffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, impl_->cameraBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock_), nullptr,
+               GL_DYNAMIC_DRAW);
+  impl_->tileIndexBuffer = TileLayer::newIndexBuffer();
+
+  // 64k bytes are ~700 sprites, the buffers grow to what a frame needs
+  const bool persistent = hasGlExtension("GL_ARB_buffer_storage");
+  impl_->instanceStream.init(GL_ARRAY_BUFFER, 64 << 10, persistent);
+  impl_->uploadStream.init(GL_PIXEL_UNPACK_BUFFER, 1 << 20, persistent);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  for (GLuint location = instanceTransformLocation_;
+       location <= instanceColorLocation_; ++location) {
+    glEnableVertexAttribArray(location);
+    glVertexAttribDivisor(location, 1);
+  }
+  setInstanceOffset_(0);
+
+  for (TimerQuery_ &query : impl_->timerQueries)
+    glGenQueries(1, &query.id);
+
+  const unsigned char placeholder[4] = {128, 128, 128, 255};
+  glGenTextures(1, &impl_->placeholderTexture);
+  impl_->glState.bindTexture(0, impl_->placeholderTexture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               placeholder);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-  glEnable(GL_BLEND);
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  impl_->glState.setBlend(true);
+  impl_->glState.setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 void Window::deinit() {
+  impl_->loader.reset();
+  for (DecodedImage &image : impl_->decodedImages)
+    stbi_image_free(image.pixels);
+  for (TextureUpload_ &upload : impl_->uploads) {
+    glDeleteTextures(1, &upload.id);
+    stbi_image_free(upload.image.pixels);
+  }
+  impl_->decodedImages.clear();
+  impl_->uploads.clear();
+
   for (auto &shader : impl_->shaders) {
-    glDeleteProgram(shader->id);
-    shader->id = 0;
+    glDeleteProgram(shader.id);
+    shader.id = 0;
   }
 
+  for (auto &layers : impl_->tileLayers)
+    for (TileLayer &layer : layers)
+      layer.deinit(impl_->glState);
+  impl_->tileLayers.clear();
+  glDeleteBuffers(1, &impl_->tileIndexBuffer);
+
+  for (TextBlock &block : impl_->textBlocks)
+    block.deinit(impl_->glState);
+  impl_->textBlocks.clear();
+  for (std::unique_ptr<FontFace> &font : impl_->fontFaces)
+    if (font)
+      font->deinit(impl_->glState);
+  impl_->fontFaces.clear();
+
+  for (std::unique_ptr<ParticleBuffers> &buffers : impl_->particleBuffers)
+    if (buffers)
+      buffers->deinit(impl_->glState);
+  impl_->particleBuffers.clear();
+  impl_->particleSimulator.deinit(impl_->glState);
+
   for (auto &texture : impl_->textures) {
-    glDeleteTextures(1, &texture->id);
-    texture->id = 0;
+    if (texture.state == TextureState::Resident && texture.atlasPage < 0)
+      glDeleteTextures(1, &texture.id);
+    texture.id = 0;
+  }
+
+  for (auto &page : impl_->atlasPages) {
+    glDeleteTextures(1, &page.id);
+    page.id = 0;
   }
 
+  glDeleteTextures(1, &impl_->placeholderTexture);
+  impl_->uploadStream.deinit();
+  for (TimerQuery_ &query : impl_->timerQueries)
+    glDeleteQueries(1, &query.id);
+  impl_->instanceStream.deinit();
+  glDeleteBuffers(1, &impl_->cameraBuffer);
   glDeleteVertexArrays(1, &impl_->vao);
+  impl_->glState.invalidate();
+  impl_->glDebug.deinit();
+
+  if (impl_->headless) {
+    impl_->headless->deinit();
+    impl_->headless.reset();
+  } else {
+    glfwDestroyWindow(impl_->window);
+    impl_->window = nullptr;
+    glfwTerminate();
+  }
 
-  glfwDestroyWindow(impl_->window);
-  impl_->window = nullptr;
-  glfwTerminate();
+  // joins the worker threads and frees what is left on the cpu side
+  delete impl_;
+  impl_ = nullptr;
 }
 
 bool Window::shouldClose() const {
+  if (headless)
+    return impl_->headlessShouldClose;
   return glfwWindowShouldClose(impl_->window);
 }
-void Window::close() { return glfwSetWindowShouldClose(impl_->window, true); }
+void Window::close() {
+  if (headless)
+    impl_->headlessShouldClose = true;
+  else
+    glfwSetWindowShouldClose(impl_->window, true);
+}
 void Window::unclose() {
-  return glfwSetWindowShouldClose(impl_->window, false);
+  if (headless)
+    impl_->headlessShouldClose = false;
+  else
+    glfwSetWindowShouldClose(impl_->window, false);
 }
 
 void Window::update(bool depth) {
-  glfwPollEvents();
-  if (!getActiveCamera()) {
+  FrameStats &stats = impl_->frameStats;
+  stats = {};
+  stats.frame = impl_->frameCount;
+  stats.gpuTime = -1;
+  Stopwatch_ stopwatch, total;
+
+  impl_->readGpuTimers();
+  if (!headless)
+    glfwPollEvents();
+  stats.cpuTime.poll = stopwatch.lap();
+  impl_->uploadTextures();
+  stats.cpuTime.upload = stopwatch.lap();
+
+  // long stalls would spawn and kill whole generations of particles at once
+  const float time = getTime();
+  impl_->particleDelta =
+      impl_->particleTimeStep > 0 ? impl_->particleTimeStep
+      : impl_->particleTime < 0   ? 0
+                                  : std::min(time - impl_->particleTime, 0.1f);
+  impl_->particleTime = time;
+
+  Camera *camera = getCamera(getActiveCamera());
+  if (!camera) {
     if (!impl_->didReportNoActiveCamera) {
       fputs("No active camera!\n", stderr);
       impl_->didReportNoActiveCamera = true;
     }
+    impl_->endFrame();
+    stats.cpuTime.total = total.lap();
+    impl_->recordFrameStats();
     return;
   }
 
   impl_->didReportNoActiveCamera = false;
+  impl_->beginGpuTimer();
 
   glClearColor(0.1415f, 0.05f, 0.13f, 1.0f);
 
-  if (depth)
-    glEnable(GL_DEPTH_TEST);
-  else
-    glDisable(GL_DEPTH_TEST);
+  impl_->glState.setDepthTest(depth);
 
   glClear(GL_COLOR_BUFFER_BIT | (depth ? GL_DEPTH_BUFFER_BIT : 0));
 
-  if (!impl_->sprites.size())
-    return;
+  if (impl_->sprites.size() || impl_->tilemaps.size() ||
+      impl_->texts.size() || impl_->particleEmitters.size()) {
+    impl_->updateCameraMatrix(getActiveCamera(), *camera);
+    impl_->drawSprites(stopwatch);
+  }
 
-  GLuint lastProgram = 0, lastTexture = 0;
+  impl_->endGpuTimer();
+  impl_->endFrame();
+  stats.cpuTime.submit += stopwatch.lap();
 
-  std::ranges::sort(
-      impl_->sprites,
-      [](auto s1, auto s2) { return s1->position.z < s2->position.z; },
-      [](auto &e) { return e.get(); });
+  if (!headless)
+    glfwSwapBuffers(impl_->window);
+  stats.cpuTime.swap = stopwatch.lap();
+  stats.cpuTime.total = total.lap();
+  impl_->recordFrameStats();
+}
 
-  for (const auto &sprite : impl_->sprites) {
-    if (sprite->shader->id != lastProgram || lastProgram == 0) {
-      glUseProgram(lastProgram = sprite->shader->id);
-      // fprintf(stderr, "Using program #%u\n", lastProgram);
-    }
+const FrameStats &Window::getFrameStats() const { return impl_->frameStats; }
 
-    if (sprite->texture.source->id != lastTexture || lastTexture == 0) {
-      glActiveTexture(GL_TEXTURE0);
-      glBindTexture(GL_TEXTURE_2D, lastTexture = sprite->texture.source->id);
-      // fprintf(stderr, "Binding texture #%u\n", lastTexture);
-    }
+size_t Window::getFrameStatsHistory(FrameStats *stats, size_t count) const {
+  const std::vector<FrameStats> &history = impl_->statsHistory;
+  count = std::min({count, history.size(), (size_t)impl_->frameCount});
+  for (size_t i = 0; i < count; ++i) {
+    const uint64_t frame = impl_->frameCount - count + i;
+    stats[i] = history[frame % history.size()];
+  }
+  return count;
+}
 
-    if (sprite->shader->uniforms.transform != -1) {
-      glm::mat4 transform =
-          computeTransformMatrix(sprite.get(), getActiveCamera());
-      glUniformMatrix4fv(sprite->shader->uniforms.transform, 1, GL_FALSE,
-                         glm::value_ptr(transform));
-    }
+StreamStats Window::getStreamStats() const {
+  StreamStats stats{};
+  impl_->instanceStream.addStats(stats);
+  impl_->uploadStream.addStats(stats);
+  return stats;
+}
 
-    if (sprite->shader->uniforms.texture != -1) {
-      glUniform1i(sprite->shader->uniforms.texture, 0);
-    }
+void Window::setFrameStatsHistorySize(size_t frames) {
+  std::vector<FrameStats> recent(frames ? frames : 1);
+  recent.resize(getFrameStatsHistory(recent.data(), recent.size()));
 
-    if (sprite->shader->uniforms.textureView != -1) {
-      glUniform4f(sprite->shader->uniforms.textureView,
-                  sprite->texture.position.x, sprite->texture.position.y,
-                  sprite->texture.scale.x, sprite->texture.scale.y);
-    }
+  std::vector<FrameStats> &history = impl_->statsHistory;
+  history.assign(frames ? frames : 1, FrameStats{});
+  for (const FrameStats &stats : recent)
+    history[stats.frame % history.size()] = stats;
+}
 
-    // fprintf(stderr, "Drawing %zu vertex(es), %zu element(s)\n",
-    //   sprite->shader->vertexCount,
-    //   sprite->shader->vertexCount < 2 ? 0 : sprite->shader->vertexCount - 2
-    // );
+CameraHandle Window::getActiveCamera() const { return impl_->activeCamera; }
+void Window::setActiveCamera(CameraHandle camera) {
+  impl_->activeCamera = camera;
+}
 
-    if (sprite->shader->line)
-      glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    else
-      glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+void Window::setAtlasOptions(const AtlasOptions &options) {
+  impl_->atlasOptions = options;
+}
 
-    if (sprite->shader->vertexCount >= 3) {
-      glDrawArrays(GL_TRIANGLE_STRIP, 0, sprite->shader->vertexCount);
-    } else if (sprite->shader->vertexCount == 2) {
-      glDrawArrays(GL_LINES, 0, 2);
-    }
-    reportGlErrors_();
+AtlasStats Window::getAtlasStats() const {
+  AtlasStats stats{};
+  for (const AtlasPage_ &page : impl_->atlasPages) {
+    if (!page.id)
+      continue;
+    const glm::ivec2 size = page.packer.getSize();
+    stats.pageCount += 1;
+    stats.imageCount += page.imageCount;
+    stats.usedPixels += page.usedPixels;
+    stats.totalPixels += (size_t)size.x * size.y;
   }
-  glfwSwapBuffers(impl_->window);
+  return stats;
 }
 
-Camera *Window::getActiveCamera() const { return impl_->activeCamera; }
-void Window::setActiveCamera(Camera *camera) { impl_->activeCamera = camera; }
+// KTX/DDS files keep their format and mip levels and never go into the atlas
+TextureHandle Window::newTexture(const char *path) {
+  if (isTextureFile(path)) {
+    TextureFile file;
+    std::string error;
+    if (!readTextureFile(path, file, error) ||
+        !makeUploadable(file, impl_->textureFormats, error))
+      throw Exception{ExceptionType::TextureLoadFail, error};
+    const GLuint id =
+        impl_->createLevelTexture(file.format, file.levels, file.data.data());
+    const TextureHandle handle = impl_->insertTexture(
+        ownTexture_(id, file.levels[0].size), levelBytes_(file.levels));
+    impl_->textureResidency[handle.index].path = path;
+    return handle;
+  }
 
-Texture *Window::newTexture(const char *path) {
   int width, height, channelCount;
   stbi_set_flip_vertically_on_load(true);
   unsigned char *data = stbi_load(path, &width, &height, &channelCount, 4);
   if (!data)
     throw Exception{ExceptionType::TextureLoadFail, stbi_failure_reason()};
 
+  Texture texture{};
+  texture.size = {width, height};
+  texture.region.position = {0, 0};
+  texture.region.scale = {1, 1};
+  texture.state = TextureState::Resident;
+  texture.atlasPage = -1;
+
+  const AtlasOptions &atlas = impl_->atlasOptions;
+  size_t cellPixels;
+  if (atlas.enabled && width <= atlas.maxImageSize &&
+      height <= atlas.maxImageSize &&
+      impl_->packIntoAtlas(data, {width, height}, texture, cellPixels)) {
+    stbi_image_free(data);
+    const TextureHandle handle = impl_->insertTexture(texture, 0);
+    impl_->textureResidency[handle.index].atlasPixels = cellPixels;
+    return handle;
+  }
+
   GLuint tex;
   glGenTextures(1, &tex);
-  glBindTexture(GL_TEXTURE_2D, tex);
+  impl_->glState.bindTexture(0, tex);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
                GL_UNSIGNED_BYTE, data);
   glGenerateMipmap(GL_TEXTURE_2D);
@@ -295,165 +2332,646 @@ Texture *Window::newTexture(const char *path) {
 
   stbi_image_free(data);
 
-  impl_->textures.push_back(std::make_unique<Texture>());
-  Texture *texture = impl_->textures.back().get();
-  texture->id = tex;
-  texture->size = {width, height};
-  return texture;
+  texture.id = tex;
+  const TextureHandle handle =
+      impl_->insertTexture(texture, mipChainBytes_({width, height}));
+  impl_->textureResidency[handle.index].path = path;
+  return handle;
 }
 
-void Window::delTexture(Texture *texture) {
-  if (texture == NULL)
-    return;
-  size_t index;
-  for (index = 0; index <= impl_->textures.size(); ++index) {
-    if (impl_->textures.size() == index)
-      return;
-    if (impl_->textures[index].get() == texture)
-      break;
+TextureHandle Window::newTextureAsync(const char *path,
+                                     TextureCallback callback) {
+  glm::ivec2 size;
+  if (isTextureFile(path)) {
+    std::string error;
+    if (!readTextureFileSize(path, size, error))
+      throw Exception{ExceptionType::TextureLoadFail, error};
+  } else {
+    int channelCount;
+    if (!stbi_info(path, &size.x, &size.y, &channelCount))
+      throw Exception{ExceptionType::TextureLoadFail, stbi_failure_reason()};
   }
 
-  glDeleteTextures(1, &impl_->textures[index]->id);
-  impl_->textures.erase(impl_->textures.begin() + index);
+  impl_->startLoader();
+
+  Texture texture{};
+  texture.id = impl_->placeholderTexture;
+  texture.size = size;
+  texture.region.position = {0, 0};
+  texture.region.scale = {1, 1};
+  texture.state = TextureState::Loading;
+  texture.atlasPage = -1;
+
+  TextureHandle handle = impl_->insertTexture(texture, 0);
+  impl_->textureResidency[handle.index].path = path;
+  impl_->loader->load(handle, path, std::move(callback));
+  return handle;
 }
 
-Sprite *Window::newSprite(Texture *texture, Shader *shader) {
-  impl_->sprites.push_back(std::make_unique<Sprite>());
-  Sprite *sprite = impl_->sprites.back().get();
-  sprite->texture.source = texture;
-  sprite->texture.position = {0, 0};
-  sprite->texture.scale = {1, 1};
-  sprite->position = {0, 0, 0};
-  sprite->scale = {texture->size.x, texture->size.y, 1};
-  sprite->rotation = glm::identity<glm::quat>();
-  sprite->shader = shader;
-  return sprite;
+void Window::setTextureUploadBudget(size_t bytesPerFrame) {
+  impl_->uploadBudget = bytesPerFrame;
 }
 
-void Window::delSprite(Sprite *sprite) {
-  if (sprite == NULL)
-    return;
-  size_t index;
-  for (index = 0; index <= impl_->sprites.size(); ++index) {
-    if (impl_->sprites.size() == index)
-      return;
-    if (impl_->sprites[index].get() == sprite)
-      break;
+void Window::setTextureBudget(size_t bytes) { impl_->textureBudget = bytes; }
+
+TextureResidencyStats Window::getTextureResidencyStats() const {
+  TextureResidencyStats stats{};
+  stats.budget = impl_->textureBudget;
+  stats.residentBytes = impl_->residentBytes;
+  for (size_t i = 0; i < impl_->textures.size(); ++i) {
+    const TextureHandle handle = impl_->textures.handleAt(i);
+    if (impl_->textureResidency[handle.index].bytes)
+      ++stats.residentCount;
+    if (impl_->textures.data()[i].state == TextureState::Evicted)
+      ++stats.evictedCount;
   }
+  stats.evictions = impl_->evictions;
+  stats.reloads = impl_->reloads;
+  return stats;
+}
 
-  impl_->sprites.erase(impl_->sprites.begin() + index);
+size_t Window::getPendingTextureCount() const {
+  return (impl_->loader ? impl_->loader->getPendingCount() : 0) +
+         impl_->decodedImages.size() + impl_->uploads.size();
 }
 
-Shader *Window::newShader(const char *vertex_source,
-                          const char *fragment_source, size_t vertexCount) {
-  GLuint vshader = glCreateShader(GL_VERTEX_SHADER);
-  glShaderSource(vshader, 1, &vertex_source, NULL);
-  glCompileShader(vshader);
+// uploads of deleted async textures are dropped by `uploadTextures`
+void Window::delTexture(TextureHandle texture) {
+  Texture *data = getTexture(texture);
+  if (!data)
+    return;
 
-  GLint vertex_compiled;
-  glGetShaderiv(vshader, GL_COMPILE_STATUS, &vertex_compiled);
-  if (vertex_compiled != GL_TRUE) {
-    GLchar message[1024];
-    glGetShaderInfoLog(vshader, 1024, NULL, message);
-    throw Exception{ExceptionType::ShaderLoadFail,
-                    "[vertex shader] " + std::string(message)};
+  if (data->state == TextureState::Resident) {
+    if (data->atlasPage >= 0)
+      impl_->releaseFromAtlas(texture);
+    else
+      impl_->deleteTexture(data->id);
   }
+  TextureResidency_ &entry = impl_->textureResidency[texture.index];
+  impl_->residentBytes -= entry.bytes;
+  entry = {};
+  impl_->textures.erase(texture);
+}
 
-  GLuint fshader = glCreateShader(GL_FRAGMENT_SHADER);
-  glShaderSource(fshader, 1, &fragment_source, NULL);
-  glCompileShader(fshader);
+Texture *Window::getTexture(TextureHandle texture) {
+  return impl_->textures.get(texture);
+}
 
-  GLint fragment_compiled;
-  glGetShaderiv(fshader, GL_COMPILE_STATUS, &fragment_compiled);
-  if (fragment_compiled != GL_TRUE) {
-    GLchar message[1024];
-    glGetShaderInfoLog(fshader, 1024, NULL, message);
-    throw Exception{ExceptionType::ShaderLoadFail,
-                    "[fragment shader] " + std::string(message)};
+SpriteHandle Window::newSprite(TextureHandle texture, ShaderHandle shader) {
+  const Texture *source = getTexture(texture);
+  if (!source)
+    throw Exception{ExceptionType::InvalidHandle, "texture"};
+  if (!getShader(shader))
+    throw Exception{ExceptionType::InvalidHandle, "shader"};
+
+  return impl_->insertSprite(newSprite_(texture, source, shader));
+}
+
+void Window::delSprite(SpriteHandle sprite) {
+  if (impl_->sprites.erase(sprite)) {
+    impl_->spriteGrid.erase(sprite.index);
+    impl_->didDeleteSprites = true;
   }
+}
 
-  GLuint program = glCreateProgram();
-  glAttachShader(program, vshader);
-  glAttachShader(program, fshader);
-  glLinkProgram(program);
+Sprite *Window::getSprite(SpriteHandle sprite) {
+  return impl_->sprites.get(sprite);
+}
 
-  GLint program_linked;
-  glGetProgramiv(program, GL_LINK_STATUS, &program_linked);
-  if (program_linked != GL_TRUE) {
-    GLchar message[1024];
-    glGetProgramInfoLog(program, 1024, NULL, message);
-    throw Exception{ExceptionType::ShaderLoadFail,
-                    "[program] " + std::string(message)};
+void Window::newSprites(TextureHandle texture, ShaderHandle shader,
+                        size_t count, SpriteHandle *sprites) {
+  const Texture *source = getTexture(texture);
+  if (!source)
+    throw Exception{ExceptionType::InvalidHandle, "texture"};
+  if (!getShader(shader))
+    throw Exception{ExceptionType::InvalidHandle, "shader"};
+
+  const Sprite sprite = newSprite_(texture, source, shader);
+  for (size_t i = 0; i < count; ++i)
+    sprites[i] = impl_->insertSprite(sprite);
+}
+
+void Window::delSprites(const SpriteHandle *sprites, size_t count) {
+  for (size_t i = 0; i < count; ++i)
+    delSprite(sprites[i]);
+}
+
+SpriteBatchHandle Window::newSpriteBatch(TextureHandle texture,
+                                         ShaderHandle shader, size_t count) {
+  if (!getTexture(texture))
+    throw Exception{ExceptionType::InvalidHandle, "texture"};
+  if (!getShader(shader))
+    throw Exception{ExceptionType::InvalidHandle, "shader"};
+
+  SpriteBatch batch{};
+  batch.texture = texture;
+  batch.shader = shader;
+  SpriteBatchHandle handle = impl_->spriteBatches.insert(std::move(batch));
+  resizeSpriteBatch(handle, count);
+  return handle;
+}
+
+void Window::delSpriteBatch(SpriteBatchHandle batch) {
+  if (!getSpriteBatch(batch))
+    return;
+  resizeSpriteBatch(batch, 0);
+  impl_->spriteBatches.erase(batch);
+}
+
+SpriteBatch *Window::getSpriteBatch(SpriteBatchHandle batch) {
+  return impl_->spriteBatches.get(batch);
+}
+
+void Window::resizeSpriteBatch(SpriteBatchHandle handle, size_t count) {
+  SpriteBatch *batch = getSpriteBatch(handle);
+  if (!batch)
+    throw Exception{ExceptionType::InvalidHandle, "sprite batch"};
+
+  for (size_t i = count; i < batch->sprites.size(); ++i)
+    delSprite(batch->sprites[i]);
+
+  const size_t oldCount = std::min(count, batch->sprites.size());
+  batch->sprites.resize(count);
+  batch->positions.resize(count);
+  batch->scales.resize(count);
+  batch->rotations.resize(count);
+  batch->colors.resize(count);
+  batch->textureViews.resize(count);
+
+  // the texture or shader may be gone by now, the new sprites are skipped
+  // when drawing then
+  const Sprite sprite = newSprite_(batch->texture, getTexture(batch->texture),
+                                   batch->shader);
+  for (size_t i = oldCount; i < count; ++i) {
+    batch->sprites[i] = impl_->insertSprite(sprite);
+    batch->positions[i] = sprite.position;
+    batch->scales[i] = sprite.scale;
+    batch->rotations[i] = sprite.rotation;
+    batch->colors[i] = sprite.color;
+    batch->textureViews[i] = {sprite.texture.position, sprite.texture.scale};
+  }
+}
+
+ShaderHandle Window::newShader(const char *vertex_source,
+                               const char *fragment_source,
+                               size_t vertexCount) {
+  ProgramCache &cache = impl_->programCache;
+  GLuint program = cache.load(vertex_source, fragment_source);
+  if (!program) {
+    program =
+        compileProgram_(vertex_source, fragment_source, cache.isEnabled());
+    cache.store(vertex_source, fragment_source, program);
   }
 
-  glDeleteShader(vshader);
-  glDeleteShader(fshader);
+  Shader shader{};
+  shader.id = program;
+  shader.vertexCount = vertexCount;
+  shader.line = false;
+  shader.instanced = glGetAttribLocation(program, "aTransform") != -1;
+  shader.uniforms.transform = glGetUniformLocation(program, "uTransform");
+  shader.uniforms.texture = glGetUniformLocation(program, "uTexture");
+  shader.uniforms.textureView = glGetUniformLocation(program, "uTextureView");
+  shader.uniforms.color = glGetUniformLocation(program, "uColor");
+
+  ShaderInfo_ info = reflectProgram_(program);
+  shader.cameraBlock =
+      std::any_of(info.blocks.begin(), info.blocks.end(),
+                  [](const ShaderUniformBlock &block) {
+                    return block.name == cameraBlockName_;
+                  });
+  const ShaderHandle handle = impl_->shaders.insert(shader);
+  if (impl_->shaderInfos.size() <= handle.index)
+    impl_->shaderInfos.resize(handle.index + 1);
+  impl_->shaderInfos[handle.index] = std::move(info);
+  return handle;
+}
 
-  impl_->shaders.push_back(std::make_unique<Shader>());
-  Shader *shader = impl_->shaders.back().get();
-  shader->id = program;
-  shader->vertexCount = vertexCount;
-  shader->line = false;
-  shader->uniforms.transform = glGetUniformLocation(program, "uTransform");
-  shader->uniforms.texture = glGetUniformLocation(program, "uTexture");
-  shader->uniforms.textureView = glGetUniformLocation(program, "uTextureView");
-  return shader;
+PackHandle Window::loadPack(const char *path) {
+  auto pack = std::make_unique<AssetPack>(path);
+  const PackHandle handle = impl_->packs.insert(pack->getInfo());
+  if (impl_->packFiles.size() <= handle.index)
+    impl_->packFiles.resize(handle.index + 1);
+  impl_->packFiles[handle.index] = std::move(pack);
+  return handle;
 }
 
-void Window::delShader(Shader *shader) {
-  if (shader == NULL)
+void Window::unloadPack(PackHandle pack) {
+  if (!impl_->assetPack(pack))
     return;
-  size_t index;
-  for (index = 0; index <= impl_->shaders.size(); ++index) {
-    if (impl_->shaders.size() == index)
-      return;
-    if (impl_->shaders[index].get() == shader)
-      break;
+  // evicted textures can't come back once the mapping is gone, and the ones
+  // left resident are never evicted again
+  for (size_t i = 0; i < impl_->textures.size(); ++i) {
+    Texture &texture = impl_->textures.data()[i];
+    const TextureHandle handle = impl_->textures.handleAt(i);
+    if (impl_->textureResidency[handle.index].pack == pack &&
+        (texture.state == TextureState::Evicted ||
+         texture.state == TextureState::Loading))
+      impl_->reloadFromPack(handle, texture);
   }
+  impl_->packFiles[pack.index].reset();
+  impl_->packs.erase(pack);
+}
+
+const Pack *Window::getPack(PackHandle pack) const {
+  return impl_->packs.get(pack);
+}
+
+TextureHandle Window::newTextureFromPack(PackHandle pack, const char *name) {
+  const AssetPack *file = impl_->assetPack(pack);
+  if (!file)
+    throw Exception{ExceptionType::InvalidHandle, "pack"};
+  std::vector<TextureLevel> levels;
+  std::string error;
+  const GLuint id = impl_->uploadPackTexture(*file, name, levels, error);
+  if (!id)
+    throw Exception{ExceptionType::TextureLoadFail, error};
+
+  const TextureHandle handle = impl_->insertTexture(
+      ownTexture_(id, levels[0].size), levelBytes_(levels));
+  TextureResidency_ &entry = impl_->textureResidency[handle.index];
+  entry.path = name;
+  entry.pack = pack;
+  return handle;
+}
+
+ShaderHandle Window::newShaderFromPack(PackHandle pack, const char *name,
+                                       size_t vertexCount) {
+  const AssetPack *file = impl_->assetPack(pack);
+  if (!file)
+    throw Exception{ExceptionType::InvalidHandle, "pack"};
+  const char *vertex, *fragment;
+  if (!file->findShader(name, vertex, fragment))
+    throw Exception{ExceptionType::ShaderLoadFail,
+                    std::string("no shader in the pack named ") + name};
+  return newShader(vertex, fragment, vertexCount);
+}
+
+void Window::setProgramCacheDirectory(const char *path) {
+  impl_->programCache.setDirectory(path ? path : "");
+}
+
+ProgramCacheStats Window::getProgramCacheStats() const {
+  return impl_->programCache.getStats();
+}
+
+void Window::delShader(ShaderHandle shader) {
+  Shader *data = getShader(shader);
+  if (!data)
+    return;
+
+  impl_->glState.forgetProgram(data->id);
+  glDeleteProgram(data->id);
+  impl_->shaders.erase(shader);
+  impl_->shaderInfos[shader.index] = {};
+}
+
+Shader *Window::getShader(ShaderHandle shader) {
+  return impl_->shaders.get(shader);
+}
+
+const std::vector<ShaderUniform> *
+Window::getShaderUniforms(ShaderHandle shader) const {
+  if (!impl_->shaders.get(shader))
+    return nullptr;
+  return &impl_->shaderInfos[shader.index].uniforms;
+}
+
+const std::vector<ShaderUniformBlock> *
+Window::getShaderUniformBlocks(ShaderHandle shader) const {
+  if (!impl_->shaders.get(shader))
+    return nullptr;
+  return &impl_->shaderInfos[shader.index].blocks;
+}
+
+bool Window::setShaderParameter(ShaderHandle shader, const char *name,
+                                const float *values, size_t count) {
+  return impl_->setShaderParameter(shader, name, values, count);
+}
+
+bool Window::setShaderParameter(ShaderHandle shader, const char *name,
+                                const int *values, size_t count) {
+  return impl_->setShaderParameter(shader, name, values, count);
+}
+
+TilemapHandle Window::newTilemap(TextureHandle texture, ShaderHandle shader,
+                                glm::ivec2 size, glm::ivec2 atlasSize,
+                                size_t layerCount) {
+  if (!getTexture(texture))
+    throw Exception{ExceptionType::InvalidHandle, "texture"};
+  if (!getShader(shader))
+    throw Exception{ExceptionType::InvalidHandle, "shader"};
+
+  Tilemap tilemap{};
+  tilemap.texture = texture;
+  tilemap.shader = shader;
+  tilemap.size = glm::clamp(size, 0, maxTilemapSize_);
+  tilemap.atlasSize = atlasSize;
+  tilemap.position = {0, 0, 0};
+  tilemap.tileSize = {1, 1};
+  const TilemapHandle handle = impl_->tilemaps.insert(tilemap);
+  if (impl_->tileLayers.size() <= handle.index)
+    impl_->tileLayers.resize(handle.index + 1);
+  impl_->tileLayers[handle.index].assign(layerCount, TileLayer(tilemap.size));
+  return handle;
+}
+
+void Window::delTilemap(TilemapHandle tilemap) {
+  if (!getTilemap(tilemap))
+    return;
+  for (TileLayer &layer : impl_->tileLayers[tilemap.index])
+    layer.deinit(impl_->glState);
+  impl_->tileLayers[tilemap.index].clear();
+  impl_->tilemaps.erase(tilemap);
+}
+
+Tilemap *Window::getTilemap(TilemapHandle tilemap) {
+  return impl_->tilemaps.get(tilemap);
+}
+
+size_t Window::getTilemapLayerCount(TilemapHandle tilemap) const {
+  if (!impl_->tilemaps.get(tilemap))
+    return 0;
+  return impl_->tileLayers[tilemap.index].size();
+}
+
+void Window::setTile(TilemapHandle tilemap, size_t layer, glm::ivec2 tile,
+                     uint16_t value) {
+  TileLayer *data = impl_->tileLayer(tilemap, layer);
+  if (!data)
+    throw Exception{ExceptionType::InvalidHandle, "tilemap layer"};
+  data->set(tile, value);
+}
+
+uint16_t Window::getTile(TilemapHandle tilemap, size_t layer,
+                         glm::ivec2 tile) const {
+  const TileLayer *data = impl_->tileLayer(tilemap, layer);
+  return data ? data->get(tile) : 0;
+}
+
+void Window::setTiles(TilemapHandle tilemap, size_t layer, glm::ivec2 origin,
+                      glm::ivec2 size, const uint16_t *tiles) {
+  TileLayer *data = impl_->tileLayer(tilemap, layer);
+  if (!data)
+    throw Exception{ExceptionType::InvalidHandle, "tilemap layer"};
+  for (int y = 0; y < size.y; ++y)
+    for (int x = 0; x < size.x; ++x)
+      data->set(origin + glm::ivec2(x, y), tiles[(size_t)y * size.x + x]);
+}
+
+void Window::setTilemapLayerDepth(TilemapHandle tilemap, size_t layer,
+                                  float depth) {
+  TileLayer *data = impl_->tileLayer(tilemap, layer);
+  if (!data)
+    throw Exception{ExceptionType::InvalidHandle, "tilemap layer"};
+  data->depth = depth;
+}
+
+float Window::getTilemapLayerDepth(TilemapHandle tilemap, size_t layer) const {
+  const TileLayer *data = impl_->tileLayer(tilemap, layer);
+  return data ? data->depth : 0;
+}
+
+FontHandle Window::newFont(const char *path, int glyphSize) {
+  auto font =
+      std::make_unique<FontFace>(path, glyphSize, impl_->fontCacheDirectory);
+  const FontHandle handle = impl_->fonts.insert(font->getMetrics());
+  if (impl_->fontFaces.size() <= handle.index)
+    impl_->fontFaces.resize(handle.index + 1);
+  impl_->fontFaces[handle.index] = std::move(font);
+  return handle;
+}
+
+void Window::delFont(FontHandle font) {
+  FontFace *face = impl_->fontFace(font);
+  if (!face)
+    return;
+  face->deinit(impl_->glState);
+  impl_->fontFaces[font.index].reset();
+  impl_->fonts.erase(font);
+}
+
+const Font *Window::getFont(FontHandle font) const {
+  return impl_->fonts.get(font);
+}
+
+void Window::setFontCacheDirectory(const char *path) {
+  impl_->fontCacheDirectory = path ? path : "";
+}
+
+TextHandle Window::newText(FontHandle font, ShaderHandle shader,
+                           const char *string) {
+  if (!getFont(font))
+    throw Exception{ExceptionType::InvalidHandle, "font"};
+  if (!getShader(shader))
+    throw Exception{ExceptionType::InvalidHandle, "shader"};
+
+  Text text{};
+  text.font = font;
+  text.shader = shader;
+  text.position = {0, 0, 0};
+  text.rotation = glm::identity<glm::quat>();
+  text.size = 1;
+  text.color = {1, 1, 1, 1};
+  const TextHandle handle = impl_->texts.insert(text);
+  if (impl_->textBlocks.size() <= handle.index)
+    impl_->textBlocks.resize(handle.index + 1);
+  impl_->textBlocks[handle.index].setString(string ? string : "");
+  return handle;
+}
+
+void Window::delText(TextHandle text) {
+  if (!getText(text))
+    return;
+  impl_->textBlocks[text.index].deinit(impl_->glState);
+  impl_->textBlocks[text.index] = {};
+  impl_->texts.erase(text);
+}
+
+Text *Window::getText(TextHandle text) { return impl_->texts.get(text); }
+
+void Window::setTextString(TextHandle text, const char *string) {
+  if (!getText(text))
+    throw Exception{ExceptionType::InvalidHandle, "text"};
+  impl_->textBlocks[text.index].setString(string ? string : "");
+}
+
+const char *Window::getTextString(TextHandle text) const {
+  if (!impl_->texts.get(text))
+    return nullptr;
+  return impl_->textBlocks[text.index].getString().c_str();
+}
+
+glm::vec2 Window::getTextExtent(TextHandle text) {
+  const Text *data = getText(text);
+  FontFace *font = data ? impl_->fontFace(data->font) : nullptr;
+  if (!font)
+    return {0, 0};
+  TextBlock &block = impl_->textBlocks[text.index];
+  block.layout(data->font, *font);
+  return block.getExtent();
+}
+
+ParticleEmitterHandle Window::newParticleEmitter(TextureHandle texture,
+                                                ShaderHandle shader,
+                                                size_t capacity) {
+  if (!getTexture(texture))
+    throw Exception{ExceptionType::InvalidHandle, "texture"};
+  if (!getShader(shader))
+    throw Exception{ExceptionType::InvalidHandle, "shader"};
+  if (!impl_->particleSimulator.isReady())
+    impl_->particleSimulator.init();
+
+  ParticleEmitter emitter{};
+  emitter.texture = texture;
+  emitter.shader = shader;
+  emitter.rate = 0;
+  emitter.lifetime = 1;
+  emitter.startColor = emitter.endColor = {1, 1, 1, 1};
+  emitter.startSize = emitter.endSize = 1;
+  auto buffers = std::make_unique<ParticleBuffers>(capacity, impl_->glState);
+  const ParticleEmitterHandle handle = impl_->particleEmitters.insert(emitter);
+  if (impl_->particleBuffers.size() <= handle.index)
+    impl_->particleBuffers.resize(handle.index + 1);
+  impl_->particleBuffers[handle.index] = std::move(buffers);
+  return handle;
+}
+
+void Window::delParticleEmitter(ParticleEmitterHandle emitter) {
+  ParticleBuffers *buffers = impl_->particles(emitter);
+  if (!buffers)
+    return;
+  buffers->deinit(impl_->glState);
+  impl_->particleBuffers[emitter.index].reset();
+  impl_->particleEmitters.erase(emitter);
+}
+
+ParticleEmitter *Window::getParticleEmitter(ParticleEmitterHandle emitter) {
+  return impl_->particleEmitters.get(emitter);
+}
 
-  glDeleteProgram(impl_->shaders[index]->id);
-  impl_->shaders.erase(impl_->shaders.begin() + index);
+size_t
+Window::getParticleEmitterCapacity(ParticleEmitterHandle emitter) const {
+  return impl_->particleEmitters.get(emitter)
+             ? impl_->particleBuffers[emitter.index]->getCapacity()
+             : 0;
 }
 
-Camera *Window::newCamera(CameraType type) {
-  impl_->cameras.push_back(std::make_unique<Camera>());
-  Camera *camera = impl_->cameras.back().get();
-  camera->type = type;
-  camera->position = {0, 0, 0};
-  camera->rotation = glm::identity<glm::quat>();
+void Window::emitParticles(ParticleEmitterHandle emitter, size_t count) {
+  ParticleBuffers *buffers = impl_->particles(emitter);
+  if (!buffers)
+    throw Exception{ExceptionType::InvalidHandle, "particle emitter"};
+  buffers->addBurst(count);
+}
+
+void Window::setParticleTimeStep(float seconds) {
+  impl_->particleTimeStep = std::max(seconds, 0.0f);
+}
+
+CameraHandle Window::newCamera(CameraType type) {
+  Camera camera{};
+  camera.type = type;
+  camera.position = {0, 0, 0};
+  camera.rotation = glm::identity<glm::quat>();
   switch (type) {
   case CameraType::Orthographic:
-    camera->orthographic.size = getFramebufferSize();
-    camera->orthographic.left = -0.5f;
-    camera->orthographic.right = 0.5f;
-    camera->orthographic.bottom = -0.5f;
-    camera->orthographic.top = 0.5f;
+    camera.orthographic.size = getFramebufferSize();
+    camera.orthographic.left = -0.5f;
+    camera.orthographic.right = 0.5f;
+    camera.orthographic.bottom = -0.5f;
+    camera.orthographic.top = 0.5f;
     break;
   case CameraType::Perspective:
-    camera->perspective.aspect = getAspectRatio();
-    camera->perspective.fov = 60.0f;
-    camera->perspective.zNear = 0.01f;
-    camera->perspective.zFar = 100.0f;
+    camera.perspective.aspect = getAspectRatio();
+    camera.perspective.fov = 60.0f;
+    camera.perspective.zNear = 0.01f;
+    camera.perspective.zFar = 100.0f;
     break;
   }
-  return camera;
+  return impl_->cameras.insert(camera);
 }
 
-void Window::delCamera(Camera *camera) {
-  if (camera == NULL)
-    return;
-  size_t index;
-  for (index = 0; index <= impl_->cameras.size(); ++index) {
-    if (impl_->cameras.size() == index)
-      return;
-    if (impl_->cameras[index].get() == camera)
-      break;
+void Window::delCamera(CameraHandle camera) { impl_->cameras.erase(camera); }
+
+Camera *Window::getCamera(CameraHandle camera) {
+  return impl_->cameras.get(camera);
+}
+
+void Window::setCulling(bool enabled) { impl_->culling = enabled; }
+
+void Window::setThreadCount(size_t threads) {
+  impl_->jobs = std::make_unique<JobSystem>(
+      threads ? threads : std::thread::hardware_concurrency());
+}
+
+size_t Window::getThreadCount() const {
+  return impl_->jobs->getThreadCount();
+}
+
+void Window::setGlDebugMode(GlDebugMode mode) { impl_->glDebug.setMode(mode); }
+GlDebugMode Window::getGlDebugMode() const { return impl_->glDebug.getMode(); }
+void Window::setGlDebugCallback(GlDebugCallback callback) {
+  impl_->glDebug.setCallback(std::move(callback));
+}
+
+std::vector<SpriteHandle> Window::getSpritesInRect(glm::vec2 min,
+                                                   glm::vec2 max) {
+  impl_->updateSprites();
+  std::vector<uint32_t> &indices = impl_->queryScratch;
+  indices.clear();
+  impl_->spriteGrid.query(glm::min(min, max), glm::max(min, max), indices);
+
+  std::vector<SpriteHandle> result;
+  result.reserve(indices.size());
+  for (uint32_t index : indices)
+    result.push_back(impl_->sprites.handleOfSlot(index));
+  return result;
+}
+
+std::vector<SpriteHandle> Window::getSpritesAtPoint(glm::vec2 point) {
+  std::vector<SpriteHandle> result;
+  for (SpriteHandle handle : getSpritesInRect(point, point)) {
+    const Sprite *sprite = impl_->sprites.get(handle);
+    if (sprite->scale.x == 0 || sprite->scale.y == 0)
+      continue;
+    const glm::vec4 local = glm::inverse(computeModelMatrix_(sprite)) *
+                            glm::vec4(point, sprite->position.z, 1);
+    if (std::abs(local.x) <= 0.5f && std::abs(local.y) <= 0.5f)
+      result.push_back(handle);
   }
 
-  impl_->cameras.erase(impl_->cameras.begin() + index);
+  std::sort(result.begin(), result.end(),
+            [this](SpriteHandle a, SpriteHandle b) {
+              return impl_->sprites.get(a)->position.z >
+                     impl_->sprites.get(b)->position.z;
+            });
+  return result;
+}
+
+glm::vec2 Window::screenToWorld(glm::vec2 position) {
+  const Camera *camera = getCamera(getActiveCamera());
+  if (!camera)
+    throw Exception{ExceptionType::InvalidHandle, "active camera"};
+
+  glm::ivec2 windowSize = size;
+  if (!headless)
+    glfwGetWindowSize(impl_->window, &windowSize.x, &windowSize.y);
+  const glm::vec2 ndc = {position.x / windowSize.x * 2 - 1,
+                         1 - position.y / windowSize.y * 2};
+
+  // the ray through the pixel, intersected with z = 0
+  const glm::mat4 inverse = glm::inverse(computeCameraMatrix_(camera));
+  glm::vec4 near = inverse * glm::vec4(ndc, -1, 1);
+  glm::vec4 far = inverse * glm::vec4(ndc, 1, 1);
+  near /= near.w;
+  far /= far.w;
+  if (near.z == far.z)
+    return glm::vec2(near);
+  return glm::vec2(glm::mix(near, far, near.z / (near.z - far.z)));
 }
 
 glm::vec2 Window::getFramebufferSize() const {
+  if (headless)
+    return size;
   glm::ivec2 size;
   glfwGetFramebufferSize(impl_->window, &size.x, &size.y);
   return size;
@@ -464,18 +2982,42 @@ float Window::getAspectRatio() const {
   return framebufferSize.y / framebufferSize.x;
 }
 
-float Window::getTime() { return glfwGetTime(); }
+float Window::getTime() {
+  if (headless)
+    return std::chrono::duration<float>(std::chrono::steady_clock::now() -
+                                        impl_->headlessStart)
+        .count();
+  return glfwGetTime();
+}
 
 bool Window::isKeyDown(KeyCode key) {
+  if (headless)
+    return false;
   return glfwGetKey(impl_->window, (int)key);
 }
 bool Window::isMouseDown(int button) {
+  if (headless)
+    return false;
   return glfwGetMouseButton(impl_->window, button);
 }
 
 glm::vec2 Window::getMousePosition() {
+  if (headless)
+    return {0, 0};
   glm::dvec2 pos;
   glfwGetCursorPos(impl_->window, &pos.x, &pos.y);
   return pos;
 }
+
+void Window::readPixels(void *pixels) {
+  const glm::ivec2 framebufferSize = getFramebufferSize();
+  // the back buffer is undefined after swapping, windows read what's shown
+  if (!headless)
+    glReadBuffer(GL_FRONT);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, framebufferSize.x, framebufferSize.y, GL_RGBA,
+               GL_UNSIGNED_BYTE, pixels);
+  if (!headless)
+    glReadBuffer(GL_BACK);
+}
 } // namespace gtamfx
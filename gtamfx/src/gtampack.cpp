@@ -0,0 +1,102 @@
+#include "pack.hpp"
+#include "texfile.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+}
+
+// Writes an asset pack for `Window::loadPack`. Usage: gtampack output.pack
+// [-t name image]... [-s name vertex fragment]... KTX/DDS images go in with
+// their format and levels as they are, anything else is decoded to rgba8 with
+// a full mip chain, bottom row first, so nothing is left to do at load time.
+
+namespace {
+void usage_() {
+  fprintf(stderr, "usage: gtampack output.pack [-t name image]... "
+                  "[-s name vertex fragment]...\n");
+  exit(1);
+}
+
+bool readText_(const char *path, std::string &text) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return false;
+  char buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    text.append(buffer, read);
+  const bool failed = ferror(file);
+  fclose(file);
+  return !failed;
+}
+
+bool readImage_(const char *path, gtamfx::TextureFile &file,
+                std::string &error) {
+  if (gtamfx::isTextureFile(path))
+    return gtamfx::readTextureFile(path, file, error);
+
+  glm::ivec2 size;
+  int channelCount;
+  stbi_set_flip_vertically_on_load(true);
+  unsigned char *data = stbi_load(path, &size.x, &size.y, &channelCount, 4);
+  if (!data) {
+    error = stbi_failure_reason();
+    return false;
+  }
+  std::vector<unsigned char> pixels(data, data + (size_t)size.x * size.y * 4);
+  stbi_image_free(data);
+  file = gtamfx::makeRgba8File(std::move(pixels), size);
+  return true;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2)
+    usage_();
+  const char *output = argv[1];
+
+  std::vector<gtamfx::PackAsset> assets;
+  for (int i = 2; i < argc;) {
+    gtamfx::PackAsset asset;
+    if (!strcmp(argv[i], "-t") && i + 2 < argc) {
+      asset.name = argv[i + 1];
+      std::string error;
+      if (!readImage_(argv[i + 2], asset.texture, error)) {
+        fprintf(stderr, "%s: %s\n", argv[i + 2], error.c_str());
+        return 1;
+      }
+      printf("texture %s: %dx%d %s, %zu levels\n", asset.name.c_str(),
+             asset.texture.levels[0].size.x, asset.texture.levels[0].size.y,
+             gtamfx::getFormatName(asset.texture.format),
+             asset.texture.levels.size());
+      i += 3;
+    } else if (!strcmp(argv[i], "-s") && i + 3 < argc) {
+      asset.name = argv[i + 1];
+      for (int j = 2; j < 4; ++j) {
+        if (!readText_(argv[i + j], j == 2 ? asset.vertex : asset.fragment)) {
+          fprintf(stderr, "can't read %s\n", argv[i + j]);
+          return 1;
+        }
+      }
+      printf("shader %s\n", asset.name.c_str());
+      i += 4;
+    } else {
+      usage_();
+    }
+    assets.push_back(std::move(asset));
+  }
+
+  std::string error;
+  if (!gtamfx::AssetPack::write(output, std::move(assets), error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  return 0;
+}
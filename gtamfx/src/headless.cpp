@@ -0,0 +1,147 @@
+#include "headless.hpp"
+
+#include <gtamfx.hpp>
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace gtamfx {
+#ifdef __linux__
+namespace {
+[[noreturn]] void fail_(const char *what) {
+  char code[16];
+  snprintf(code, sizeof(code), "%#x", eglGetError());
+  throw Exception{ExceptionType::HeadlessFailedInit,
+                  std::string(what) + " (" + code + ")"};
+}
+
+bool hasExtension_(const char *extensions, const char *name) {
+  if (!extensions)
+    return false;
+  const size_t length = std::strlen(name);
+  for (const char *at = extensions; (at = std::strstr(at, name)); at += length)
+    if ((at == extensions || at[-1] == ' ') &&
+        (at[length] == ' ' || at[length] == '\0'))
+      return true;
+  return false;
+}
+} // namespace
+
+void HeadlessContext::init() {
+  const char *clientExtensions =
+      eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+  EGLDisplay display = EGL_NO_DISPLAY;
+  if (hasExtension_(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+        eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+      display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                   EGL_DEFAULT_DISPLAY, nullptr);
+  }
+  if (display == EGL_NO_DISPLAY)
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (display == EGL_NO_DISPLAY)
+    fail_("no EGL display");
+
+  EGLint major, minor;
+  if (!eglInitialize(display, &major, &minor))
+    fail_("eglInitialize failed");
+  display_ = display;
+
+  const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (!hasExtension_(extensions, "EGL_KHR_surfaceless_context"))
+    fail_("EGL_KHR_surfaceless_context not supported");
+
+  if (!eglBindAPI(EGL_OPENGL_API))
+    fail_("eglBindAPI(EGL_OPENGL_API) failed");
+
+  // the config is irrelevant as nothing is ever drawn to an EGL surface
+  EGLConfig config = nullptr;
+  if (!hasExtension_(extensions, "EGL_KHR_no_config_context")) {
+    const EGLint configAttributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                       EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                       EGL_NONE};
+    EGLint count;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &count) ||
+        count < 1)
+      fail_("no EGL config");
+  }
+
+  const EGLint contextAttributes[] = {
+      EGL_CONTEXT_MAJOR_VERSION,
+      3,
+      EGL_CONTEXT_MINOR_VERSION,
+      3,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK,
+      EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_NONE,
+  };
+  EGLContext context =
+      eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+  if (context == EGL_NO_CONTEXT)
+    fail_("eglCreateContext failed");
+  context_ = context;
+
+  if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+    fail_("eglMakeCurrent failed");
+}
+
+void HeadlessContext::deinit() {
+  if (framebuffer_) {
+    glDeleteFramebuffers(1, &framebuffer_);
+    glDeleteRenderbuffers(1, &colorBuffer_);
+    glDeleteRenderbuffers(1, &depthBuffer_);
+    framebuffer_ = colorBuffer_ = depthBuffer_ = 0;
+  }
+
+  if (display_) {
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context_)
+      eglDestroyContext(display_, context_);
+    eglTerminate(display_);
+  }
+  display_ = context_ = nullptr;
+}
+
+GL3WglProc HeadlessContext::getProcAddress(const char *name) {
+  return (GL3WglProc)eglGetProcAddress(name);
+}
+#else
+void HeadlessContext::init() {
+  throw Exception{ExceptionType::HeadlessFailedInit,
+                  "headless rendering needs EGL"};
+}
+void HeadlessContext::deinit() {}
+GL3WglProc HeadlessContext::getProcAddress(const char *) { return nullptr; }
+#endif
+
+void HeadlessContext::createFramebuffer(glm::ivec2 size) {
+  glGenRenderbuffers(1, &colorBuffer_);
+  glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+
+  glGenRenderbuffers(1, &depthBuffer_);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.x, size.y);
+
+  glGenFramebuffers(1, &framebuffer_);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, colorBuffer_);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, depthBuffer_);
+
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    throw Exception{ExceptionType::HeadlessFailedInit,
+                    "incomplete framebuffer"};
+
+  glViewport(0, 0, size.x, size.y);
+}
+} // namespace gtamfx
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <GL/gl3w.h>
+#include <glm/glm.hpp>
+
+namespace gtamfx {
+// Offscreen gl 3.3 core context without any window system, using EGL on a
+// surfaceless display (Mesa llvmpipe works). Everything is rendered into a
+// framebuffer object of the window's size instead of a window.
+class HeadlessContext {
+public:
+  // creates the context and makes it current, throws `Exception`
+  void init();
+  // needs the gl functions to be loaded
+  void createFramebuffer(glm::ivec2 size);
+  void deinit();
+
+  static GL3WglProc getProcAddress(const char *name);
+
+  GLuint getFramebuffer() const { return framebuffer_; }
+
+private:
+  void *display_ = nullptr; // EGLDisplay
+  void *context_ = nullptr; // EGLContext
+  GLuint framebuffer_ = 0;
+  GLuint colorBuffer_ = 0, depthBuffer_ = 0;
+};
+} // namespace gtamfx
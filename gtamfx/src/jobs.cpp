@@ -0,0 +1,112 @@
+#include "jobs.hpp"
+
+#include <algorithm>
+
+namespace gtamfx {
+JobSystem::JobSystem(size_t threadCount) {
+  for (size_t i = 0; i < std::max<size_t>(threadCount, 1); ++i)
+    deques_.push_back(std::make_unique<Deque_>());
+  for (size_t i = 1; i < deques_.size(); ++i)
+    threads_.emplace_back(&JobSystem::work_, this, i);
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard lock(sleepMutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread &thread : threads_)
+    thread.join();
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain,
+                            const std::function<void(size_t, size_t)> &body) {
+  grain = std::max<size_t>(grain, 1);
+  if (deques_.size() == 1 || count <= grain) {
+    if (count)
+      body(0, count);
+    return;
+  }
+
+  std::atomic<size_t> pending = 1;
+  run_(0, {&body, 0, count, grain, &pending});
+
+  // help out until the last range is done, the other threads may still be
+  // busy with stolen ones
+  while (pending.load(std::memory_order_acquire)) {
+    Job_ job;
+    if (pop_(0, job) || steal_(0, job))
+      run_(0, job);
+    else
+      std::this_thread::yield();
+  }
+}
+
+void JobSystem::push_(size_t self, const Job_ &job) {
+  {
+    std::lock_guard lock(deques_[self]->mutex);
+    deques_[self]->jobs.push_back(job);
+  }
+  ++queued_;
+  // a thread going to sleep checks `queued_` after counting itself in
+  // `sleeping_`, so one of the two sees the other
+  if (sleeping_) {
+    std::lock_guard lock(sleepMutex_);
+    wake_.notify_one();
+  }
+}
+
+bool JobSystem::pop_(size_t self, Job_ &job) {
+  Deque_ &deque = *deques_[self];
+  std::lock_guard lock(deque.mutex);
+  if (deque.jobs.empty())
+    return false;
+  job = deque.jobs.back();
+  deque.jobs.pop_back();
+  --queued_;
+  return true;
+}
+
+bool JobSystem::steal_(size_t self, Job_ &job) {
+  for (size_t i = 1; i < deques_.size(); ++i) {
+    Deque_ &deque = *deques_[(self + i) % deques_.size()];
+    std::lock_guard lock(deque.mutex);
+    if (deque.jobs.empty())
+      continue;
+    job = deque.jobs.front();
+    deque.jobs.pop_front();
+    --queued_;
+    return true;
+  }
+  return false;
+}
+
+void JobSystem::run_(size_t self, Job_ job) {
+  while (job.end - job.begin > job.grain) {
+    const size_t middle = job.begin + (job.end - job.begin) / 2;
+    job.pending->fetch_add(1, std::memory_order_relaxed);
+    push_(self, {job.body, middle, job.end, job.grain, job.pending});
+    job.end = middle;
+  }
+  (*job.body)(job.begin, job.end);
+  job.pending->fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::work_(size_t self) {
+  for (;;) {
+    Job_ job;
+    if (pop_(self, job) || steal_(self, job)) {
+      run_(self, job);
+      continue;
+    }
+
+    std::unique_lock lock(sleepMutex_);
+    ++sleeping_;
+    wake_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+    --sleeping_;
+    if (stopping_)
+      return;
+  }
+}
+} // namespace gtamfx
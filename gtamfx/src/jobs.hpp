@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gtamfx {
+// Fork-join pool for the cpu side of a frame. Every thread, the one calling
+// `parallelFor` included, owns a deque of ranges: it splits its range in
+// halves, pushing the upper half to the back of its deque and going on with
+// the lower one, and takes work back from the back. Threads that run dry steal
+// from the front of the others' deques, which holds the biggest ranges.
+class JobSystem {
+public:
+  // threads in total, the calling thread counts as one
+  explicit JobSystem(size_t threadCount);
+  ~JobSystem();
+
+  size_t getThreadCount() const { return deques_.size(); }
+
+  // Calls `body(begin, end)` on disjoint ranges covering [0, count), none
+  // longer than `grain`, and returns once all of them did. Runs everything on
+  // the calling thread if the range is small. `body` must not throw, and only
+  // one thread may call this at a time.
+  void parallelFor(size_t count, size_t grain,
+                   const std::function<void(size_t, size_t)> &body);
+
+private:
+  struct Job_ {
+    const std::function<void(size_t, size_t)> *body;
+    size_t begin, end, grain;
+    std::atomic<size_t> *pending;
+  };
+  struct Deque_ {
+    std::mutex mutex;
+    std::deque<Job_> jobs;
+  };
+
+  void push_(size_t self, const Job_ &job);
+  bool pop_(size_t self, Job_ &job);
+  bool steal_(size_t self, Job_ &job);
+  void run_(size_t self, Job_ job);
+  void work_(size_t self);
+
+  std::vector<std::unique_ptr<Deque_>> deques_; // 0 is the calling thread
+  std::atomic<size_t> queued_ = 0;
+  std::atomic<size_t> sleeping_ = 0;
+  std::mutex sleepMutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+} // namespace gtamfx
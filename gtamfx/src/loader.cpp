@@ -0,0 +1,82 @@
+#include "loader.hpp"
+
+extern "C" {
+#include <stb_image.h>
+}
+
+namespace gtamfx {
+TextureLoader::TextureLoader(size_t threadCount, uint32_t formats)
+    : formats_(formats) {
+  for (size_t i = 0; i < threadCount; ++i)
+    threads_.emplace_back(&TextureLoader::work_, this);
+}
+
+TextureLoader::~TextureLoader() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread &thread : threads_)
+    thread.join();
+
+  for (DecodedImage &image : done_)
+    stbi_image_free(image.pixels);
+}
+
+void TextureLoader::load(TextureHandle texture, std::string path,
+                         TextureCallback callback) {
+  {
+    std::lock_guard lock(mutex_);
+    jobs_.push_back({texture, std::move(path), std::move(callback)});
+  }
+  wake_.notify_one();
+}
+
+void TextureLoader::poll(std::vector<DecodedImage> &images) {
+  std::lock_guard lock(mutex_);
+  for (DecodedImage &image : done_)
+    images.push_back(std::move(image));
+  done_.clear();
+}
+
+size_t TextureLoader::getPendingCount() {
+  std::lock_guard lock(mutex_);
+  return jobs_.size() + busy_ + done_.size();
+}
+
+void TextureLoader::work_() {
+  std::unique_lock lock(mutex_);
+  for (;;) {
+    wake_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+    if (stopping_)
+      return;
+
+    Job_ job = std::move(jobs_.front());
+    jobs_.pop_front();
+    ++busy_;
+    lock.unlock();
+
+    DecodedImage image{job.texture, std::move(job.callback), nullptr, nullptr,
+                       {0, 0}, {}};
+    if (isTextureFile(job.path.c_str())) {
+      auto file = std::make_unique<TextureFile>();
+      if (readTextureFile(job.path.c_str(), *file, image.error) &&
+          makeUploadable(*file, formats_, image.error)) {
+        image.size = file->levels[0].size;
+        image.file = std::move(file);
+      }
+    } else {
+      int channelCount;
+      image.pixels = stbi_load(job.path.c_str(), &image.size.x, &image.size.y,
+                               &channelCount, 4);
+      if (!image.pixels)
+        image.error = stbi_failure_reason();
+    }
+
+    lock.lock();
+    --busy_;
+    done_.push_back(std::move(image));
+  }
+}
+} // namespace gtamfx
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "texfile.hpp"
+
+#include <gtamfx.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gtamfx {
+struct DecodedImage {
+  TextureHandle texture;
+  TextureCallback callback;
+  unsigned char *pixels; // rgba8, stbi allocated, nullptr if decoding failed
+  std::unique_ptr<TextureFile> file; // KTX/DDS files instead of `pixels`
+  glm::ivec2 size;
+  std::string error;
+};
+
+// Pool of threads decoding image files. Finished images are picked up by the
+// render thread through `poll`, nothing here touches gl. KTX/DDS files are
+// read as they are, and only transcoded if their format isn't in `formats`
+// (`formatBit`s of what the context can sample).
+class TextureLoader {
+public:
+  TextureLoader(size_t threadCount, uint32_t formats);
+  ~TextureLoader();
+
+  void load(TextureHandle texture, std::string path, TextureCallback callback);
+  // moves the images decoded since the last call into `images`
+  void poll(std::vector<DecodedImage> &images);
+  size_t getPendingCount();
+
+private:
+  struct Job_ {
+    TextureHandle texture;
+    std::string path;
+    TextureCallback callback;
+  };
+
+  void work_();
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<Job_> jobs_;
+  std::vector<DecodedImage> done_;
+  size_t busy_ = 0;
+  bool stopping_ = false;
+  uint32_t formats_;
+  std::vector<std::thread> threads_;
+};
+} // namespace gtamfx
@@ -0,0 +1,340 @@
+#include "pack.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gtamfx {
+namespace {
+constexpr uint32_t formatVersion_ = 1;
+constexpr char magic_[4] = {'G', 'T', 'P', 'K'};
+
+enum Kind_ : uint32_t { KindTexture_ = 0, KindShader_ = 1 };
+
+struct Header_ {
+  char magic[4];
+  uint32_t version;
+  uint32_t entryCount;
+  uint32_t namesBytes; // the names follow the index
+};
+
+struct Entry_ {
+  uint32_t kind;
+  uint32_t format; // `TextureFormat` of textures
+  int32_t width, height; // of the first level
+  uint32_t levelCount;
+  uint32_t name;     // offset into the names
+  uint32_t fragment; // offset of the fragment source into a shader's blob
+  uint32_t reserved;
+  uint64_t offset, bytes; // of the blob, from the start of the file
+};
+
+static_assert(sizeof(Header_) == 16 && sizeof(Entry_) == 48);
+
+constexpr uint32_t maxSize_ = 16384;
+
+bool entryLess_(const Entry_ &entry, uint32_t kind, const char *name,
+                const char *names) {
+  if (entry.kind != kind)
+    return entry.kind < kind;
+  return strcmp(names + entry.name, name) < 0;
+}
+
+// the levels of a texture entry, packed back to back from offset 0
+std::vector<TextureLevel> levels_(const Entry_ &entry) {
+  std::vector<TextureLevel> levels;
+  size_t offset = 0;
+  for (uint32_t i = 0; i < entry.levelCount; ++i) {
+    TextureLevel level;
+    level.size = glm::max(glm::ivec2(entry.width, entry.height) >> (int)i,
+                          glm::ivec2(1));
+    level.offset = offset;
+    level.bytes = getLevelBytes((TextureFormat)entry.format, level.size);
+    offset += level.bytes;
+    levels.push_back(level);
+  }
+  return levels;
+}
+
+bool checkEntry_(const Entry_ &entry, const unsigned char *data, size_t size,
+                 uint32_t namesBytes, std::string &error) {
+  if (entry.name >= namesBytes || entry.offset > size ||
+      entry.bytes > size - entry.offset) {
+    error = "entry out of bounds";
+    return false;
+  }
+  const unsigned char *blob = data + entry.offset;
+  if (entry.kind == KindShader_) {
+    if (entry.bytes == 0 || entry.fragment == 0 ||
+        entry.fragment >= entry.bytes || blob[entry.fragment - 1] != 0 ||
+        blob[entry.bytes - 1] != 0) {
+      error = "broken shader entry";
+      return false;
+    }
+    return true;
+  }
+  if (entry.kind != KindTexture_) {
+    error = "unknown entry kind " + std::to_string(entry.kind);
+    return false;
+  }
+
+  if (entry.format > (uint32_t)TextureFormat::Bc1Rgb || entry.width <= 0 ||
+      entry.height <= 0 || (uint32_t)entry.width > maxSize_ ||
+      (uint32_t)entry.height > maxSize_ || entry.levelCount == 0) {
+    error = "broken texture entry";
+    return false;
+  }
+  uint32_t fullChain = 1;
+  while ((std::max(entry.width, entry.height) >> fullChain) > 0)
+    ++fullChain;
+  if (entry.levelCount > fullChain) {
+    error = "more mip levels than the size has";
+    return false;
+  }
+  const std::vector<TextureLevel> levels = levels_(entry);
+  if (levels.back().offset + levels.back().bytes != entry.bytes) {
+    error = "texture entry has the wrong size";
+    return false;
+  }
+  return true;
+}
+
+size_t align_(size_t offset) {
+  return (offset + AssetPack::blobAlignment - 1) /
+         AssetPack::blobAlignment * AssetPack::blobAlignment;
+}
+} // namespace
+
+AssetPack::AssetPack(const char *path) {
+  auto fail = [&](const std::string &message) {
+    unmap_();
+    throw Exception{ExceptionType::PackLoadFail,
+                    std::string(path) + ": " + message};
+  };
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    fail("can't open");
+  file_ = file;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    fail("can't map");
+  mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_)
+    data_ = (const unsigned char *)MapViewOfFile(mapping_, FILE_MAP_READ, 0,
+                                                 0, 0);
+  if (!data_)
+    fail("can't map");
+  size_ = (size_t)size.QuadPart;
+#else
+  const int file = open(path, O_RDONLY);
+  if (file < 0)
+    fail("can't open");
+  struct stat status;
+  void *data = MAP_FAILED;
+  if (fstat(file, &status) == 0 && status.st_size > 0)
+    data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file,
+                0);
+  close(file); // the mapping keeps the file
+  if (data == MAP_FAILED)
+    fail("can't map");
+  data_ = (const unsigned char *)data;
+  size_ = (size_t)status.st_size;
+#endif
+
+  Header_ header;
+  if (size_ < sizeof(header))
+    fail("not an asset pack");
+  std::memcpy(&header, data_, sizeof(header));
+  if (memcmp(header.magic, magic_, sizeof(magic_)))
+    fail("not an asset pack");
+  if (header.version != formatVersion_)
+    fail("unsupported pack version " + std::to_string(header.version));
+  const size_t indexBytes = (size_t)header.entryCount * sizeof(Entry_);
+  if (size_ - sizeof(header) < indexBytes ||
+      size_ - sizeof(header) - indexBytes < header.namesBytes ||
+      (header.namesBytes && data_[sizeof(header) + indexBytes +
+                                  header.namesBytes - 1] != 0))
+    fail("truncated index");
+
+  const Entry_ *entries = (const Entry_ *)(data_ + sizeof(header));
+  entries_ = entries;
+  names_ = (const char *)(data_ + sizeof(header) + indexBytes);
+  std::string error;
+  for (uint32_t i = 0; i < header.entryCount; ++i) {
+    const Entry_ &entry = entries[i];
+    if (!checkEntry_(entry, data_, size_, header.namesBytes, error))
+      fail(error);
+    // lookups are binary searches
+    if (i > 0 && !entryLess_(entries[i - 1], entry.kind, names_ + entry.name,
+                             names_))
+      fail("index isn't sorted");
+    if (entry.kind == KindTexture_)
+      ++info_.textureCount;
+    else
+      ++info_.shaderCount;
+  }
+  info_.bytes = size_;
+}
+
+AssetPack::~AssetPack() { unmap_(); }
+
+void AssetPack::unmap_() {
+#ifdef _WIN32
+  if (data_)
+    UnmapViewOfFile(data_);
+  if (mapping_)
+    CloseHandle(mapping_);
+  if (file_)
+    CloseHandle(file_);
+  data_ = nullptr;
+  mapping_ = file_ = nullptr;
+#else
+  if (data_)
+    munmap((void *)data_, size_);
+  data_ = nullptr;
+#endif
+}
+
+const void *AssetPack::find_(uint32_t kind, const char *name) const {
+  const Entry_ *begin = (const Entry_ *)entries_;
+  const Entry_ *end = begin + info_.textureCount + info_.shaderCount;
+  const Entry_ *entry =
+      std::lower_bound(begin, end, name, [&](const Entry_ &e, const char *n) {
+        return entryLess_(e, kind, n, names_);
+      });
+  if (entry == end || entry->kind != kind ||
+      strcmp(names_ + entry->name, name))
+    return nullptr;
+  return entry;
+}
+
+bool AssetPack::findTexture(const char *name, TextureData &texture) const {
+  const Entry_ *entry = (const Entry_ *)find_(KindTexture_, name);
+  if (!entry)
+    return false;
+  texture.format = (TextureFormat)entry->format;
+  texture.levels = levels_(*entry);
+  texture.data = data_ + entry->offset;
+  return true;
+}
+
+bool AssetPack::findShader(const char *name, const char *&vertex,
+                           const char *&fragment) const {
+  const Entry_ *entry = (const Entry_ *)find_(KindShader_, name);
+  if (!entry)
+    return false;
+  vertex = (const char *)data_ + entry->offset;
+  fragment = vertex + entry->fragment;
+  return true;
+}
+
+bool AssetPack::write(const char *path, std::vector<PackAsset> assets,
+                      std::string &error) {
+  auto kind = [](const PackAsset &asset) {
+    return asset.texture.levels.empty() ? KindShader_ : KindTexture_;
+  };
+  std::sort(assets.begin(), assets.end(),
+            [&](const PackAsset &a, const PackAsset &b) {
+              if (kind(a) != kind(b))
+                return kind(a) < kind(b);
+              return a.name < b.name;
+            });
+
+  Header_ header{};
+  std::memcpy(header.magic, magic_, sizeof(magic_));
+  header.version = formatVersion_;
+  header.entryCount = (uint32_t)assets.size();
+
+  std::string names;
+  std::vector<Entry_> entries(assets.size());
+  for (size_t i = 0; i < assets.size(); ++i) {
+    const PackAsset &asset = assets[i];
+    if (asset.name.empty() || asset.name.find('\0') != std::string::npos) {
+      error = "bad asset name";
+      return false;
+    }
+    if (i > 0 && kind(assets[i - 1]) == kind(asset) &&
+        assets[i - 1].name == asset.name) {
+      error = "two assets named " + asset.name;
+      return false;
+    }
+    Entry_ &entry = entries[i];
+    entry.kind = kind(asset);
+    entry.name = (uint32_t)names.size();
+    names += asset.name;
+    names += '\0';
+  }
+  header.namesBytes = (uint32_t)names.size();
+
+  size_t offset = sizeof(header) + entries.size() * sizeof(Entry_) +
+                  names.size();
+  std::vector<std::string> blobs(assets.size());
+  for (size_t i = 0; i < assets.size(); ++i) {
+    const PackAsset &asset = assets[i];
+    Entry_ &entry = entries[i];
+    std::string &blob = blobs[i];
+    if (entry.kind == KindShader_) {
+      if (asset.vertex.find('\0') != std::string::npos ||
+          asset.fragment.find('\0') != std::string::npos) {
+        error = asset.name + ": shader sources can't contain nul";
+        return false;
+      }
+      blob = asset.vertex + '\0' + asset.fragment + '\0';
+      entry.fragment = (uint32_t)asset.vertex.size() + 1;
+    } else {
+      const TextureFile &texture = asset.texture;
+      entry.format = (uint32_t)texture.format;
+      entry.width = texture.levels[0].size.x;
+      entry.height = texture.levels[0].size.y;
+      entry.levelCount = (uint32_t)texture.levels.size();
+      for (const TextureLevel &level : texture.levels)
+        blob.append((const char *)texture.data.data() + level.offset,
+                    level.bytes);
+    }
+    offset = align_(offset);
+    entry.offset = offset;
+    entry.bytes = blob.size();
+    offset += blob.size();
+  }
+
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    error = std::string("can't write ") + path;
+    return false;
+  }
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 fwrite(entries.data(), sizeof(Entry_), entries.size(),
+                        file) == entries.size() &&
+                 fwrite(names.data(), 1, names.size(), file) == names.size();
+  size_t position =
+      sizeof(header) + entries.size() * sizeof(Entry_) + names.size();
+  for (size_t i = 0; i < blobs.size() && written; ++i) {
+    const std::string padding(entries[i].offset - position, '\0');
+    written = fwrite(padding.data(), 1, padding.size(), file) ==
+                  padding.size() &&
+              fwrite(blobs[i].data(), 1, blobs[i].size(), file) ==
+                  blobs[i].size();
+    position = entries[i].offset + entries[i].bytes;
+  }
+  written = fclose(file) == 0 && written;
+  if (!written)
+    error = std::string("can't write ") + path;
+  return written;
+}
+} // namespace gtamfx
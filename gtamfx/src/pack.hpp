@@ -0,0 +1,67 @@
+#pragma once
+
+#include "texfile.hpp"
+
+#include <gtamfx.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gtamfx {
+// An asset as it goes into a pack: a texture with its mip levels, or the
+// sources of a shader when the texture has no levels.
+struct PackAsset {
+  std::string name;
+  TextureFile texture;
+  std::string vertex, fragment;
+};
+
+// A pack file mapped read only into memory. It starts with a header and an
+// index of entries sorted by kind and name, followed by their names and then
+// by the blobs, each at a multiple of `blobAlignment`: the mip levels of a
+// texture back to back (largest first, bottom row first, ready for gl), or the
+// vertex and fragment source of a shader, both nul terminated. Textures are
+// uploaded straight from the mapping, so only the pages that are used are ever
+// read from disk, and nothing is decoded or copied on the way.
+class AssetPack {
+public:
+  static constexpr size_t blobAlignment = 256;
+
+  struct TextureData {
+    TextureFormat format;
+    std::vector<TextureLevel> levels; // offsets are into `data`
+    const unsigned char *data;        // points into the mapping
+  };
+
+  // maps the file and checks its index, throws PackLoadFail
+  explicit AssetPack(const char *path);
+  ~AssetPack();
+  AssetPack(const AssetPack &) = delete;
+  AssetPack &operator=(const AssetPack &) = delete;
+
+  const Pack &getInfo() const { return info_; }
+  // false if the pack has no texture or shader of that name
+  bool findTexture(const char *name, TextureData &texture) const;
+  bool findShader(const char *name, const char *&vertex,
+                  const char *&fragment) const;
+
+  // names have to be unique per kind, the order of `assets` doesn't matter
+  static bool write(const char *path, std::vector<PackAsset> assets,
+                    std::string &error);
+
+private:
+  const void *find_(uint32_t kind, const char *name) const;
+  void unmap_();
+
+  const unsigned char *data_ = nullptr;
+  size_t size_ = 0;
+  const void *entries_ = nullptr;
+  const char *names_ = nullptr;
+  Pack info_{};
+#ifdef _WIN32
+  void *file_ = nullptr, *mapping_ = nullptr;
+#endif
+};
+} // namespace gtamfx
@@ -0,0 +1,246 @@
+#include "particles.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace gtamfx {
+namespace {
+// one particle as the simulation writes it, interleaved in the order of
+// `varyings_`
+struct Particle_ {
+  glm::vec3 position;
+  glm::vec3 velocity;
+  glm::vec2 life; // age and lifetime in seconds, dead once age >= lifetime
+  glm::vec4 color;
+  float size; // 0 for dead particles
+};
+
+constexpr const char *varyings_[] = {"oPosition", "oVelocity", "oLife",
+                                     "oColor", "oSize"};
+
+// inputs of the simulation
+constexpr GLuint simulationPositionLocation_ = 0;
+constexpr GLuint simulationVelocityLocation_ = 1;
+constexpr GLuint simulationLifeLocation_ = 2;
+
+const char *simulationSource_ = R"(#version 330 core
+in vec3 iPosition;
+in vec3 iVelocity;
+in vec2 iLife;
+
+out vec3 oPosition;
+out vec3 oVelocity;
+out vec2 oLife;
+out vec4 oColor;
+out float oSize;
+
+uniform float uDelta;
+uniform uint uSeed;
+uniform int uCapacity;
+uniform int uSpawnBegin;
+uniform int uSpawnCount;
+uniform vec3 uPosition;
+uniform vec3 uPositionSpread;
+uniform vec3 uVelocity;
+uniform vec3 uVelocitySpread;
+uniform vec3 uAcceleration;
+uniform vec2 uLifetime; // seconds and spread
+uniform vec4 uStartColor;
+uniform vec4 uEndColor;
+uniform vec2 uSize; // start and end
+
+uint hash(uint x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+// 0..1, different for every particle, step and `n`
+float random(uint n) {
+  return float(hash(uint(gl_VertexID) * 8u + n + hash(uSeed)) >> 8) /
+         16777216.0;
+}
+
+vec3 random3(uint n) {
+  return vec3(random(n), random(n + 1u), random(n + 2u)) * 2.0 - 1.0;
+}
+
+void main() {
+  vec3 position = iPosition;
+  vec3 velocity = iVelocity;
+  vec2 life = iLife;
+  if (life.x < life.y) {
+    velocity += uAcceleration * uDelta;
+    position += velocity * uDelta;
+    life.x += uDelta;
+  } else if ((gl_VertexID - uSpawnBegin + uCapacity) % uCapacity <
+             uSpawnCount) {
+    position = uPosition + random3(0u) * uPositionSpread;
+    velocity = uVelocity + random3(3u) * uVelocitySpread;
+    life = vec2(0.0, max(uLifetime.x + (random(6u) * 2.0 - 1.0) * uLifetime.y,
+                         0.001));
+  }
+
+  bool alive = life.x < life.y;
+  float t = alive ? life.x / life.y : 1.0;
+  oPosition = position;
+  oVelocity = velocity;
+  oLife = life;
+  oColor = mix(uStartColor, uEndColor, t);
+  oSize = alive ? mix(uSize.x, uSize.y, t) : 0.0;
+})";
+
+void attribute_(GLuint location, GLint size, size_t offset, GLuint divisor) {
+  glEnableVertexAttribArray(location);
+  glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, sizeof(Particle_),
+                        (const void *)offset);
+  glVertexAttribDivisor(location, divisor);
+}
+} // namespace
+
+ParticleBuffers::ParticleBuffers(size_t capacity, GlState &state)
+    : capacity_(capacity) {
+  const std::vector<Particle_> particles(capacity, Particle_{});
+  glGenBuffers(2, buffers_);
+  glGenVertexArrays(2, simulationVaos_);
+  glGenVertexArrays(2, renderVaos_);
+  for (int i = 0; i < 2; ++i) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffers_[i]);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Particle_),
+                 particles.data(), GL_DYNAMIC_COPY);
+
+    state.bindVertexArray(simulationVaos_[i]);
+    attribute_(simulationPositionLocation_, 3, offsetof(Particle_, position),
+               0);
+    attribute_(simulationVelocityLocation_, 3, offsetof(Particle_, velocity),
+               0);
+    attribute_(simulationLifeLocation_, 2, offsetof(Particle_, life), 0);
+
+    state.bindVertexArray(renderVaos_[i]);
+    attribute_(positionLocation, 3, offsetof(Particle_, position), 1);
+    attribute_(colorLocation, 4, offsetof(Particle_, color), 1);
+    attribute_(sizeLocation, 1, offsetof(Particle_, size), 1);
+  }
+}
+
+void ParticleBuffers::deinit(GlState &state) {
+  for (int i = 0; i < 2; ++i) {
+    state.forgetVertexArray(simulationVaos_[i]);
+    state.forgetVertexArray(renderVaos_[i]);
+  }
+  glDeleteVertexArrays(2, simulationVaos_);
+  glDeleteVertexArrays(2, renderVaos_);
+  glDeleteBuffers(2, buffers_);
+  for (int i = 0; i < 2; ++i)
+    buffers_[i] = simulationVaos_[i] = renderVaos_[i] = 0;
+}
+
+void ParticleBuffers::takeSpawns(float count, int &begin, int &size) {
+  carry_ += std::max(count, 0.0f);
+  const float whole = std::floor(carry_);
+  carry_ -= whole;
+  size = (int)std::min((size_t)whole + burst_, capacity_);
+  burst_ = 0;
+
+  begin = (int)cursor_;
+  cursor_ = capacity_ ? (cursor_ + size) % capacity_ : 0;
+}
+
+void ParticleSimulator::init() {
+  GLuint shader = glCreateShader(GL_VERTEX_SHADER);
+  glShaderSource(shader, 1, &simulationSource_, nullptr);
+  glCompileShader(shader);
+  GLint compiled;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+  if (compiled != GL_TRUE) {
+    GLchar message[1024];
+    glGetShaderInfoLog(shader, 1024, nullptr, message);
+    glDeleteShader(shader);
+    throw Exception{ExceptionType::ShaderLoadFail,
+                    "[particle simulation] " + std::string(message)};
+  }
+
+  // no fragment shader, the rasterizer is off while it runs
+  GLuint program = glCreateProgram();
+  glAttachShader(program, shader);
+  glBindAttribLocation(program, simulationPositionLocation_, "iPosition");
+  glBindAttribLocation(program, simulationVelocityLocation_, "iVelocity");
+  glBindAttribLocation(program, simulationLifeLocation_, "iLife");
+  glTransformFeedbackVaryings(program, std::size(varyings_), varyings_,
+                              GL_INTERLEAVED_ATTRIBS);
+  glLinkProgram(program);
+  glDeleteShader(shader);
+  GLint linked;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (linked != GL_TRUE) {
+    GLchar message[1024];
+    glGetProgramInfoLog(program, 1024, nullptr, message);
+    glDeleteProgram(program);
+    throw Exception{ExceptionType::ShaderLoadFail,
+                    "[particle simulation] " + std::string(message)};
+  }
+
+  program_ = program;
+  auto location = [&](const char *name) {
+    return glGetUniformLocation(program, name);
+  };
+  uniforms_ = {location("uDelta"),           location("uSeed"),
+               location("uCapacity"),        location("uSpawnBegin"),
+               location("uSpawnCount"),      location("uPosition"),
+               location("uPositionSpread"),  location("uVelocity"),
+               location("uVelocitySpread"),  location("uAcceleration"),
+               location("uLifetime"),        location("uStartColor"),
+               location("uEndColor"),        location("uSize")};
+}
+
+void ParticleSimulator::deinit(GlState &state) {
+  if (!program_)
+    return;
+  state.forgetProgram(program_);
+  glDeleteProgram(program_);
+  program_ = 0;
+}
+
+void ParticleSimulator::simulate(const ParticleEmitter &emitter,
+                                 ParticleBuffers &buffers, float delta,
+                                 uint32_t seed, GlState &state) {
+  const size_t capacity = buffers.getCapacity();
+  if (!capacity)
+    return;
+  int spawnBegin, spawnCount;
+  buffers.takeSpawns(emitter.rate * delta, spawnBegin, spawnCount);
+
+  // every value changes from emitter to emitter, so these skip `state`
+  state.useProgram(program_);
+  glUniform1f(uniforms_.delta, delta);
+  glUniform1ui(uniforms_.seed, seed);
+  glUniform1i(uniforms_.capacity, (GLint)capacity);
+  glUniform1i(uniforms_.spawnBegin, spawnBegin);
+  glUniform1i(uniforms_.spawnCount, spawnCount);
+  glUniform3fv(uniforms_.position, 1, &emitter.position[0]);
+  glUniform3fv(uniforms_.positionSpread, 1, &emitter.positionSpread[0]);
+  glUniform3fv(uniforms_.velocity, 1, &emitter.velocity[0]);
+  glUniform3fv(uniforms_.velocitySpread, 1, &emitter.velocitySpread[0]);
+  glUniform3fv(uniforms_.acceleration, 1, &emitter.acceleration[0]);
+  glUniform2f(uniforms_.lifetime, emitter.lifetime, emitter.lifetimeSpread);
+  glUniform4fv(uniforms_.startColor, 1, &emitter.startColor[0]);
+  glUniform4fv(uniforms_.endColor, 1, &emitter.endColor[0]);
+  glUniform2f(uniforms_.size, emitter.startSize, emitter.endSize);
+
+  state.bindVertexArray(buffers.getSimulationVertexArray());
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers.getTarget());
+  glEnable(GL_RASTERIZER_DISCARD);
+  glBeginTransformFeedback(GL_POINTS);
+  glDrawArrays(GL_POINTS, 0, (GLsizei)capacity);
+  glEndTransformFeedback();
+  glDisable(GL_RASTERIZER_DISCARD);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  buffers.swap();
+}
+} // namespace gtamfx
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "glstate.hpp"
+
+#include <gtamfx.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gtamfx {
+// The particles of one emitter, in two buffers the simulation takes turns
+// reading from and writing to, so nothing of them ever goes through the cpu.
+// Particles are spawned into a ring: each step respawns the dead particles in
+// the next `count` slots after the previous step's, spawns falling on a live
+// particle are dropped.
+class ParticleBuffers {
+public:
+  // attribute locations of render shaders, bound by `newShader`
+  static constexpr GLuint positionLocation = 10;
+  static constexpr GLuint colorLocation = 11;
+  static constexpr GLuint sizeLocation = 12;
+
+  // all particles start out dead
+  ParticleBuffers(size_t capacity, GlState &state);
+  void deinit(GlState &state);
+
+  size_t getCapacity() const { return capacity_; }
+  // spawned on top of the emitter's rate by the next step
+  void addBurst(size_t count) { burst_ += count; }
+
+  // Takes the ring range of the next step, `count` particles from the rate
+  // plus the burst. Fractions of particles carry over to the next step.
+  void takeSpawns(float count, int &begin, int &size);
+
+  GLuint getSource() const { return buffers_[current_]; }
+  GLuint getTarget() const { return buffers_[1 - current_]; }
+  // reads the source as vertices for the simulation
+  GLuint getSimulationVertexArray() const { return simulationVaos_[current_]; }
+  // reads the source as instances for rendering
+  GLuint getRenderVertexArray() const { return renderVaos_[current_]; }
+  // the target becomes the source, after a step wrote it
+  void swap() { current_ = 1 - current_; }
+
+private:
+  size_t capacity_;
+  GLuint buffers_[2] = {};
+  GLuint simulationVaos_[2] = {};
+  GLuint renderVaos_[2] = {};
+  int current_ = 0;
+
+  size_t cursor_ = 0; // next slot of the spawn ring
+  float carry_ = 0;   // fraction of a particle left from the last steps
+  size_t burst_ = 0;
+};
+
+// The transform feedback program that advances every particle of an emitter
+// by a time step, integrating live particles and respawning dead ones.
+class ParticleSimulator {
+public:
+  // compiles the program, throws ShaderLoadFail
+  void init();
+  void deinit(GlState &state);
+  bool isReady() const { return program_ != 0; }
+
+  // Writes the next state of `buffers` into its target and swaps it. Changes
+  // the program and vertex array bindings.
+  void simulate(const ParticleEmitter &emitter, ParticleBuffers &buffers,
+                float delta, uint32_t seed, GlState &state);
+
+private:
+  GLuint program_ = 0;
+  struct {
+    GLint delta, seed, capacity, spawnBegin, spawnCount;
+    GLint position, positionSpread, velocity, velocitySpread, acceleration;
+    GLint lifetime, startColor, endColor, size;
+  } uniforms_{};
+};
+} // namespace gtamfx
@@ -0,0 +1,157 @@
+#include "programcache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace gtamfx {
+namespace {
+// bump when anything that goes into a program but not into the key changes,
+// like the attribute locations bound before linking
+constexpr uint32_t formatVersion_ = 4;
+
+struct Header_ {
+  char magic[4];
+  uint32_t version;
+  uint64_t check;
+  uint32_t format; // binary format of the driver
+  uint32_t size;
+};
+
+constexpr char magic_[4] = {'G', 'T', 'P', 'B'};
+// anything bigger is a broken file
+constexpr uint32_t maxBinarySize_ = 64 << 20;
+
+// FNV-1a, `seed` as the offset basis
+uint64_t hash_(uint64_t seed, std::initializer_list<const char *> parts) {
+  uint64_t hash = seed;
+  for (const char *part : parts) {
+    // the terminator separates the parts
+    for (const char *c = part;; ++c) {
+      hash = (hash ^ (unsigned char)*c) * 0x100000001b3;
+      if (!*c)
+        break;
+    }
+  }
+  return hash;
+}
+} // namespace
+
+void ProgramCache::init() {
+  GLint formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  supported_ = formats > 0;
+
+  auto string = [](GLenum name) {
+    const char *value = (const char *)glGetString(name);
+    return std::string(value ? value : "");
+  };
+  driver_ = string(GL_VENDOR) + "\n" + string(GL_RENDERER) + "\n" +
+            string(GL_VERSION);
+}
+
+void ProgramCache::setDirectory(const std::string &directory) {
+  directory_ = directory;
+  if (!directory_.empty()) {
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+  }
+}
+
+GLuint ProgramCache::load(const char *vertex, const char *fragment) {
+  if (!isEnabled())
+    return 0;
+
+  const Key_ key = key_(vertex, fragment);
+  FILE *file = fopen(path_(key).c_str(), "rb");
+  if (!file) {
+    ++stats_.misses;
+    return 0;
+  }
+
+  Header_ header;
+  std::vector<char> binary;
+  bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+               !memcmp(header.magic, magic_, sizeof(magic_)) &&
+               header.version == formatVersion_ && header.check == key.check &&
+               header.size <= maxBinarySize_;
+  if (valid) {
+    binary.resize(header.size);
+    valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+  }
+  fclose(file);
+  // a broken file gets replaced by `store` after the compile
+  if (!valid) {
+    ++stats_.misses;
+    return 0;
+  }
+
+  GLuint program = glCreateProgram();
+  glProgramBinary(program, header.format, binary.data(), binary.size());
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (linked != GL_TRUE) {
+    // the driver changed in a way its version doesn't tell
+    glDeleteProgram(program);
+    ++stats_.rejected;
+    ++stats_.misses;
+    return 0;
+  }
+  ++stats_.hits;
+  return program;
+}
+
+void ProgramCache::store(const char *vertex, const char *fragment,
+                         GLuint program) {
+  if (!isEnabled())
+    return;
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+  std::vector<char> binary(length);
+  GLsizei written = 0;
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &written, &format, binary.data());
+
+  const Key_ key = key_(vertex, fragment);
+  Header_ header = {{}, formatVersion_, key.check, format, (uint32_t)written};
+  memcpy(header.magic, magic_, sizeof(magic_));
+
+  // written next to the final file and renamed, so other processes never see
+  // half of it
+  const std::string path = path_(key);
+  const std::string temporary = path + ".tmp";
+  FILE *file = fopen(temporary.c_str(), "wb");
+  if (!file)
+    return;
+  const bool complete =
+      fwrite(&header, sizeof(header), 1, file) == 1 &&
+      fwrite(binary.data(), 1, written, file) == (size_t)written;
+  if (fclose(file) != 0 || !complete ||
+      std::rename(temporary.c_str(), path.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    return;
+  }
+  ++stats_.stored;
+}
+
+ProgramCache::Key_ ProgramCache::key_(const char *vertex,
+                                      const char *fragment) const {
+  const std::string version = std::to_string(formatVersion_);
+  const std::initializer_list<const char *> parts = {
+      version.c_str(), driver_.c_str(), vertex, fragment};
+  return {hash_(0xcbf29ce484222325, parts), hash_(0x84222325cbf29ce4, parts)};
+}
+
+std::string ProgramCache::path_(const Key_ &key) const {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key.hash);
+  return (std::filesystem::path(directory_) / name).string();
+}
+} // namespace gtamfx
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <gtamfx.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace gtamfx {
+// Linked programs saved with glGetProgramBinary, one file per program named
+// after a hash of its sources and the driver (vendor, renderer and version),
+// since binaries only load on the driver that made them. Best effort: files
+// that can't be read, written or are rejected by the driver only cost the
+// compile they would have saved.
+class ProgramCache {
+public:
+  // needs the gl functions to be loaded
+  void init();
+
+  // empty turns the cache off, the directory is created if needed
+  void setDirectory(const std::string &directory);
+  const std::string &getDirectory() const { return directory_; }
+
+  // 0 if there is no usable binary for these sources
+  GLuint load(const char *vertex, const char *fragment);
+  // `program` must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+  void store(const char *vertex, const char *fragment, GLuint program);
+
+  bool isEnabled() const { return supported_ && !directory_.empty(); }
+  const ProgramCacheStats &getStats() const { return stats_; }
+
+private:
+  struct Key_ {
+    uint64_t hash, check; // the same data hashed two ways
+  };
+
+  Key_ key_(const char *vertex, const char *fragment) const;
+  std::string path_(const Key_ &key) const;
+
+  bool supported_ = false;
+  std::string driver_;
+  std::string directory_;
+  ProgramCacheStats stats_{};
+};
+} // namespace gtamfx
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <gtamfx.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace gtamfx {
+// Dense storage addressed through generational handles. Values live in one
+// contiguous vector (deletion moves the last value into the hole), the slots
+// map a handle's index to the value's position and remember the generation
+// so handles to deleted values can be detected.
+// Insert, lookup and erase are all O(1). Pointers returned by `get` are only
+// valid until the next insert or erase.
+template <typename T> class SlotMap {
+public:
+  Handle<T> insert(T value) {
+    uint32_t index;
+    if (freeHead_ != npos_) {
+      index = freeHead_;
+      freeHead_ = slots_[index].dense;
+    } else {
+      index = slots_.size();
+      slots_.push_back({1, 0});
+    }
+
+    slots_[index].dense = values_.size();
+    values_.push_back(std::move(value));
+    owners_.push_back(index);
+    return {index, slots_[index].generation};
+  }
+
+  T *get(Handle<T> handle) {
+    if (!valid(handle))
+      return nullptr;
+    return &values_[slots_[handle.index].dense];
+  }
+
+  const T *get(Handle<T> handle) const {
+    if (!valid(handle))
+      return nullptr;
+    return &values_[slots_[handle.index].dense];
+  }
+
+  bool valid(Handle<T> handle) const {
+    return handle.generation != 0 && handle.index < slots_.size() &&
+           slots_[handle.index].generation == handle.generation;
+  }
+
+  // returns false if the handle was already stale
+  bool erase(Handle<T> handle) {
+    if (!valid(handle))
+      return false;
+
+    Slot_ &slot = slots_[handle.index];
+    const uint32_t dense = slot.dense;
+    if (dense != values_.size() - 1) {
+      values_[dense] = std::move(values_.back());
+      owners_[dense] = owners_.back();
+      slots_[owners_[dense]].dense = dense;
+    }
+    values_.pop_back();
+    owners_.pop_back();
+
+    // generation 0 is reserved for null handles
+    if (++slot.generation == 0)
+      slot.generation = 1;
+    slot.dense = freeHead_;
+    freeHead_ = handle.index;
+    return true;
+  }
+
+  void clear() {
+    while (!values_.empty())
+      erase(handleAt(0));
+  }
+
+  // handle of the value at position `dense` of the contiguous storage
+  Handle<T> handleAt(size_t dense) const {
+    const uint32_t index = owners_[dense];
+    return {index, slots_[index].generation};
+  }
+
+  // current handle of slot `index`, only meaningful while the slot is in use
+  Handle<T> handleOfSlot(uint32_t index) const {
+    return {index, slots_[index].generation};
+  }
+
+  // position of a live handle's value in the contiguous storage
+  size_t denseIndex(Handle<T> handle) const { return slots_[handle.index].dense; }
+
+  size_t size() const { return values_.size(); }
+  bool empty() const { return values_.empty(); }
+  T *data() { return values_.data(); }
+  const T *data() const { return values_.data(); }
+
+  auto begin() { return values_.begin(); }
+  auto end() { return values_.end(); }
+  auto begin() const { return values_.begin(); }
+  auto end() const { return values_.end(); }
+
+private:
+  static constexpr uint32_t npos_ = UINT32_MAX;
+
+  struct Slot_ {
+    uint32_t generation;
+    uint32_t dense; // next free slot while the slot is unused
+  };
+
+  std::vector<T> values_;
+  std::vector<uint32_t> owners_; // dense position -> slot index
+  std::vector<Slot_> slots_;
+  uint32_t freeHead_ = npos_;
+};
+} // namespace gtamfx
@@ -0,0 +1,133 @@
+#include "spatial.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gtamfx {
+namespace {
+void removeFrom_(std::vector<uint32_t> &ids, uint32_t id) {
+  auto it = std::find(ids.begin(), ids.end(), id);
+  if (it == ids.end())
+    return;
+  *it = ids.back();
+  ids.pop_back();
+}
+
+bool overlaps_(const Bounds &bounds, glm::vec2 min, glm::vec2 max) {
+  return bounds.min.x <= max.x && bounds.max.x >= min.x &&
+         bounds.min.y <= max.y && bounds.max.y >= min.y;
+}
+} // namespace
+
+glm::ivec2 SpatialGrid::cellOf_(glm::vec2 position) const {
+  // clamped so far away or non finite positions still land in some cell
+  const glm::vec2 cell =
+      glm::clamp(glm::floor(position / cellSize_), -1e9f, 1e9f);
+  return cell == cell ? glm::ivec2(cell) : glm::ivec2(0);
+}
+
+void SpatialGrid::set(uint32_t id, const Bounds &bounds) {
+  if (id >= entries_.size())
+    entries_.resize(id + 1);
+
+  Entry_ &entry = entries_[id];
+  const glm::ivec2 cellMin = cellOf_(glm::vec2(bounds.min));
+  const glm::ivec2 cellMax = cellOf_(glm::vec2(bounds.max));
+  const bool oversized = (int64_t)(cellMax.x - cellMin.x + 1) *
+                             (cellMax.y - cellMin.y + 1) >
+                         maxCellsPerEntry_;
+
+  // moves within the same cells only update the bounds
+  if (entry.present && entry.oversized == oversized &&
+      (oversized || (entry.cellMin == cellMin && entry.cellMax == cellMax))) {
+    entry.bounds = bounds;
+    return;
+  }
+
+  if (entry.present)
+    unlink_(id);
+  entry.bounds = bounds;
+  entry.cellMin = cellMin;
+  entry.cellMax = cellMax;
+  entry.oversized = oversized;
+  entry.present = true;
+  link_(id);
+}
+
+void SpatialGrid::erase(uint32_t id) {
+  if (!contains(id))
+    return;
+  unlink_(id);
+  entries_[id].present = false;
+}
+
+void SpatialGrid::link_(uint32_t id) {
+  const Entry_ &entry = entries_[id];
+  if (entry.oversized) {
+    oversized_.push_back(id);
+    return;
+  }
+  for (int y = entry.cellMin.y; y <= entry.cellMax.y; ++y)
+    for (int x = entry.cellMin.x; x <= entry.cellMax.x; ++x)
+      cells_[cellKey_(x, y)].push_back(id);
+}
+
+void SpatialGrid::unlink_(uint32_t id) {
+  const Entry_ &entry = entries_[id];
+  if (entry.oversized) {
+    removeFrom_(oversized_, id);
+    return;
+  }
+  for (int y = entry.cellMin.y; y <= entry.cellMax.y; ++y) {
+    for (int x = entry.cellMin.x; x <= entry.cellMax.x; ++x) {
+      auto it = cells_.find(cellKey_(x, y));
+      if (it == cells_.end())
+        continue;
+      removeFrom_(it->second, id);
+      if (it->second.empty())
+        cells_.erase(it);
+    }
+  }
+}
+
+void SpatialGrid::query(glm::vec2 min, glm::vec2 max,
+                        std::vector<uint32_t> &ids) {
+  if (visited_.size() < entries_.size())
+    visited_.resize(entries_.size());
+  if (++stamp_ == 0) {
+    std::fill(visited_.begin(), visited_.end(), 0);
+    stamp_ = 1;
+  }
+
+  auto visit = [&](uint32_t id) {
+    if (visited_[id] == stamp_)
+      return;
+    visited_[id] = stamp_;
+    if (overlaps_(entries_[id].bounds, min, max))
+      ids.push_back(id);
+  };
+
+  for (uint32_t id : oversized_)
+    visit(id);
+
+  const glm::ivec2 cellMin = cellOf_(min), cellMax = cellOf_(max);
+  // a huge rectangle is cheaper to answer from the occupied cells
+  if ((int64_t)(cellMax.x - cellMin.x + 1) * (cellMax.y - cellMin.y + 1) >
+      (int64_t)cells_.size()) {
+    for (const auto &[key, cell] : cells_)
+      for (uint32_t id : cell)
+        visit(id);
+    return;
+  }
+
+  for (int y = cellMin.y; y <= cellMax.y; ++y) {
+    for (int x = cellMin.x; x <= cellMax.x; ++x) {
+      auto it = cells_.find(cellKey_(x, y));
+      if (it == cells_.end())
+        continue;
+      for (uint32_t id : it->second)
+        visit(id);
+    }
+  }
+}
+} // namespace gtamfx
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace gtamfx {
+struct Bounds {
+  glm::vec3 min, max;
+};
+
+// Uniform grid over the xy plane. Every id is listed in each cell its bounds
+// touch, except for ids spanning too many cells, which are kept in a separate
+// list that every query goes through.
+class SpatialGrid {
+public:
+  explicit SpatialGrid(float cellSize = 256.0f) : cellSize_(cellSize) {}
+
+  // inserts or moves `id`
+  void set(uint32_t id, const Bounds &bounds);
+  void erase(uint32_t id);
+  bool contains(uint32_t id) const {
+    return id < entries_.size() && entries_[id].present;
+  }
+  const Bounds &getBounds(uint32_t id) const { return entries_[id].bounds; }
+
+  // appends the ids whose bounds overlap the rectangle, each id once
+  void query(glm::vec2 min, glm::vec2 max, std::vector<uint32_t> &ids);
+
+private:
+  struct Entry_ {
+    Bounds bounds;
+    glm::ivec2 cellMin, cellMax; // empty range if oversized
+    bool present = false;
+    bool oversized = false;
+  };
+
+  // at most this many cells per id, bigger bounds go to `oversized_`
+  static constexpr int64_t maxCellsPerEntry_ = 64;
+
+  glm::ivec2 cellOf_(glm::vec2 position) const;
+  static uint64_t cellKey_(int x, int y) {
+    return (uint64_t)(uint32_t)x << 32 | (uint32_t)y;
+  }
+  void link_(uint32_t id);
+  void unlink_(uint32_t id);
+
+  float cellSize_;
+  std::vector<Entry_> entries_; // by id
+  std::unordered_map<uint64_t, std::vector<uint32_t>> cells_;
+  std::vector<uint32_t> oversized_;
+  std::vector<uint32_t> visited_; // by id, query stamp of the last visit
+  uint32_t stamp_ = 0;
+};
+} // namespace gtamfx
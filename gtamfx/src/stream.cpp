@@ -0,0 +1,123 @@
+#include "stream.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace gtamfx {
+namespace {
+// enough for anything a vertex attribute or pixel transfer needs
+constexpr size_t alignment_ = 16;
+} // namespace
+
+void StreamBuffer::init(GLenum target, size_t regionSize, bool persistent) {
+  target_ = target;
+  persistent_ = persistent;
+  allocate_(regionSize);
+}
+
+void StreamBuffer::deinit() {
+  for (GLsync &fence : fences_) {
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+  if (mapped_) {
+    glBindBuffer(target_, buffer_);
+    glUnmapBuffer(target_);
+    mapped_ = nullptr;
+  }
+  glDeleteBuffers(1, &buffer_);
+  buffer_ = 0;
+}
+
+void *StreamBuffer::map(size_t bytes, size_t &offset) {
+  const size_t start = (used_ + alignment_ - 1) / alignment_ * alignment_;
+  if (start + bytes > regionSize_) {
+    // the gpu may still read from the old storage, gl keeps it alive for that
+    size_t size = std::max(regionSize_ * 2, alignment_);
+    while (size < bytes)
+      size *= 2;
+    allocate_(size);
+    ++reallocations_;
+    return map(bytes, offset);
+  }
+
+  if (!regionReady_)
+    waitForRegion_();
+  offset = region_ * regionSize_ + start;
+  used_ = start + bytes;
+  bytesStreamed_ += bytes;
+  ++allocations_;
+
+  glBindBuffer(target_, buffer_);
+  if (persistent_)
+    return mapped_ + offset;
+  return glMapBufferRange(target_, offset, bytes,
+                          GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                              GL_MAP_INVALIDATE_RANGE_BIT);
+}
+
+void StreamBuffer::unmap() {
+  // persistent mappings are coherent, the writes are already visible
+  if (!persistent_)
+    glUnmapBuffer(target_);
+}
+
+void StreamBuffer::endFrame() {
+  if (!used_)
+    return;
+  fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  region_ = (region_ + 1) % regionCount;
+  used_ = 0;
+  regionReady_ = false;
+}
+
+void StreamBuffer::addStats(StreamStats &stats) const {
+  stats.persistent = persistent_;
+  stats.capacity += regionSize_ * regionCount;
+  stats.bytesStreamed += bytesStreamed_;
+  stats.allocations += allocations_;
+  stats.reallocations += reallocations_;
+  stats.fenceWaits += fenceWaits_;
+  stats.fenceWaitTime += fenceWaitTime_;
+}
+
+void StreamBuffer::allocate_(size_t regionSize) {
+  deinit();
+  regionSize_ = (regionSize + alignment_ - 1) / alignment_ * alignment_;
+  region_ = 0;
+  used_ = 0;
+  regionReady_ = true; // nothing can be using the new storage
+
+  const size_t size = regionSize_ * regionCount;
+  glGenBuffers(1, &buffer_);
+  glBindBuffer(target_, buffer_);
+  if (!persistent_) {
+    glBufferData(target_, size, nullptr, GL_STREAM_DRAW);
+    return;
+  }
+  const GLbitfield flags =
+      GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glBufferStorage(target_, size, nullptr, flags);
+  mapped_ = (char *)glMapBufferRange(target_, 0, size, flags);
+}
+
+void StreamBuffer::waitForRegion_() {
+  regionReady_ = true;
+  GLsync &fence = fences_[region_];
+  if (!fence)
+    return;
+
+  if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+    const auto start = std::chrono::steady_clock::now();
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) ==
+           GL_TIMEOUT_EXPIRED)
+      ;
+    ++fenceWaits_;
+    fenceWaitTime_ += std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  }
+  glDeleteSync(fence);
+  fence = nullptr;
+}
+} // namespace gtamfx
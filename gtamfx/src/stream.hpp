@@ -0,0 +1,50 @@
+#pragma once
+
+#include <gtamfx.hpp>
+
+namespace gtamfx {
+// Ring buffer for data written once per frame and read by the gpu during it.
+// The buffer is split into one region per frame in flight; a frame writes only
+// into its own region, and a fence set at the end of the frame keeps it from
+// being written again before the gpu is done with it. With ARB_buffer_storage
+// the whole buffer stays mapped, otherwise every write maps its range
+// unsynchronized, which is safe for the same reason. A frame that doesn't fit
+// into its region makes the buffer grow, orphaning the old storage.
+class StreamBuffer {
+public:
+  static constexpr int regionCount = 3;
+
+  void init(GLenum target, size_t regionSize, bool persistent);
+  void deinit();
+
+  // Space for `bytes` in this frame's region, `offset` is where they are in
+  // the buffer. The buffer is left bound to the target, and the data must be
+  // written before `unmap`.
+  void *map(size_t bytes, size_t &offset);
+  void unmap();
+  // fences the region written this frame, if any, and moves on to the next
+  void endFrame();
+
+  GLuint getBuffer() const { return buffer_; }
+  // adds to the totals already in `stats`
+  void addStats(StreamStats &stats) const;
+
+private:
+  void allocate_(size_t regionSize);
+  void waitForRegion_();
+
+  GLenum target_ = 0;
+  GLuint buffer_ = 0;
+  bool persistent_ = false;
+  char *mapped_ = nullptr; // the whole buffer, if persistent
+  size_t regionSize_ = 0;
+  int region_ = 0;
+  size_t used_ = 0;          // bytes of the current region
+  bool regionReady_ = false; // its fence was waited for
+  GLsync fences_[regionCount] = {};
+
+  size_t bytesStreamed_ = 0, allocations_ = 0, reallocations_ = 0;
+  size_t fenceWaits_ = 0;
+  double fenceWaitTime_ = 0;
+};
+} // namespace gtamfx
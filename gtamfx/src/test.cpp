@@ -15,14 +15,17 @@ const Vertex[4] vertices = Vertex[4](
   Vertex(vec4(+0.5, +0.5, 0.0, 0.0), vec4(1.0, 1.0, 1.0, 1.0), vec4(1.0, 1.0, 0.0, 0.0))
 );
 
+in mat4 aTransform;
+in vec4 aTextureView;
+in vec4 aColor;
+
 out vec4 sColor;
 out vec2 sTexCoord;
-uniform mat4 uTransform;
 
 void main() {
-  gl_Position = uTransform * vec4(vertices[gl_VertexID].position.xyz, 1.0);
-  sColor = vertices[gl_VertexID].color.rgba;
-  sTexCoord = vertices[gl_VertexID].texCoord.st;
+  gl_Position = aTransform * vec4(vertices[gl_VertexID].position.xyz, 1.0);
+  sColor = vertices[gl_VertexID].color.rgba * aColor;
+  sTexCoord = vertices[gl_VertexID].texCoord.st * aTextureView.zw + aTextureView.xy;
 }
 )glsl";
 
@@ -34,10 +37,9 @@ in vec2 sTexCoord;
 out vec4 oColor;
 
 uniform sampler2D uTexture;
-uniform vec4 uTextureView;
 
 void main() {
-  oColor = sColor * texture2D(uTexture, sTexCoord * uTextureView.zw + uTextureView.xy);
+  oColor = sColor * texture(uTexture, sTexCoord);
   if(oColor.a == 0) discard;
 }
 
@@ -48,13 +50,14 @@ int main() {
     gtamfx::Window window({800, 600}, "GTAMFX Test!");
     window.init();
 
-    gtamfx::Shader *shader =
+    gtamfx::ShaderHandle shader =
         window.newShader(vertexShaderSource, fragmentShaderSource, 4);
-    gtamfx::Texture *texture = window.newTexture("example/image.png");
-    gtamfx::Sprite *sprite = window.newSprite(texture, shader);
+    gtamfx::TextureHandle texture = window.newTexture("example/image.png");
+    gtamfx::SpriteHandle sprite = window.newSprite(texture, shader);
     const float speed = 140.0f;
 
-    gtamfx::Camera *camera = window.newCamera(gtamfx::CameraType::Orthographic);
+    gtamfx::CameraHandle camera =
+        window.newCamera(gtamfx::CameraType::Orthographic);
 
     window.setActiveCamera(camera);
 
@@ -85,11 +88,13 @@ int main() {
         movement.y -= 1;
       }
 
+      gtamfx::Sprite *data = window.getSprite(sprite);
+
       if (movement != glm::vec2{0, 0})
-        sprite->position +=
+        data->position +=
             glm::vec3(glm::normalize(movement) * speed * deltaTime, 0);
 
-      sprite->rotation = glm::angleAxis(a, glm::vec3(0, 0, 1));
+      data->rotation = glm::angleAxis(a, glm::vec3(0, 0, 1));
       a += 1.f * deltaTime;
 
       lastTime = currentTime;
@@ -98,14 +103,18 @@ int main() {
     window.deinit();
   } catch (gtamfx::Exception e) {
     static const char *exceptionTypeStrings[] = {
-        "Failed to initialize GLFW",    // GlfwFailedInit
-        "Failed to create GLFW window", // GlfwFailedCreateWindow
-        "Failed to initalize GL3W",     // Gl3wFailedInit
-        "OpenGL major version < 2",     // Gl3wBadVersion
-        "Failed to load texture",       // TextureLoadFail
-        "Failed to load shader"         // ShaderLoadFail
+        "Failed to initialize GLFW",         // GlfwFailedInit
+        "Failed to create GLFW window",      // GlfwFailedCreateWindow
+        "Failed to initalize GL3W",          // Gl3wFailedInit
+        "OpenGL major version < 2",          // Gl3wBadVersion
+        "Failed to load texture",            // TextureLoadFail
+        "Failed to load shader",             // ShaderLoadFail
+        "Invalid handle",                    // InvalidHandle
+        "Failed to create headless context", // HeadlessFailedInit
+        "Failed to load font",               // FontLoadFail
+        "Failed to load asset pack",         // PackLoadFail
     };
-    std::fprintf(stderr, "Error: %s: %s\n", exceptionTypeStrings[(int)e.type],
-                 e.message.c_str());
+    std::fprintf(stderr, "Error: %s: %s\n",
+                 exceptionTypeStrings[(int)e.type - 1], e.message.c_str());
   }
 }
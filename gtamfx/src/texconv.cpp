@@ -0,0 +1,243 @@
+#include "texfile.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+}
+
+// Converts an image to a KTX or DDS file with all of its mip levels, which
+// `Window::newTexture` uploads as they are. Rows are written bottom row first
+// like the loader expects. Usage: texconv [-f rgba8|bc1|bc3] [-l levels]
+// input output.{ktx,dds}. Without -f images with transparent pixels become
+// bc3 and opaque ones bc1.
+
+namespace {
+struct Options_ {
+  const char *format = nullptr;
+  int levels = 0; // 0 for the full chain
+  const char *input = nullptr;
+  const char *output = nullptr;
+};
+
+void usage_() {
+  fprintf(stderr, "usage: texconv [-f rgba8|bc1|bc3] [-l levels] input "
+                  "output.{ktx,dds}\n");
+  exit(1);
+}
+
+Options_ parseOptions_(int argc, char **argv) {
+  Options_ options;
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-f") && i + 1 < argc)
+      options.format = argv[++i];
+    else if (!strcmp(argv[i], "-l") && i + 1 < argc)
+      options.levels = atoi(argv[++i]);
+    else if (!options.input)
+      options.input = argv[i];
+    else if (!options.output)
+      options.output = argv[i];
+    else
+      usage_();
+  }
+  if (!options.output || options.levels < 0)
+    usage_();
+  return options;
+}
+
+// a 4x4 block, pixels outside of the image repeat the edge
+using Block_ = unsigned char[16][4];
+
+void fetchBlock_(const unsigned char *pixels, glm::ivec2 size, int blockX,
+                 int blockY, Block_ &block) {
+  for (int y = 0; y < 4; ++y) {
+    const int py = std::min(blockY * 4 + y, size.y - 1);
+    for (int x = 0; x < 4; ++x) {
+      const int px = std::min(blockX * 4 + x, size.x - 1);
+      std::memcpy(block[y * 4 + x], pixels + ((size_t)py * size.x + px) * 4,
+                  4);
+    }
+  }
+}
+
+uint16_t pack565_(const int color[3]) {
+  return (uint16_t)((color[0] * 31 + 127) / 255 << 11 |
+                    (color[1] * 63 + 127) / 255 << 5 |
+                    (color[2] * 31 + 127) / 255);
+}
+
+void unpack565_(uint16_t packed, int color[3]) {
+  const int r = packed >> 11, g = packed >> 5 & 63, b = packed & 31;
+  color[0] = r << 3 | r >> 2;
+  color[1] = g << 2 | g >> 4;
+  color[2] = b << 3 | b >> 2;
+}
+
+// Colors in the four color mode: the corners of the block's bounding box,
+// moved in by a sixteenth so they don't sit on the outliers, and the closest
+// of the four colors for every pixel.
+void encodeBc1_(const Block_ &block, unsigned char *out) {
+  int low[3] = {255, 255, 255}, high[3] = {0, 0, 0};
+  for (const auto &pixel : block) {
+    for (int c = 0; c < 3; ++c) {
+      low[c] = std::min(low[c], (int)pixel[c]);
+      high[c] = std::max(high[c], (int)pixel[c]);
+    }
+  }
+  for (int c = 0; c < 3; ++c) {
+    const int inset = (high[c] - low[c]) / 16;
+    low[c] += inset;
+    high[c] -= inset;
+  }
+
+  uint16_t colors[2] = {pack565_(high), pack565_(low)};
+  if (colors[0] < colors[1])
+    std::swap(colors[0], colors[1]);
+  uint32_t indices = 0;
+  // equal colors are the three color mode, where index 0 is still the color
+  if (colors[0] != colors[1]) {
+    int palette[4][3];
+    unpack565_(colors[0], palette[0]);
+    unpack565_(colors[1], palette[1]);
+    for (int c = 0; c < 3; ++c) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+    for (int i = 0; i < 16; ++i) {
+      int best = 0, bestDistance = 1 << 30;
+      for (int p = 0; p < 4; ++p) {
+        int distance = 0;
+        for (int c = 0; c < 3; ++c) {
+          const int d = block[i][c] - palette[p][c];
+          distance += d * d;
+        }
+        if (distance < bestDistance) {
+          best = p;
+          bestDistance = distance;
+        }
+      }
+      indices |= (uint32_t)best << 2 * i;
+    }
+  }
+
+  for (int i = 0; i < 2; ++i) {
+    out[i * 2] = (unsigned char)colors[i];
+    out[i * 2 + 1] = (unsigned char)(colors[i] >> 8);
+  }
+  for (int i = 0; i < 4; ++i)
+    out[4 + i] = (unsigned char)(indices >> 8 * i);
+}
+
+// bc3 alpha in the eight value mode, between the block's extremes
+void encodeAlpha_(const Block_ &block, unsigned char *out) {
+  int low = 255, high = 0;
+  for (const auto &pixel : block) {
+    low = std::min(low, (int)pixel[3]);
+    high = std::max(high, (int)pixel[3]);
+  }
+
+  int values[8] = {high, low};
+  for (int i = 1; i < 7; ++i)
+    values[i + 1] = ((7 - i) * high + i * low) / 7;
+  uint64_t indices = 0;
+  if (high != low) {
+    for (int i = 0; i < 16; ++i) {
+      int best = 0;
+      for (int v = 1; v < 8; ++v)
+        if (std::abs(block[i][3] - values[v]) <
+            std::abs(block[i][3] - values[best]))
+          best = v;
+      indices |= (uint64_t)best << 3 * i;
+    }
+  }
+
+  out[0] = (unsigned char)high;
+  out[1] = (unsigned char)low;
+  for (int i = 0; i < 6; ++i)
+    out[2 + i] = (unsigned char)(indices >> 8 * i);
+}
+
+// encodes `level` of an rgba8 file into `file`
+void appendLevel_(gtamfx::TextureFile &file, const gtamfx::TextureFile &rgba8,
+                  const gtamfx::TextureLevel &level) {
+  const gtamfx::TextureLevel encoded{
+      level.size, file.data.size(),
+      gtamfx::getLevelBytes(file.format, level.size)};
+  file.data.resize(file.data.size() + encoded.bytes);
+  file.levels.push_back(encoded);
+  unsigned char *out = file.data.data() + encoded.offset;
+  const unsigned char *pixels = rgba8.data.data() + level.offset;
+
+  const glm::ivec2 blocks = (level.size + 3) / 4;
+  Block_ block;
+  for (int y = 0; y < blocks.y; ++y) {
+    for (int x = 0; x < blocks.x; ++x) {
+      fetchBlock_(pixels, level.size, x, y, block);
+      if (file.format == gtamfx::TextureFormat::Bc3) {
+        encodeAlpha_(block, out);
+        out += 8;
+      }
+      encodeBc1_(block, out);
+      out += 8;
+    }
+  }
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const Options_ options = parseOptions_(argc, argv);
+
+  glm::ivec2 size;
+  int channelCount;
+  stbi_set_flip_vertically_on_load(true);
+  unsigned char *data =
+      stbi_load(options.input, &size.x, &size.y, &channelCount, 4);
+  if (!data) {
+    fprintf(stderr, "%s: %s\n", options.input, stbi_failure_reason());
+    return 1;
+  }
+  std::vector<unsigned char> pixels(data, data + (size_t)size.x * size.y * 4);
+  stbi_image_free(data);
+
+  gtamfx::TextureFile file{};
+  if (!options.format) {
+    bool opaque = true;
+    for (size_t i = 3; i < pixels.size() && opaque; i += 4)
+      opaque = pixels[i] == 255;
+    file.format =
+        opaque ? gtamfx::TextureFormat::Bc1 : gtamfx::TextureFormat::Bc3;
+  } else if (!strcmp(options.format, "rgba8")) {
+    file.format = gtamfx::TextureFormat::Rgba8;
+  } else if (!strcmp(options.format, "bc1")) {
+    file.format = gtamfx::TextureFormat::Bc1;
+  } else if (!strcmp(options.format, "bc3")) {
+    file.format = gtamfx::TextureFormat::Bc3;
+  } else {
+    usage_();
+  }
+
+  const gtamfx::TextureFile rgba8 = gtamfx::makeRgba8File(
+      std::move(pixels), size, (size_t)options.levels);
+  if (file.format == gtamfx::TextureFormat::Rgba8) {
+    file = rgba8;
+  } else {
+    for (const gtamfx::TextureLevel &level : rgba8.levels)
+      appendLevel_(file, rgba8, level);
+  }
+
+  std::string error;
+  if (!gtamfx::writeTextureFile(options.output, file, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  printf("%s: %dx%d %s, %zu levels, %zu bytes\n", options.output, size.x,
+         size.y, gtamfx::getFormatName(file.format), file.levels.size(),
+         file.data.size());
+  return 0;
+}
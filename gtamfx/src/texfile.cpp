@@ -0,0 +1,839 @@
+#include "texfile.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace gtamfx {
+namespace {
+constexpr uint32_t fourCc_(const char (&code)[5]) {
+  return (uint32_t)code[0] | (uint32_t)code[1] << 8 |
+         (uint32_t)code[2] << 16 | (uint32_t)code[3] << 24;
+}
+
+// s3tc isn't core, so glcorearb.h doesn't have its enums
+constexpr GLenum compressedRgbS3tcDxt1_ = 0x83F0;
+constexpr GLenum compressedRgbaS3tcDxt1_ = 0x83F1;
+constexpr GLenum compressedRgbaS3tcDxt3_ = 0x83F2;
+constexpr GLenum compressedRgbaS3tcDxt5_ = 0x83F3;
+constexpr GLenum compressedEtc1_ = 0x8D64; // decodes as etc2
+
+struct FormatInfo_ {
+  const char *name;
+  GLenum internalFormat;
+  size_t blockBytes; // of a 4x4 block, 0 for rgba8
+  uint32_t fourCc;   // of legacy dds files, 0 if only in dx10 ones
+  uint32_t dxgiFormat;
+};
+
+// by `TextureFormat`
+constexpr FormatInfo_ formats_[] = {
+    {"rgba8", GL_RGBA8, 0, 0, 28},
+    {"bc1", compressedRgbaS3tcDxt1_, 8, fourCc_("DXT1"), 71},
+    {"bc2", compressedRgbaS3tcDxt3_, 16, fourCc_("DXT3"), 74},
+    {"bc3", compressedRgbaS3tcDxt5_, 16, fourCc_("DXT5"), 77},
+    {"bc4", GL_COMPRESSED_RED_RGTC1, 8, fourCc_("ATI1"), 80},
+    {"bc5", GL_COMPRESSED_RG_RGTC2, 16, fourCc_("ATI2"), 83},
+    {"bc7", GL_COMPRESSED_RGBA_BPTC_UNORM, 16, 0, 98},
+    {"etc2 rgb", GL_COMPRESSED_RGB8_ETC2, 8, 0, 0},
+    {"etc2 rgba", GL_COMPRESSED_RGBA8_ETC2_EAC, 16, 0, 0},
+    {"bc1 rgb", compressedRgbS3tcDxt1_, 8, 0, 0},
+};
+constexpr int formatCount_ = std::size(formats_);
+
+// larger images are taken for broken files
+constexpr uint32_t maxSize_ = 1 << 15;
+
+constexpr unsigned char ktxIdentifier_[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+constexpr uint32_t ktxEndianness_ = 0x04030201;
+// marks the rows as going up, like texconv writes them
+constexpr char ktxOrientationKey_[] = "KTXorientation";
+constexpr char ktxOrientation_[] = "S=r,T=u";
+
+struct KtxHeader_ {
+  unsigned char identifier[12];
+  uint32_t endianness;
+  uint32_t glType, glTypeSize, glFormat;
+  uint32_t glInternalFormat, glBaseInternalFormat;
+  uint32_t width, height, depth;
+  uint32_t arrayElementCount, faceCount, levelCount;
+  uint32_t keyValueBytes;
+};
+static_assert(sizeof(KtxHeader_) == 64);
+
+constexpr char ddsMagic_[4] = {'D', 'D', 'S', ' '};
+constexpr uint32_t ddsHeaderBytes_ = 124;
+constexpr uint32_t ddsCaps_ = 0x1, ddsHeight_ = 0x2, ddsWidth_ = 0x4,
+                   ddsPitch_ = 0x8, ddsPixelFormat_ = 0x1000,
+                   ddsLevelCount_ = 0x20000, ddsLinearSize_ = 0x80000;
+constexpr uint32_t ddsComplex_ = 0x8, ddsTexture_ = 0x1000,
+                   ddsMipmap_ = 0x400000;
+constexpr uint32_t ddsCubemap_ = 0x200, ddsVolume_ = 0x200000;
+constexpr uint32_t ddsAlphaPixels_ = 0x1, ddsFourCc_ = 0x4, ddsRgb_ = 0x40;
+constexpr uint32_t ddsDimensionTexture2d_ = 3;
+
+struct DdsHeader_ {
+  char magic[4];
+  uint32_t size, flags, height, width, pitchOrLinearSize, depth, levelCount;
+  uint32_t reserved1[11];
+  struct {
+    uint32_t size, flags, fourCc, rgbBitCount;
+    uint32_t redMask, greenMask, blueMask, alphaMask;
+  } pixelFormat;
+  uint32_t caps, caps2, caps3, caps4, reserved2;
+};
+static_assert(sizeof(DdsHeader_) == 4 + ddsHeaderBytes_);
+
+struct DdsHeader10_ {
+  uint32_t dxgiFormat, resourceDimension, miscFlags, arraySize, miscFlags2;
+};
+
+// what the header says, enough to find the levels
+struct Layout_ {
+  TextureFormat format;
+  glm::ivec2 size;
+  size_t levelCount;
+  size_t dataOffset;
+  bool ktx; // levels have a size in front and are padded to 4 bytes
+};
+
+// the largest header there is, dds with the dx10 extension
+constexpr size_t maxHeaderBytes_ = sizeof(DdsHeader_) + sizeof(DdsHeader10_);
+
+bool findFormat_(bool (*matches)(const FormatInfo_ &, uint32_t),
+                 uint32_t value, TextureFormat &format) {
+  for (int i = 0; i < formatCount_; ++i) {
+    if (matches(formats_[i], value)) {
+      format = (TextureFormat)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool checkSize_(uint32_t width, uint32_t height, size_t levelCount,
+                Layout_ &layout, std::string &error) {
+  if (width == 0 || height == 0 || width > maxSize_ || height > maxSize_) {
+    error = "bad texture size";
+    return false;
+  }
+  size_t fullChain = 1;
+  while ((std::max(width, height) >> fullChain) > 0)
+    ++fullChain;
+  if (levelCount > fullChain) {
+    error = "more mip levels than the size has";
+    return false;
+  }
+  layout.size = {(int)width, (int)height};
+  layout.levelCount = std::max<size_t>(levelCount, 1);
+  return true;
+}
+
+bool parseKtxHeader_(const unsigned char *bytes, size_t size, Layout_ &layout,
+                     std::string &error) {
+  KtxHeader_ header;
+  std::memcpy(&header, bytes, sizeof(header));
+  if (header.endianness != ktxEndianness_) {
+    error = "big endian KTX files aren't supported";
+    return false;
+  }
+  if (header.depth > 0 || header.arrayElementCount > 0 ||
+      header.faceCount != 1) {
+    error = "only 2d KTX textures are supported";
+    return false;
+  }
+
+  if (header.glType != 0) {
+    if (header.glType != GL_UNSIGNED_BYTE || header.glFormat != GL_RGBA) {
+      error = "only rgba8 uncompressed KTX textures are supported";
+      return false;
+    }
+    layout.format = TextureFormat::Rgba8;
+  } else if (header.glInternalFormat == compressedEtc1_) {
+    layout.format = TextureFormat::Etc2Rgb;
+  } else if (!findFormat_(
+                 [](const FormatInfo_ &info, uint32_t value) {
+                   return info.internalFormat == value && info.blockBytes;
+                 },
+                 header.glInternalFormat, layout.format)) {
+    error = "unsupported KTX internal format " +
+            std::to_string(header.glInternalFormat);
+    return false;
+  }
+
+  layout.dataOffset = sizeof(header) + (size_t)header.keyValueBytes;
+  layout.ktx = true;
+  return checkSize_(header.width, header.height, header.levelCount, layout,
+                    error);
+}
+
+bool parseDdsHeader_(const unsigned char *bytes, size_t size, Layout_ &layout,
+                     std::string &error) {
+  DdsHeader_ header;
+  std::memcpy(&header, bytes, sizeof(header));
+  if (header.size != ddsHeaderBytes_ ||
+      header.pixelFormat.size != sizeof(header.pixelFormat)) {
+    error = "broken DDS header";
+    return false;
+  }
+  if (header.caps2 & (ddsCubemap_ | ddsVolume_)) {
+    error = "only 2d DDS textures are supported";
+    return false;
+  }
+
+  const auto &pixelFormat = header.pixelFormat;
+  layout.dataOffset = sizeof(header);
+  if ((pixelFormat.flags & ddsFourCc_) &&
+      pixelFormat.fourCc == fourCc_("DX10")) {
+    DdsHeader10_ header10;
+    if (size < sizeof(header) + sizeof(header10)) {
+      error = "broken DDS header";
+      return false;
+    }
+    std::memcpy(&header10, bytes + sizeof(header), sizeof(header10));
+    if (header10.resourceDimension != ddsDimensionTexture2d_ ||
+        header10.arraySize > 1) {
+      error = "only 2d DDS textures are supported";
+      return false;
+    }
+    if (!header10.dxgiFormat ||
+        !findFormat_(
+            [](const FormatInfo_ &info, uint32_t value) {
+              return info.dxgiFormat == value;
+            },
+            header10.dxgiFormat, layout.format)) {
+      error = "unsupported DXGI format " + std::to_string(header10.dxgiFormat);
+      return false;
+    }
+    layout.dataOffset += sizeof(header10);
+  } else if (pixelFormat.flags & ddsFourCc_) {
+    // newer names of the same formats
+    uint32_t fourCc = pixelFormat.fourCc;
+    if (fourCc == fourCc_("BC4U"))
+      fourCc = fourCc_("ATI1");
+    else if (fourCc == fourCc_("BC5U"))
+      fourCc = fourCc_("ATI2");
+    if (!fourCc ||
+        !findFormat_(
+            [](const FormatInfo_ &info, uint32_t value) {
+              return info.fourCc == value;
+            },
+            fourCc, layout.format)) {
+      error = "unsupported DDS four cc " +
+              std::string((const char *)&pixelFormat.fourCc, 4);
+      return false;
+    }
+  } else if ((pixelFormat.flags & ddsRgb_) && pixelFormat.rgbBitCount == 32 &&
+             pixelFormat.redMask == 0xff && pixelFormat.greenMask == 0xff00 &&
+             pixelFormat.blueMask == 0xff0000 &&
+             pixelFormat.alphaMask == 0xff000000) {
+    layout.format = TextureFormat::Rgba8;
+  } else {
+    error = "unsupported DDS pixel format";
+    return false;
+  }
+
+  layout.ktx = false;
+  return checkSize_(header.width, header.height,
+                    (header.flags & ddsLevelCount_) ? header.levelCount : 1,
+                    layout, error);
+}
+
+bool parseHeader_(const unsigned char *bytes, size_t size, Layout_ &layout,
+                  std::string &error) {
+  if (size >= sizeof(KtxHeader_) &&
+      !std::memcmp(bytes, ktxIdentifier_, sizeof(ktxIdentifier_)))
+    return parseKtxHeader_(bytes, size, layout, error);
+  if (size >= sizeof(DdsHeader_) &&
+      !std::memcmp(bytes, ddsMagic_, sizeof(ddsMagic_)))
+    return parseDdsHeader_(bytes, size, layout, error);
+  error = "not a KTX or DDS file";
+  return false;
+}
+
+// reads up to `limit` bytes of the file, all of it for 0
+bool readFile_(const char *path, size_t limit, std::vector<unsigned char> &data,
+               std::string &error) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    error = std::string("can't open ") + path;
+    return false;
+  }
+  bool read = fseek(file, 0, SEEK_END) == 0;
+  const long size = read ? ftell(file) : -1;
+  read = size >= 0 && fseek(file, 0, SEEK_SET) == 0;
+  if (read) {
+    data.resize(limit ? std::min((size_t)size, limit) : (size_t)size);
+    read = fread(data.data(), 1, data.size(), file) == data.size();
+  }
+  fclose(file);
+  if (!read)
+    error = std::string("can't read ") + path;
+  return read;
+}
+
+void put32_(std::vector<unsigned char> &out, uint32_t value) {
+  const size_t at = out.size();
+  out.resize(at + 4);
+  std::memcpy(&out[at], &value, 4);
+}
+
+void writeKtx_(const TextureFile &file, std::vector<unsigned char> &out) {
+  const bool rgba8 = file.format == TextureFormat::Rgba8;
+  const TextureLevel &base = file.levels[0];
+  const size_t pairBytes =
+      sizeof(ktxOrientationKey_) + sizeof(ktxOrientation_);
+
+  KtxHeader_ header{};
+  std::memcpy(header.identifier, ktxIdentifier_, sizeof(ktxIdentifier_));
+  header.endianness = ktxEndianness_;
+  header.glType = rgba8 ? GL_UNSIGNED_BYTE : 0;
+  header.glTypeSize = 1;
+  header.glFormat = rgba8 ? GL_RGBA : 0;
+  header.glInternalFormat = getGlInternalFormat(file.format);
+  const bool rgb = file.format == TextureFormat::Etc2Rgb ||
+                   file.format == TextureFormat::Bc1Rgb;
+  header.glBaseInternalFormat = file.format == TextureFormat::Bc4   ? GL_RED
+                                : file.format == TextureFormat::Bc5 ? GL_RG
+                                : rgb                               ? GL_RGB
+                                                                    : GL_RGBA;
+  header.width = base.size.x;
+  header.height = base.size.y;
+  header.faceCount = 1;
+  header.levelCount = (uint32_t)file.levels.size();
+  header.keyValueBytes = (uint32_t)(4 + (pairBytes + 3) / 4 * 4);
+  out.resize(sizeof(header));
+  std::memcpy(out.data(), &header, sizeof(header));
+
+  put32_(out, (uint32_t)pairBytes);
+  out.insert(out.end(), ktxOrientationKey_,
+             ktxOrientationKey_ + sizeof(ktxOrientationKey_));
+  out.insert(out.end(), ktxOrientation_,
+             ktxOrientation_ + sizeof(ktxOrientation_));
+  out.resize((out.size() + 3) / 4 * 4);
+
+  for (const TextureLevel &level : file.levels) {
+    put32_(out, (uint32_t)level.bytes);
+    const unsigned char *data = file.data.data() + level.offset;
+    out.insert(out.end(), data, data + level.bytes);
+    out.resize((out.size() + 3) / 4 * 4);
+  }
+}
+
+bool writeDds_(const TextureFile &file, std::vector<unsigned char> &out,
+               std::string &error) {
+  const FormatInfo_ &info = formats_[(int)file.format];
+  const bool rgba8 = file.format == TextureFormat::Rgba8;
+  if (!rgba8 && !info.fourCc && !info.dxgiFormat) {
+    error = std::string("DDS files can't hold ") + info.name + ", use .ktx";
+    return false;
+  }
+  const TextureLevel &base = file.levels[0];
+
+  DdsHeader_ header{};
+  std::memcpy(header.magic, ddsMagic_, sizeof(ddsMagic_));
+  header.size = ddsHeaderBytes_;
+  header.flags = ddsCaps_ | ddsHeight_ | ddsWidth_ | ddsPixelFormat_ |
+                 ddsLevelCount_ | (rgba8 ? ddsPitch_ : ddsLinearSize_);
+  header.height = base.size.y;
+  header.width = base.size.x;
+  header.pitchOrLinearSize =
+      (uint32_t)(rgba8 ? (size_t)base.size.x * 4 : base.bytes);
+  header.levelCount = (uint32_t)file.levels.size();
+  header.pixelFormat.size = sizeof(header.pixelFormat);
+  header.caps =
+      ddsTexture_ | (file.levels.size() > 1 ? ddsComplex_ | ddsMipmap_ : 0);
+  if (rgba8) {
+    header.pixelFormat.flags = ddsRgb_ | ddsAlphaPixels_;
+    header.pixelFormat.rgbBitCount = 32;
+    header.pixelFormat.redMask = 0xff;
+    header.pixelFormat.greenMask = 0xff00;
+    header.pixelFormat.blueMask = 0xff0000;
+    header.pixelFormat.alphaMask = 0xff000000;
+  } else {
+    header.pixelFormat.flags = ddsFourCc_;
+    header.pixelFormat.fourCc = info.fourCc ? info.fourCc : fourCc_("DX10");
+  }
+  out.resize(sizeof(header));
+  std::memcpy(out.data(), &header, sizeof(header));
+
+  if (!rgba8 && !info.fourCc) {
+    DdsHeader10_ header10{};
+    header10.dxgiFormat = info.dxgiFormat;
+    header10.resourceDimension = ddsDimensionTexture2d_;
+    header10.arraySize = 1;
+    const unsigned char *bytes = (const unsigned char *)&header10;
+    out.insert(out.end(), bytes, bytes + sizeof(header10));
+  }
+
+  for (const TextureLevel &level : file.levels) {
+    const unsigned char *data = file.data.data() + level.offset;
+    out.insert(out.end(), data, data + level.bytes);
+  }
+  return true;
+}
+
+// Halves an rgba8 image with a box filter, the last row or column of odd
+// sizes is averaged with itself.
+void downsample_(const unsigned char *in, glm::ivec2 size, unsigned char *out,
+                 glm::ivec2 half) {
+  for (int y = 0; y < half.y; ++y) {
+    const int y0 = std::min(y * 2, size.y - 1),
+              y1 = std::min(y0 + 1, size.y - 1);
+    for (int x = 0; x < half.x; ++x) {
+      const int x0 = std::min(x * 2, size.x - 1),
+                x1 = std::min(x0 + 1, size.x - 1);
+      for (int c = 0; c < 4; ++c) {
+        auto at = [&](int px, int py) {
+          return (int)in[((size_t)py * size.x + px) * 4 + c];
+        };
+        out[((size_t)y * half.x + x) * 4 + c] = (unsigned char)(
+            (at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1) + 2) / 4);
+      }
+    }
+  }
+}
+
+// a decoded 4x4 block, row by row
+using Block_ = unsigned char[16][4];
+
+unsigned char clamp255_(int value) {
+  return (unsigned char)std::clamp(value, 0, 255);
+}
+
+void decodeBc1_(const unsigned char *in, Block_ &out, bool alwaysOpaque) {
+  const uint16_t colors[2] = {(uint16_t)(in[0] | in[1] << 8),
+                              (uint16_t)(in[2] | in[3] << 8)};
+  int palette[4][4];
+  for (int i = 0; i < 2; ++i) {
+    const int r = colors[i] >> 11, g = colors[i] >> 5 & 63, b = colors[i] & 31;
+    palette[i][0] = r << 3 | r >> 2;
+    palette[i][1] = g << 2 | g >> 4;
+    palette[i][2] = b << 3 | b >> 2;
+    palette[i][3] = 255;
+  }
+  // bc2 and bc3 colors always use the four color mode
+  const bool fourColors = colors[0] > colors[1] || alwaysOpaque;
+  for (int c = 0; c < 4; ++c) {
+    if (fourColors) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    } else {
+      palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+      palette[3][c] = 0; // transparent black
+    }
+  }
+
+  const uint32_t indices = in[4] | in[5] << 8 | in[6] << 16 |
+                           (uint32_t)in[7] << 24;
+  for (int i = 0; i < 16; ++i)
+    for (int c = 0; c < 4; ++c)
+      out[i][c] = (unsigned char)palette[indices >> 2 * i & 3][c];
+}
+
+// one channel, as in bc3 alpha and bc4/bc5
+void decodeBc4_(const unsigned char *in, Block_ &out, int channel) {
+  int values[8] = {in[0], in[1]};
+  if (values[0] > values[1]) {
+    for (int i = 1; i < 7; ++i)
+      values[i + 1] = ((7 - i) * values[0] + i * values[1]) / 7;
+  } else {
+    for (int i = 1; i < 5; ++i)
+      values[i + 1] = ((5 - i) * values[0] + i * values[1]) / 5;
+    values[6] = 0;
+    values[7] = 255;
+  }
+
+  uint64_t indices = 0;
+  for (int i = 0; i < 6; ++i)
+    indices |= (uint64_t)in[2 + i] << 8 * i;
+  for (int i = 0; i < 16; ++i)
+    out[i][channel] = (unsigned char)values[indices >> 3 * i & 7];
+}
+
+void decodeBc2Alpha_(const unsigned char *in, Block_ &out) {
+  for (int i = 0; i < 16; ++i)
+    out[i][3] = (unsigned char)((in[i / 2] >> 4 * (i % 2) & 15) * 17);
+}
+
+uint64_t bigEndian64_(const unsigned char *in) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i)
+    value = value << 8 | in[i];
+  return value;
+}
+
+constexpr int etcModifiers_[8][2] = {{2, 8},   {5, 17},  {9, 29},   {13, 42},
+                                     {18, 60}, {24, 80}, {33, 106}, {47, 183}};
+constexpr int etcDistances_[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+
+constexpr int eacModifiers_[16][8] = {
+    {-3, -6, -9, -15, 2, 5, 8, 14}, {-3, -7, -10, -13, 2, 6, 9, 12},
+    {-2, -5, -8, -13, 1, 4, 7, 12}, {-2, -4, -6, -13, 1, 3, 5, 12},
+    {-3, -6, -8, -12, 2, 5, 7, 11}, {-3, -7, -9, -11, 2, 6, 8, 10},
+    {-4, -7, -8, -11, 3, 6, 7, 10}, {-3, -5, -8, -11, 2, 4, 7, 10},
+    {-2, -6, -8, -10, 1, 5, 7, 9},  {-2, -5, -8, -10, 1, 4, 7, 9},
+    {-2, -4, -8, -10, 1, 3, 7, 9},  {-2, -5, -7, -10, 1, 4, 6, 9},
+    {-3, -4, -7, -10, 2, 3, 6, 9},  {-1, -2, -3, -10, 0, 1, 2, 9},
+    {-4, -6, -8, -9, 3, 5, 7, 8},   {-3, -5, -7, -9, 2, 4, 6, 8}};
+
+// Etc2 rgb, including the etc1 individual and differential modes. Pixels are
+// numbered column by column in etc blocks.
+void decodeEtc2_(const unsigned char *in, Block_ &out) {
+  const uint64_t block = bigEndian64_(in);
+  auto field = [block](int msb, int count) {
+    return (int)(block >> (msb - count + 1) & ((1ull << count) - 1));
+  };
+  auto index = [&](int x, int y) {
+    const int pixel = x * 4 + y;
+    return field(16 + pixel, 1) << 1 | field(pixel, 1);
+  };
+  auto signed3 = [](int value) { return value >= 4 ? value - 8 : value; };
+  auto extend4 = [](int value) { return value * 17; };
+  auto extend5 = [](int value) { return value << 3 | value >> 2; };
+  auto set = [&](int x, int y, int r, int g, int b) {
+    out[y * 4 + x][0] = clamp255_(r);
+    out[y * 4 + x][1] = clamp255_(g);
+    out[y * 4 + x][2] = clamp255_(b);
+    out[y * 4 + x][3] = 255;
+  };
+
+  const bool differential = field(33, 1);
+  const int r = field(63, 5), g = field(55, 5), b = field(47, 5);
+  const int dr = signed3(field(58, 3)), dg = signed3(field(50, 3)),
+            db = signed3(field(42, 3));
+
+  if (differential && (r + dr < 0 || r + dr > 31)) {
+    // t mode: one color and three around another
+    const int c1[3] = {extend4(field(60, 2) << 2 | field(57, 2)),
+                       extend4(field(55, 4)), extend4(field(51, 4))};
+    const int c2[3] = {extend4(field(47, 4)), extend4(field(43, 4)),
+                       extend4(field(39, 4))};
+    const int d = etcDistances_[field(35, 2) << 1 | field(32, 1)];
+    const int offsets[4] = {0, d, 0, -d};
+    for (int x = 0; x < 4; ++x) {
+      for (int y = 0; y < 4; ++y) {
+        const int i = index(x, y);
+        const int *base = i == 0 ? c1 : c2;
+        set(x, y, base[0] + offsets[i], base[1] + offsets[i],
+            base[2] + offsets[i]);
+      }
+    }
+  } else if (differential && (g + dg < 0 || g + dg > 31)) {
+    // h mode: two colors with two shades each
+    const int r1 = field(62, 4), g1 = field(58, 3) << 1 | field(52, 1),
+              b1 = field(51, 1) << 3 | field(49, 3);
+    const int r2 = field(46, 4), g2 = field(42, 4), b2 = field(38, 4);
+    const int order = (r1 << 8 | g1 << 4 | b1) >= (r2 << 8 | g2 << 4 | b2);
+    const int d =
+        etcDistances_[field(34, 1) << 2 | field(32, 1) << 1 | order];
+    const int c1[3] = {extend4(r1), extend4(g1), extend4(b1)};
+    const int c2[3] = {extend4(r2), extend4(g2), extend4(b2)};
+    for (int x = 0; x < 4; ++x) {
+      for (int y = 0; y < 4; ++y) {
+        const int i = index(x, y);
+        const int *base = i < 2 ? c1 : c2;
+        const int offset = i % 2 ? -d : d;
+        set(x, y, base[0] + offset, base[1] + offset, base[2] + offset);
+      }
+    }
+  } else if (differential && (b + db < 0 || b + db > 31)) {
+    // planar mode: a gradient from three colors
+    auto extend6 = [](int value) { return value << 2 | value >> 4; };
+    auto extend7 = [](int value) { return value << 1 | value >> 6; };
+    const int o[3] = {
+        extend6(field(62, 6)), extend7(field(56, 1) << 6 | field(54, 6)),
+        extend6(field(48, 1) << 5 | field(44, 2) << 3 | field(41, 3))};
+    const int h[3] = {extend6(field(38, 5) << 1 | field(32, 1)),
+                      extend7(field(31, 7)), extend6(field(24, 6))};
+    const int v[3] = {extend6(field(18, 6)), extend7(field(12, 7)),
+                      extend6(field(5, 6))};
+    int c[3];
+    for (int x = 0; x < 4; ++x) {
+      for (int y = 0; y < 4; ++y) {
+        for (int k = 0; k < 3; ++k)
+          c[k] = (x * (h[k] - o[k]) + y * (v[k] - o[k]) + 4 * o[k] + 2) >> 2;
+        set(x, y, c[0], c[1], c[2]);
+      }
+    }
+  } else {
+    // two halves of the block, side by side or (flipped) on top of each other
+    int base[2][3];
+    if (differential) {
+      const int c1[3] = {r, g, b}, c2[3] = {r + dr, g + dg, b + db};
+      for (int k = 0; k < 3; ++k) {
+        base[0][k] = extend5(c1[k]);
+        base[1][k] = extend5(c2[k]);
+      }
+    } else {
+      for (int k = 0; k < 3; ++k) {
+        base[0][k] = extend4(field(63 - 8 * k, 4));
+        base[1][k] = extend4(field(59 - 8 * k, 4));
+      }
+    }
+    const int tables[2] = {field(39, 3), field(36, 3)};
+    const bool flip = field(32, 1);
+    for (int x = 0; x < 4; ++x) {
+      for (int y = 0; y < 4; ++y) {
+        const int half = flip ? y >= 2 : x >= 2;
+        const int i = index(x, y);
+        const int modifier = etcModifiers_[tables[half]][i & 1];
+        const int offset = i & 2 ? -modifier : modifier;
+        set(x, y, base[half][0] + offset, base[half][1] + offset,
+            base[half][2] + offset);
+      }
+    }
+  }
+}
+
+void decodeEacAlpha_(const unsigned char *in, Block_ &out) {
+  const uint64_t block = bigEndian64_(in);
+  const int base = (int)(block >> 56), multiplier = (int)(block >> 52 & 15);
+  const int *modifiers = eacModifiers_[block >> 48 & 15];
+  for (int pixel = 0; pixel < 16; ++pixel) {
+    const int i = (int)(block >> (45 - 3 * pixel) & 7);
+    const int x = pixel / 4, y = pixel % 4;
+    out[y * 4 + x][3] = clamp255_(base + modifiers[i] * multiplier);
+  }
+}
+
+void decodeBlock_(TextureFormat format, const unsigned char *in,
+                  Block_ &out) {
+  switch (format) {
+  case TextureFormat::Bc1:
+    decodeBc1_(in, out, false);
+    break;
+  case TextureFormat::Bc1Rgb:
+    // the three color mode's black is opaque without alpha
+    decodeBc1_(in, out, false);
+    for (auto &texel : out)
+      texel[3] = 255;
+    break;
+  case TextureFormat::Bc2:
+    decodeBc1_(in + 8, out, true);
+    decodeBc2Alpha_(in, out);
+    break;
+  case TextureFormat::Bc3:
+    decodeBc1_(in + 8, out, true);
+    decodeBc4_(in, out, 3);
+    break;
+  case TextureFormat::Bc4:
+  case TextureFormat::Bc5:
+    for (auto &texel : out) {
+      texel[0] = texel[1] = texel[2] = 0;
+      texel[3] = 255;
+    }
+    decodeBc4_(in, out, 0);
+    if (format == TextureFormat::Bc5)
+      decodeBc4_(in + 8, out, 1);
+    break;
+  case TextureFormat::Etc2Rgb:
+    decodeEtc2_(in, out);
+    break;
+  case TextureFormat::Etc2Rgba:
+    decodeEtc2_(in + 8, out);
+    decodeEacAlpha_(in, out);
+    break;
+  default:
+    break;
+  }
+}
+} // namespace
+
+size_t getLevelBytes(TextureFormat format, glm::ivec2 size) {
+  const size_t blockBytes = formats_[(int)format].blockBytes;
+  if (!blockBytes)
+    return (size_t)size.x * size.y * 4;
+  return (size_t)((size.x + 3) / 4) * ((size.y + 3) / 4) * blockBytes;
+}
+
+GLenum getGlInternalFormat(TextureFormat format) {
+  return formats_[(int)format].internalFormat;
+}
+
+const char *getFormatName(TextureFormat format) {
+  return formats_[(int)format].name;
+}
+
+bool isTextureFile(const char *path) {
+  unsigned char magic[sizeof(ktxIdentifier_)];
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return false;
+  const size_t size = fread(magic, 1, sizeof(magic), file);
+  fclose(file);
+  return (size >= sizeof(ktxIdentifier_) &&
+          !std::memcmp(magic, ktxIdentifier_, sizeof(ktxIdentifier_))) ||
+         (size >= sizeof(ddsMagic_) &&
+          !std::memcmp(magic, ddsMagic_, sizeof(ddsMagic_)));
+}
+
+bool readTextureFileSize(const char *path, glm::ivec2 &size,
+                         std::string &error) {
+  std::vector<unsigned char> header;
+  Layout_ layout;
+  if (!readFile_(path, maxHeaderBytes_, header, error) ||
+      !parseHeader_(header.data(), header.size(), layout, error))
+    return false;
+  size = layout.size;
+  return true;
+}
+
+// The levels are left where they are in the file's bytes, which become the
+// file's data as a whole.
+bool readTextureFile(const char *path, TextureFile &file,
+                     std::string &error) {
+  std::vector<unsigned char> bytes;
+  Layout_ layout;
+  if (!readFile_(path, 0, bytes, error) ||
+      !parseHeader_(bytes.data(), bytes.size(), layout, error))
+    return false;
+
+  file.format = layout.format;
+  file.levels.clear();
+  size_t offset = layout.dataOffset;
+  for (size_t i = 0; i < layout.levelCount; ++i) {
+    TextureLevel level;
+    level.size = glm::max(layout.size >> (int)i, glm::ivec2(1));
+    level.bytes = getLevelBytes(layout.format, level.size);
+    if (layout.ktx) {
+      uint32_t imageBytes;
+      if (offset + 4 > bytes.size()) {
+        error = "truncated texture file";
+        return false;
+      }
+      std::memcpy(&imageBytes, &bytes[offset], 4);
+      if (imageBytes != level.bytes) {
+        error = "KTX level " + std::to_string(i) + " has the wrong size";
+        return false;
+      }
+      offset += 4;
+    }
+    if (offset > bytes.size() || bytes.size() - offset < level.bytes) {
+      error = "truncated texture file";
+      return false;
+    }
+    level.offset = offset;
+    offset += layout.ktx ? (level.bytes + 3) / 4 * 4 : level.bytes;
+    file.levels.push_back(level);
+  }
+  file.data = std::move(bytes);
+  return true;
+}
+
+bool writeTextureFile(const char *path, const TextureFile &file,
+                      std::string &error) {
+  const std::string name = path;
+  auto endsWith = [&](const char *extension) {
+    const size_t length = std::strlen(extension);
+    if (name.size() < length)
+      return false;
+    return std::equal(name.end() - length, name.end(), extension,
+                      [](char a, char b) { return std::tolower(a) == b; });
+  };
+
+  std::vector<unsigned char> out;
+  if (endsWith(".ktx")) {
+    writeKtx_(file, out);
+  } else if (endsWith(".dds")) {
+    if (!writeDds_(file, out, error))
+      return false;
+  } else {
+    error = name + " doesn't end in .ktx or .dds";
+    return false;
+  }
+
+  FILE *output = fopen(path, "wb");
+  if (!output) {
+    error = "can't open " + name;
+    return false;
+  }
+  const bool complete = fwrite(out.data(), 1, out.size(), output) == out.size();
+  if (fclose(output) != 0 || !complete) {
+    error = "can't write " + name;
+    return false;
+  }
+  return true;
+}
+
+TextureFile makeRgba8File(std::vector<unsigned char> pixels, glm::ivec2 size,
+                          size_t levelCount) {
+  size_t fullChain = 1;
+  while ((std::max(size.x, size.y) >> fullChain) > 0)
+    ++fullChain;
+  levelCount = levelCount ? std::min(levelCount, fullChain) : fullChain;
+
+  TextureFile file{TextureFormat::Rgba8, {}, std::move(pixels)};
+  file.levels.push_back({size, 0, file.data.size()});
+  for (size_t i = 1; i < levelCount; ++i) {
+    const TextureLevel &level = file.levels.back();
+    const TextureLevel half{glm::max(level.size / 2, glm::ivec2(1)),
+                            file.data.size(), 0};
+    file.levels.push_back(half);
+    file.data.resize(file.data.size() +
+                     getLevelBytes(TextureFormat::Rgba8, half.size));
+    downsample_(file.data.data() + file.levels[i - 1].offset,
+                file.levels[i - 1].size, file.data.data() + half.offset,
+                half.size);
+    file.levels[i].bytes = file.data.size() - half.offset;
+  }
+  return file;
+}
+
+bool transcodeToRgba8(TextureFile &file) {
+  if (file.format == TextureFormat::Rgba8)
+    return true;
+  if (file.format == TextureFormat::Bc7)
+    return false;
+
+  const size_t blockBytes = formats_[(int)file.format].blockBytes;
+  std::vector<TextureLevel> levels;
+  std::vector<unsigned char> data;
+  for (const TextureLevel &level : file.levels) {
+    const TextureLevel decoded{level.size, data.size(),
+                               getLevelBytes(TextureFormat::Rgba8, level.size)};
+    data.resize(data.size() + decoded.bytes);
+    unsigned char *pixels = data.data() + decoded.offset;
+    const unsigned char *in = file.data.data() + level.offset;
+
+    // blocks of the last row and column may hang over the edge
+    const glm::ivec2 blocks = (level.size + 3) / 4;
+    Block_ texels;
+    for (int blockY = 0; blockY < blocks.y; ++blockY) {
+      for (int blockX = 0; blockX < blocks.x; ++blockX, in += blockBytes) {
+        decodeBlock_(file.format, in, texels);
+        for (int y = 0; y < 4 && blockY * 4 + y < level.size.y; ++y)
+          for (int x = 0; x < 4 && blockX * 4 + x < level.size.x; ++x)
+            std::memcpy(pixels + ((size_t)(blockY * 4 + y) * level.size.x +
+                                  blockX * 4 + x) *
+                                     4,
+                        texels[y * 4 + x], 4);
+      }
+    }
+    levels.push_back(decoded);
+  }
+
+  file.format = TextureFormat::Rgba8;
+  file.levels = std::move(levels);
+  file.data = std::move(data);
+  return true;
+}
+
+bool makeUploadable(TextureFile &file, uint32_t supported,
+                    std::string &error) {
+  if (supported & formatBit(file.format))
+    return true;
+  const TextureFormat format = file.format;
+  if (!transcodeToRgba8(file)) {
+    error = std::string("the gl context can't sample ") +
+            getFormatName(format) + " textures and there is no decoder";
+    return false;
+  }
+  return true;
+}
+} // namespace gtamfx
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <gtamfx.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gtamfx {
+enum class TextureFormat : int {
+  Rgba8 = 0,
+  Bc1 = 1, // s3tc dxt1, with 1 bit alpha
+  Bc2 = 2, // s3tc dxt3
+  Bc3 = 3, // s3tc dxt5
+  Bc4 = 4, // rgtc red
+  Bc5 = 5, // rgtc red and green
+  Bc7 = 6, // bptc
+  Etc2Rgb = 7,
+  Etc2Rgba = 8, // with eac alpha
+  Bc1Rgb = 9,   // s3tc dxt1 without alpha, only in KTX files
+};
+
+constexpr uint32_t formatBit(TextureFormat format) {
+  return 1u << (int)format;
+}
+
+struct TextureLevel {
+  glm::ivec2 size;
+  size_t offset, bytes; // into `TextureFile::data`
+};
+
+// A texture with all of its mip levels as they are uploaded, read from a KTX
+// (version 1) or DDS container. Nothing is flipped: rows are expected bottom
+// row first, the way gl wants them and `texconv` writes them.
+struct TextureFile {
+  TextureFormat format;
+  std::vector<TextureLevel> levels; // largest first
+  std::vector<unsigned char> data;
+};
+
+// bytes of a `size` image in `format`, whole blocks for compressed formats
+size_t getLevelBytes(TextureFormat format, glm::ivec2 size);
+// internal format for glCompressedTexImage2D, GL_RGBA8 for `Rgba8`
+GLenum getGlInternalFormat(TextureFormat format);
+const char *getFormatName(TextureFormat format);
+
+// whether the file starts like a KTX or DDS container
+bool isTextureFile(const char *path);
+// reads only the header, for the size of a texture loaded later
+bool readTextureFileSize(const char *path, glm::ivec2 &size,
+                         std::string &error);
+bool readTextureFile(const char *path, TextureFile &file, std::string &error);
+// the container is picked by the extension of `path`, .ktx or .dds
+bool writeTextureFile(const char *path, const TextureFile &file,
+                      std::string &error);
+
+// An `Rgba8` file of `pixels` with `levelCount` mip levels, 0 for all of them
+// down to 1x1, each a box filtered half of the one before.
+TextureFile makeRgba8File(std::vector<unsigned char> pixels, glm::ivec2 size,
+                          size_t levelCount = 0);
+
+// Decodes every level to `Rgba8` on the cpu. BC4 and BC5 decode to red and
+// red/green like gl samples them; there is no decoder for BC7.
+bool transcodeToRgba8(TextureFile &file);
+// Transcodes the file if `supported` (`formatBit`s of what the context can
+// sample) doesn't have its format, fails if it can't be transcoded either.
+bool makeUploadable(TextureFile &file, uint32_t supported,
+                    std::string &error);
+} // namespace gtamfx
@@ -0,0 +1,132 @@
+#include "tilemap.hpp"
+
+#include <cstddef>
+
+namespace gtamfx {
+namespace {
+constexpr int chunkTiles_ = TileLayer::chunkSize * TileLayer::chunkSize;
+
+// `part` / `whole` of the way from 0 to 1, normalized to 16 bits
+uint16_t normalized_(int part, int whole) {
+  return (uint16_t)(((uint32_t)part * 65535 + whole / 2) / whole);
+}
+} // namespace
+
+GLuint TileLayer::newIndexBuffer() {
+  std::vector<uint16_t> indices;
+  indices.reserve(chunkTiles_ * 6);
+  for (int tile = 0; tile < chunkTiles_; ++tile) {
+    const uint16_t first = tile * 4;
+    for (int corner : {0, 1, 2, 2, 1, 3})
+      indices.push_back(first + corner);
+  }
+
+  GLuint buffer;
+  glGenBuffers(1, &buffer);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t),
+               indices.data(), GL_STATIC_DRAW);
+  return buffer;
+}
+
+TileLayer::TileLayer(glm::ivec2 size)
+    : size_(size), chunkCount_((size + chunkSize - 1) / chunkSize),
+      chunks_((size_t)chunkCount_.x * chunkCount_.y) {}
+
+void TileLayer::deinit(GlState &state) {
+  for (Chunk_ &chunk : chunks_) {
+    if (!chunk.vao)
+      continue;
+    state.forgetVertexArray(chunk.vao);
+    glDeleteVertexArrays(1, &chunk.vao);
+    glDeleteBuffers(1, &chunk.buffer);
+    chunk.vao = chunk.buffer = 0;
+  }
+}
+
+uint16_t TileLayer::get(glm::ivec2 tile) const {
+  if (tile.x < 0 || tile.y < 0 || tile.x >= size_.x || tile.y >= size_.y)
+    return 0;
+  const glm::ivec2 chunk = tile / chunkSize, local = tile - chunk * chunkSize;
+  const Chunk_ &data = chunks_[chunk.y * chunkCount_.x + chunk.x];
+  return data.tiles.empty() ? 0 : data.tiles[local.y * chunkSize + local.x];
+}
+
+void TileLayer::set(glm::ivec2 tile, uint16_t value) {
+  if (tile.x < 0 || tile.y < 0 || tile.x >= size_.x || tile.y >= size_.y)
+    return;
+  const glm::ivec2 chunk = tile / chunkSize, local = tile - chunk * chunkSize;
+  Chunk_ &data = chunks_[chunk.y * chunkCount_.x + chunk.x];
+  if (data.tiles.empty()) {
+    if (!value)
+      return;
+    data.tiles.resize(chunkTiles_);
+  }
+
+  uint16_t &current = data.tiles[local.y * chunkSize + local.x];
+  if (current != value) {
+    current = value;
+    data.dirty = true;
+  }
+}
+
+GLsizei TileLayer::prepare(glm::ivec2 chunk, glm::ivec2 atlasSize,
+                           GLuint indexBuffer, GlState &state) {
+  Chunk_ &data = chunks_[chunk.y * chunkCount_.x + chunk.x];
+  if (data.tiles.empty())
+    return 0;
+  if (data.dirty || data.atlasSize != atlasSize) {
+    build_(data, chunk * chunkSize, atlasSize, indexBuffer, state);
+    data.dirty = false;
+    data.atlasSize = atlasSize;
+  }
+  return data.indexCount;
+}
+
+// Tile n > 0 shows cell n - 1 of the atlas, counting row by row from its top
+// left. Images are flipped on load, so the top row is at v = 1.
+void TileLayer::build_(Chunk_ &chunk, glm::ivec2 origin, glm::ivec2 atlasSize,
+                       GLuint indexBuffer, GlState &state) {
+  const glm::ivec2 cells = glm::max(atlasSize, glm::ivec2(1));
+  vertices_.clear();
+  for (int y = 0; y < chunkSize; ++y) {
+    for (int x = 0; x < chunkSize; ++x) {
+      const int tile = chunk.tiles[y * chunkSize + x];
+      if (!tile)
+        continue;
+      const int column = (tile - 1) % cells.x;
+      const int row = (tile - 1) / cells.x % cells.y;
+      const uint16_t u0 = normalized_(column, cells.x);
+      const uint16_t u1 = normalized_(column + 1, cells.x);
+      const uint16_t v0 = normalized_(cells.y - row - 1, cells.y);
+      const uint16_t v1 = normalized_(cells.y - row, cells.y);
+      const uint16_t x0 = origin.x + x, y0 = origin.y + y;
+      vertices_.push_back({x0, y0, u0, v0});
+      vertices_.push_back({(uint16_t)(x0 + 1), y0, u1, v0});
+      vertices_.push_back({x0, (uint16_t)(y0 + 1), u0, v1});
+      vertices_.push_back({(uint16_t)(x0 + 1), (uint16_t)(y0 + 1), u1, v1});
+    }
+  }
+  chunk.indexCount = vertices_.size() / 4 * 6;
+  if (!chunk.indexCount)
+    return;
+
+  if (!chunk.vao) {
+    glGenVertexArrays(1, &chunk.vao);
+    glGenBuffers(1, &chunk.buffer);
+    state.bindVertexArray(chunk.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glEnableVertexAttribArray(positionLocation);
+    glVertexAttribPointer(positionLocation, 2, GL_UNSIGNED_SHORT, GL_FALSE,
+                          sizeof(Vertex_), (const void *)offsetof(Vertex_, x));
+    glEnableVertexAttribArray(uvLocation);
+    glVertexAttribPointer(uvLocation, 2, GL_UNSIGNED_SHORT, GL_TRUE,
+                          sizeof(Vertex_), (const void *)offsetof(Vertex_, u));
+  } else {
+    glBindBuffer(GL_ARRAY_BUFFER, chunk.buffer);
+  }
+  glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(Vertex_),
+               vertices_.data(), GL_STATIC_DRAW);
+}
+} // namespace gtamfx
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "glstate.hpp"
+
+#include <gtamfx.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace gtamfx {
+// Tiles of one tilemap layer, kept in square chunks. A chunk gets a static
+// vertex buffer with a quad per tile the first time it is drawn, and it is only
+// rebuilt after one of its tiles changed. Chunks without tiles have no storage
+// and no buffers at all.
+class TileLayer {
+public:
+  static constexpr int chunkSize = 32;
+  // attribute locations, bound by `newShader`
+  static constexpr GLuint positionLocation = 6;
+  static constexpr GLuint uvLocation = 7;
+
+  // Indices of a full chunk, shared by all layers: two triangles per tile
+  // from its four corners.
+  static GLuint newIndexBuffer();
+
+  explicit TileLayer(glm::ivec2 size);
+  void deinit(GlState &state);
+
+  // tiles outside of the layer read as 0, writing them does nothing
+  uint16_t get(glm::ivec2 tile) const;
+  void set(glm::ivec2 tile, uint16_t value);
+
+  glm::ivec2 getChunkCount() const { return chunkCount_; }
+  // Rebuilds the chunk's vertex buffer if a tile or `atlasSize` changed since
+  // its last build, and returns the number of indices to draw, 0 if the chunk
+  // is empty. Changes the GL_ARRAY_BUFFER and vertex array bindings.
+  GLsizei prepare(glm::ivec2 chunk, glm::ivec2 atlasSize, GLuint indexBuffer,
+                  GlState &state);
+  GLuint getVertexArray(glm::ivec2 chunk) const {
+    return chunks_[chunk.y * chunkCount_.x + chunk.x].vao;
+  }
+
+  float depth = 0; // added to the tilemap's z
+
+private:
+  struct Vertex_ {
+    uint16_t x, y; // tile corner
+    uint16_t u, v; // normalized
+  };
+
+  struct Chunk_ {
+    std::vector<uint16_t> tiles; // empty until a tile is set
+    GLuint vao = 0, buffer = 0;
+    GLsizei indexCount = 0;
+    glm::ivec2 atlasSize{}; // of the last build
+    bool dirty = false;
+  };
+
+  void build_(Chunk_ &chunk, glm::ivec2 origin, glm::ivec2 atlasSize,
+              GLuint indexBuffer, GlState &state);
+
+  glm::ivec2 size_;
+  glm::ivec2 chunkCount_;
+  std::vector<Chunk_> chunks_;
+  std::vector<Vertex_> vertices_; // scratch for `build_`
+};
+} // namespace gtamfx
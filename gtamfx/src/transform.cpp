@@ -0,0 +1,257 @@
+#include "transform.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GTAMFX_X86_
+#include <immintrin.h>
+#endif
+
+namespace gtamfx {
+namespace {
+float *destination_(char *out, size_t stride, const uint32_t *index,
+                    size_t i) {
+  return (float *)(out + (index ? index[i] : i) * stride);
+}
+
+// One sprite at a time, also finishes what doesn't fill a vector in the
+// other kernels. `camera` is column-major.
+void transformScalar_(const float *camera, const SpriteTransforms &in,
+                      size_t begin, size_t end, char *out, size_t stride,
+                      const uint32_t *index) {
+  for (size_t i = begin; i < end; ++i) {
+    const float x = in.rotation[0][i], y = in.rotation[1][i],
+                z = in.rotation[2][i], w = in.rotation[3][i];
+    const float sx = in.scale[0][i], sy = in.scale[1][i], sz = in.scale[2][i];
+
+    // model[column][row] of the upper 3x3, same as glm::mat4_cast
+    const float model[3][3] = {
+        {(1 - 2 * (y * y + z * z)) * sx, 2 * (x * y + w * z) * sx,
+         2 * (x * z - w * y) * sx},
+        {2 * (x * y - w * z) * sy, (1 - 2 * (x * x + z * z)) * sy,
+         2 * (y * z + w * x) * sy},
+        {2 * (x * z + w * y) * sz, 2 * (y * z - w * x) * sz,
+         (1 - 2 * (x * x + y * y)) * sz},
+    };
+    const float position[3] = {in.position[0][i], in.position[1][i],
+                               in.position[2][i]};
+
+    float result[16];
+    for (int row = 0; row < 4; ++row) {
+      for (int column = 0; column < 3; ++column)
+        result[column * 4 + row] = camera[row] * model[column][0] +
+                                   camera[4 + row] * model[column][1] +
+                                   camera[8 + row] * model[column][2];
+      result[12 + row] = camera[row] * position[0] +
+                         camera[4 + row] * position[1] +
+                         camera[8 + row] * position[2] + camera[12 + row];
+    }
+    std::memcpy(destination_(out, stride, index, i), result, sizeof(result));
+  }
+}
+
+#ifdef GTAMFX_X86_
+// The kernels below compute the same thing for a vector of sprites at once,
+// every register holds one matrix element of all of them. Each output column
+// is transposed back to one vector per sprite before it is stored.
+
+__attribute__((target("sse4.1"))) void
+transformSse41_(const float *camera, const SpriteTransforms &in, size_t begin,
+                size_t end, char *out, size_t stride, const uint32_t *index) {
+  __m128 c[16];
+  for (int e = 0; e < 16; ++e)
+    c[e] = _mm_set1_ps(camera[e]);
+  const __m128 one = _mm_set1_ps(1), two = _mm_set1_ps(2);
+
+  size_t i = begin;
+  for (; i + 4 <= end; i += 4) {
+    const __m128 x = _mm_loadu_ps(in.rotation[0] + i),
+                 y = _mm_loadu_ps(in.rotation[1] + i),
+                 z = _mm_loadu_ps(in.rotation[2] + i),
+                 w = _mm_loadu_ps(in.rotation[3] + i);
+    const __m128 sx = _mm_mul_ps(_mm_loadu_ps(in.scale[0] + i), two),
+                 sy = _mm_mul_ps(_mm_loadu_ps(in.scale[1] + i), two),
+                 sz = _mm_mul_ps(_mm_loadu_ps(in.scale[2] + i), two);
+    const __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y),
+                 zz = _mm_mul_ps(z, z), xy = _mm_mul_ps(x, y),
+                 xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z),
+                 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y),
+                 wz = _mm_mul_ps(w, z);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    // scale is premultiplied by 2, so 1 - 2a becomes (0.5 - a) * 2s
+    const __m128 model[3][3] = {
+        {_mm_mul_ps(_mm_sub_ps(half, _mm_add_ps(yy, zz)), sx),
+         _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+         _mm_mul_ps(_mm_sub_ps(xz, wy), sx)},
+        {_mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+         _mm_mul_ps(_mm_sub_ps(half, _mm_add_ps(xx, zz)), sy),
+         _mm_mul_ps(_mm_add_ps(yz, wx), sy)},
+        {_mm_mul_ps(_mm_add_ps(xz, wy), sz),
+         _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+         _mm_mul_ps(_mm_sub_ps(half, _mm_add_ps(xx, yy)), sz)},
+    };
+    const __m128 position[4] = {_mm_loadu_ps(in.position[0] + i),
+                                _mm_loadu_ps(in.position[1] + i),
+                                _mm_loadu_ps(in.position[2] + i), one};
+
+    for (int column = 0; column < 4; ++column) {
+      __m128 rows[4];
+      for (int row = 0; row < 4; ++row) {
+        if (column < 3) {
+          rows[row] = _mm_add_ps(
+              _mm_add_ps(_mm_mul_ps(c[row], model[column][0]),
+                         _mm_mul_ps(c[4 + row], model[column][1])),
+              _mm_mul_ps(c[8 + row], model[column][2]));
+        } else {
+          rows[row] = _mm_add_ps(
+              _mm_add_ps(_mm_mul_ps(c[row], position[0]),
+                         _mm_mul_ps(c[4 + row], position[1])),
+              _mm_add_ps(_mm_mul_ps(c[8 + row], position[2]), c[12 + row]));
+        }
+      }
+      _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+      for (int lane = 0; lane < 4; ++lane)
+        _mm_storeu_ps(destination_(out, stride, index, i + lane) + column * 4,
+                      rows[lane]);
+    }
+  }
+  transformScalar_(camera, in, i, end, out, stride, index);
+}
+
+__attribute__((target("avx2,fma"))) void
+transformAvx2_(const float *camera, const SpriteTransforms &in, size_t begin,
+               size_t end, char *out, size_t stride, const uint32_t *index) {
+  __m256 c[16];
+  for (int e = 0; e < 16; ++e)
+    c[e] = _mm256_set1_ps(camera[e]);
+  const __m256 one = _mm256_set1_ps(1), two = _mm256_set1_ps(2),
+               half = _mm256_set1_ps(0.5f);
+
+  size_t i = begin;
+  for (; i + 8 <= end; i += 8) {
+    const __m256 x = _mm256_loadu_ps(in.rotation[0] + i),
+                 y = _mm256_loadu_ps(in.rotation[1] + i),
+                 z = _mm256_loadu_ps(in.rotation[2] + i),
+                 w = _mm256_loadu_ps(in.rotation[3] + i);
+    const __m256 sx = _mm256_mul_ps(_mm256_loadu_ps(in.scale[0] + i), two),
+                 sy = _mm256_mul_ps(_mm256_loadu_ps(in.scale[1] + i), two),
+                 sz = _mm256_mul_ps(_mm256_loadu_ps(in.scale[2] + i), two);
+    const __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y),
+                 zz = _mm256_mul_ps(z, z), xy = _mm256_mul_ps(x, y),
+                 xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z),
+                 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y),
+                 wz = _mm256_mul_ps(w, z);
+
+    const __m256 model[3][3] = {
+        {_mm256_mul_ps(_mm256_sub_ps(half, _mm256_add_ps(yy, zz)), sx),
+         _mm256_mul_ps(_mm256_add_ps(xy, wz), sx),
+         _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx)},
+        {_mm256_mul_ps(_mm256_sub_ps(xy, wz), sy),
+         _mm256_mul_ps(_mm256_sub_ps(half, _mm256_add_ps(xx, zz)), sy),
+         _mm256_mul_ps(_mm256_add_ps(yz, wx), sy)},
+        {_mm256_mul_ps(_mm256_add_ps(xz, wy), sz),
+         _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz),
+         _mm256_mul_ps(_mm256_sub_ps(half, _mm256_add_ps(xx, yy)), sz)},
+    };
+    const __m256 position[4] = {_mm256_loadu_ps(in.position[0] + i),
+                                _mm256_loadu_ps(in.position[1] + i),
+                                _mm256_loadu_ps(in.position[2] + i), one};
+
+    for (int column = 0; column < 4; ++column) {
+      __m256 rows[4];
+      for (int row = 0; row < 4; ++row) {
+        if (column < 3) {
+          rows[row] = _mm256_fmadd_ps(
+              c[row], model[column][0],
+              _mm256_fmadd_ps(c[4 + row], model[column][1],
+                              _mm256_mul_ps(c[8 + row], model[column][2])));
+        } else {
+          rows[row] = _mm256_fmadd_ps(
+              c[row], position[0],
+              _mm256_fmadd_ps(c[4 + row], position[1],
+                              _mm256_fmadd_ps(c[8 + row], position[2],
+                                              c[12 + row])));
+        }
+      }
+
+      // lanes 0-3 in the low halves, 4-7 in the high halves
+      const __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]),
+                   t1 = _mm256_unpackhi_ps(rows[0], rows[1]),
+                   t2 = _mm256_unpacklo_ps(rows[2], rows[3]),
+                   t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+      const __m256 sprite[4] = {_mm256_shuffle_ps(t0, t2, 0x44),
+                                _mm256_shuffle_ps(t0, t2, 0xee),
+                                _mm256_shuffle_ps(t1, t3, 0x44),
+                                _mm256_shuffle_ps(t1, t3, 0xee)};
+      for (int lane = 0; lane < 4; ++lane) {
+        _mm_storeu_ps(destination_(out, stride, index, i + lane) + column * 4,
+                      _mm256_castps256_ps128(sprite[lane]));
+        _mm_storeu_ps(destination_(out, stride, index, i + lane + 4) +
+                          column * 4,
+                      _mm256_extractf128_ps(sprite[lane], 1));
+      }
+    }
+  }
+  transformScalar_(camera, in, i, end, out, stride, index);
+}
+#endif
+} // namespace
+
+TransformKernel getBestTransformKernel() {
+  static const TransformKernel best = [] {
+    if (isTransformKernelSupported(TransformKernel::Avx2))
+      return TransformKernel::Avx2;
+    if (isTransformKernelSupported(TransformKernel::Sse41))
+      return TransformKernel::Sse41;
+    return TransformKernel::Scalar;
+  }();
+  return best;
+}
+
+bool isTransformKernelSupported(TransformKernel kernel) {
+  switch (kernel) {
+  case TransformKernel::Scalar:
+    return true;
+#ifdef GTAMFX_X86_
+  case TransformKernel::Sse41:
+    return __builtin_cpu_supports("sse4.1");
+  case TransformKernel::Avx2:
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+  default:
+    return false;
+  }
+}
+
+const char *getTransformKernelName(TransformKernel kernel) {
+  switch (kernel) {
+  case TransformKernel::Scalar:
+    return "scalar";
+  case TransformKernel::Sse41:
+    return "sse4.1";
+  case TransformKernel::Avx2:
+    return "avx2";
+  }
+  return "?";
+}
+
+void transformSprites(TransformKernel kernel, const glm::mat4 &camera,
+                      const SpriteTransforms &in, size_t count, void *out,
+                      size_t stride, const uint32_t *index) {
+  const float *matrix = &camera[0][0];
+  char *bytes = (char *)out;
+  switch (kernel) {
+#ifdef GTAMFX_X86_
+  case TransformKernel::Avx2:
+    transformAvx2_(matrix, in, 0, count, bytes, stride, index);
+    return;
+  case TransformKernel::Sse41:
+    transformSse41_(matrix, in, 0, count, bytes, stride, index);
+    return;
+#endif
+  default:
+    transformScalar_(matrix, in, 0, count, bytes, stride, index);
+  }
+}
+} // namespace gtamfx
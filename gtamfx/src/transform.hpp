@@ -0,0 +1,30 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gtamfx {
+// structure of arrays input of `transformSprites`
+struct SpriteTransforms {
+  const float *position[3];
+  const float *rotation[4]; // quaternion x, y, z, w
+  const float *scale[3];
+};
+
+enum class TransformKernel { Scalar = 0, Sse41 = 1, Avx2 = 2 };
+
+// the widest kernel the cpu we are running on supports
+TransformKernel getBestTransformKernel();
+bool isTransformKernelSupported(TransformKernel kernel);
+const char *getTransformKernelName(TransformKernel kernel);
+
+// Writes camera * translate(position) * mat4_cast(rotation) * scale(scale) of
+// `count` sprites as column-major 4x4 float matrices. The i-th one goes to
+// `out + index[i] * stride` bytes, or `out + i * stride` without `index`, so
+// it can land right in a strided upload buffer. `kernel` must be supported.
+void transformSprites(TransformKernel kernel, const glm::mat4 &camera,
+                      const SpriteTransforms &in, size_t count, void *out,
+                      size_t stride, const uint32_t *index = nullptr);
+} // namespace gtamfx
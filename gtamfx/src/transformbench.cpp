@@ -0,0 +1,144 @@
+#include "transform.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Times the sprite transform kernels against the glm code every sprite used to
+// go through, without a window or gl. Usage: transformbench [-n sprites]
+// [-r repeats]
+
+namespace {
+using Clock_ = std::chrono::steady_clock;
+
+struct Input_ {
+  std::vector<glm::vec3> position, scale;
+  std::vector<glm::quat> rotation;
+  std::vector<float> soa[10];
+
+  gtamfx::SpriteTransforms transforms() const {
+    return {{soa[0].data(), soa[1].data(), soa[2].data()},
+            {soa[3].data(), soa[4].data(), soa[5].data(), soa[6].data()},
+            {soa[7].data(), soa[8].data(), soa[9].data()}};
+  }
+};
+
+Input_ makeInput_(size_t count) {
+  std::mt19937 random(1234);
+  auto uniform = [&](float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(random);
+  };
+
+  Input_ input;
+  for (size_t i = 0; i < count; ++i) {
+    const glm::vec3 position = {uniform(-640, 640), uniform(-360, 360),
+                                uniform(-1, 1)};
+    const glm::vec3 scale = {uniform(4, 64), uniform(4, 64), 1};
+    const glm::quat rotation =
+        glm::angleAxis(uniform(0, 6.28f), glm::vec3(0, 0, 1));
+    input.position.push_back(position);
+    input.scale.push_back(scale);
+    input.rotation.push_back(rotation);
+
+    for (int axis = 0; axis < 3; ++axis) {
+      input.soa[axis].push_back(position[axis]);
+      input.soa[7 + axis].push_back(scale[axis]);
+    }
+    input.soa[3].push_back(rotation.x);
+    input.soa[4].push_back(rotation.y);
+    input.soa[5].push_back(rotation.z);
+    input.soa[6].push_back(rotation.w);
+  }
+  return input;
+}
+
+// the camera matrix of an orthographic camera a bit off the origin
+glm::mat4 cameraView_() {
+  return glm::translate(glm::mat4(1.0f), -glm::vec3(100, 50, 0));
+}
+glm::mat4 cameraProjection_() {
+  return glm::ortho(-640.0f, 640.0f, -360.0f, 360.0f, -1.0f, 1.0f);
+}
+
+// what computeTransformMatrix did per sprite, camera matrix included
+void transformReference_(const Input_ &input, glm::mat4 *out) {
+  for (size_t i = 0; i < input.position.size(); ++i) {
+    glm::mat4 model = glm::mat4(1.0f);
+    model *= glm::translate(glm::mat4(1.0f), input.position[i]);
+    model *= glm::mat4_cast(input.rotation[i]);
+    model *= glm::scale(glm::mat4(1.0f), input.scale[i]);
+    out[i] = cameraProjection_() * cameraView_() * model;
+  }
+}
+
+template <typename F> double timeNs_(int repeats, size_t count, F &&run) {
+  double best = INFINITY;
+  for (int repeat = 0; repeat < repeats; ++repeat) {
+    const Clock_::time_point start = Clock_::now();
+    run();
+    const std::chrono::duration<double, std::nano> elapsed =
+        Clock_::now() - start;
+    best = std::min(best, elapsed.count() / count);
+  }
+  return best;
+}
+
+float maxError_(const std::vector<glm::mat4> &a,
+                const std::vector<glm::mat4> &b) {
+  float error = 0;
+  for (size_t i = 0; i < a.size(); ++i)
+    for (int column = 0; column < 4; ++column)
+      for (int row = 0; row < 4; ++row)
+        error = std::max(error, std::abs(a[i][column][row] - b[i][column][row]));
+  return error;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  size_t count = 100000;
+  int repeats = 20;
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "-n") && hasValue)
+      count = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-r") && hasValue)
+      repeats = std::max(1, atoi(argv[++i]));
+    else {
+      fprintf(stderr, "Usage: %s [-n sprites] [-r repeats]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  const Input_ input = makeInput_(count);
+  std::vector<glm::mat4> reference(count), result(count);
+
+  const double referenceNs = timeNs_(
+      repeats, count, [&] { transformReference_(input, reference.data()); });
+  printf("%-10s %8.2f ns/sprite\n", "glm", referenceNs);
+
+  const glm::mat4 camera = cameraProjection_() * cameraView_();
+  const gtamfx::TransformKernel kernels[] = {gtamfx::TransformKernel::Scalar,
+                                             gtamfx::TransformKernel::Sse41,
+                                             gtamfx::TransformKernel::Avx2};
+  for (gtamfx::TransformKernel kernel : kernels) {
+    if (!gtamfx::isTransformKernelSupported(kernel))
+      continue;
+    std::fill(result.begin(), result.end(), glm::mat4(0.0f));
+    const double ns = timeNs_(repeats, count, [&] {
+      gtamfx::transformSprites(kernel, camera, input.transforms(), count,
+                               result.data(), sizeof(glm::mat4));
+    });
+    printf("%-10s %8.2f ns/sprite %5.2fx, max error %g\n",
+           gtamfx::getTransformKernelName(kernel), ns, referenceNs / ns,
+           maxError_(reference, result));
+  }
+  return 0;
+}
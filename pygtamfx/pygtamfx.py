@@ -10,6 +10,11 @@ except ImportError:
     print("Please install PyGLM.")
     exit(1)
 
+try:
+    import numpy as _numpy
+except ImportError:
+    _numpy = None
+
 if typing.TYPE_CHECKING:
     _Ptr = _ctypes._Pointer
 else:
@@ -92,28 +97,155 @@ class _CQuat(_ctypes.Structure):
 _CWindow = _ctypes.c_void_p
 
 
+class _CHandle(_ctypes.Structure):
+    _fields_ = [("index", _ctypes.c_uint32), ("generation", _ctypes.c_uint32)]
+
+    def __bool__(self) -> bool:
+        return self.generation != 0
+
+    def __eq__(self, other) -> bool:
+        return (
+            isinstance(other, _CHandle)
+            and self.index == other.index
+            and self.generation == other.generation
+        )
+
+    def __hash__(self) -> int:
+        return hash((self.index, self.generation))
+
+
+class _CTextureRegion_(_ctypes.Structure):
+    _fields_ = [("position", _CVec2), ("scale", _CVec2)]
+
+
 class _CTexture(_ctypes.Structure):
-    _fields_ = [("id", _ctypes.c_uint), ("size", _CVec2)]
+    _fields_ = [
+        ("id", _ctypes.c_uint),
+        ("size", _CVec2),
+        ("region", _CTextureRegion_),
+        ("state", _ctypes.c_int),
+    ]
+
+
+class _CAtlasOptions(_ctypes.Structure):
+    _fields_ = [
+        ("enabled", _ctypes.c_int),
+        ("pageSize", _ctypes.c_int),
+        ("maxImageSize", _ctypes.c_int),
+        ("padding", _ctypes.c_int),
+    ]
+
+
+class _CTextureResidencyStats(_ctypes.Structure):
+    _fields_ = [
+        ("budget", _ctypes.c_size_t),
+        ("residentBytes", _ctypes.c_size_t),
+        ("residentCount", _ctypes.c_size_t),
+        ("evictedCount", _ctypes.c_size_t),
+        ("evictions", _ctypes.c_size_t),
+        ("reloads", _ctypes.c_size_t),
+    ]
+
+
+class _CProgramCacheStats(_ctypes.Structure):
+    _fields_ = [
+        ("hits", _ctypes.c_size_t),
+        ("misses", _ctypes.c_size_t),
+        ("rejected", _ctypes.c_size_t),
+        ("stored", _ctypes.c_size_t),
+    ]
+
+
+class _CStreamStats(_ctypes.Structure):
+    _fields_ = [
+        ("persistent", _ctypes.c_int),
+        ("capacity", _ctypes.c_size_t),
+        ("bytesStreamed", _ctypes.c_size_t),
+        ("allocations", _ctypes.c_size_t),
+        ("reallocations", _ctypes.c_size_t),
+        ("fenceWaits", _ctypes.c_size_t),
+        ("fenceWaitTime", _ctypes.c_double),
+    ]
+
+
+class _CAtlasStats(_ctypes.Structure):
+    _fields_ = [
+        ("pageCount", _ctypes.c_size_t),
+        ("imageCount", _ctypes.c_size_t),
+        ("usedPixels", _ctypes.c_size_t),
+        ("totalPixels", _ctypes.c_size_t),
+    ]
+
+
+class _CCpuTime_(_ctypes.Structure):
+    _fields_ = [
+        ("poll", _ctypes.c_double),
+        ("upload", _ctypes.c_double),
+        ("sort", _ctypes.c_double),
+        ("cull", _ctypes.c_double),
+        ("transform", _ctypes.c_double),
+        ("submit", _ctypes.c_double),
+        ("swap", _ctypes.c_double),
+        ("total", _ctypes.c_double),
+    ]
+
+
+class _CFrameStats(_ctypes.Structure):
+    _fields_ = [
+        ("frame", _ctypes.c_uint64),
+        ("cpuTime", _CCpuTime_),
+        ("gpuTime", _ctypes.c_double),
+        ("drawCalls", _ctypes.c_size_t),
+        ("programBinds", _ctypes.c_size_t),
+        ("textureBinds", _ctypes.c_size_t),
+        ("uniformUploads", _ctypes.c_size_t),
+        ("spritesDrawn", _ctypes.c_size_t),
+        ("spritesCulled", _ctypes.c_size_t),
+        ("stateChangesFiltered", _ctypes.c_size_t),
+        ("tileChunksDrawn", _ctypes.c_size_t),
+        ("textsDrawn", _ctypes.c_size_t),
+        ("particlesSimulated", _ctypes.c_size_t),
+    ]
 
 
 class _CShader(_ctypes.Structure):
     _fields_ = [("id", _ctypes.c_uint),
                 ("vertexCount", _ctypes.c_size_t),
-                ("line", _ctypes.c_bool)]
+                ("line", _ctypes.c_bool),
+                ("instanced", _ctypes.c_bool),
+                ("cameraBlock", _ctypes.c_bool)]
+
+
+class _CShaderUniform(_ctypes.Structure):
+    _fields_ = [
+        ("name", _ctypes.c_char_p),
+        ("type", _ctypes.c_uint),
+        ("size", _ctypes.c_int),
+        ("location", _ctypes.c_int),
+        ("block", _ctypes.c_int),
+    ]
+
+
+class _CShaderUniformBlock(_ctypes.Structure):
+    _fields_ = [
+        ("name", _ctypes.c_char_p),
+        ("size", _ctypes.c_int),
+        ("binding", _ctypes.c_uint),
+    ]
 
 
 class _CTextureView(_ctypes.Structure):
     _fields_ = [
         ("position", _CVec2),
         ("scale", _CVec2),
-        ("source", _ctypes.POINTER(_CTexture)),
+        ("source", _CHandle),
     ]
 
 
 class _CSprite(_ctypes.Structure):
     _fields_ = [
         ("texture", _CTextureView),
-        ("shader", _ctypes.POINTER(_CShader)),
+        ("shader", _CHandle),
         ("color", _CVec4),
         ("position", _CVec3),
         ("scale", _CVec3),
@@ -121,6 +253,76 @@ class _CSprite(_ctypes.Structure):
     ]
 
 
+class _CTilemap(_ctypes.Structure):
+    _fields_ = [
+        ("texture", _CHandle),
+        ("shader", _CHandle),
+        ("size", _CVec2i),
+        ("atlasSize", _CVec2i),
+        ("position", _CVec3),
+        ("tileSize", _CVec2),
+    ]
+
+
+class _CPack(_ctypes.Structure):
+    _fields_ = [
+        ("textureCount", _ctypes.c_size_t),
+        ("shaderCount", _ctypes.c_size_t),
+        ("bytes", _ctypes.c_size_t),
+    ]
+
+
+class _CFont(_ctypes.Structure):
+    _fields_ = [
+        ("ascent", _ctypes.c_float),
+        ("descent", _ctypes.c_float),
+        ("lineHeight", _ctypes.c_float),
+        ("glyphSize", _ctypes.c_int),
+    ]
+
+
+class _CText(_ctypes.Structure):
+    _fields_ = [
+        ("font", _CHandle),
+        ("shader", _CHandle),
+        ("position", _CVec3),
+        ("rotation", _CQuat),
+        ("size", _ctypes.c_float),
+        ("color", _CVec4),
+    ]
+
+
+class _CParticleEmitter(_ctypes.Structure):
+    _fields_ = [
+        ("texture", _CHandle),
+        ("shader", _CHandle),
+        ("position", _CVec3),
+        ("positionSpread", _CVec3),
+        ("velocity", _CVec3),
+        ("velocitySpread", _CVec3),
+        ("acceleration", _CVec3),
+        ("rate", _ctypes.c_float),
+        ("lifetime", _ctypes.c_float),
+        ("lifetimeSpread", _ctypes.c_float),
+        ("startColor", _CVec4),
+        ("endColor", _CVec4),
+        ("startSize", _ctypes.c_float),
+        ("endSize", _ctypes.c_float),
+    ]
+
+
+class _CSpriteBatch(_ctypes.Structure):
+    _fields_ = [
+        ("count", _ctypes.c_size_t),
+        ("sprites", _ctypes.POINTER(_CHandle)),
+        ("positions", _ctypes.POINTER(_ctypes.c_float)),
+        ("scales", _ctypes.POINTER(_ctypes.c_float)),
+        ("rotations", _ctypes.POINTER(_ctypes.c_float)),
+        ("colors", _ctypes.POINTER(_ctypes.c_float)),
+        ("textureViews", _ctypes.POINTER(_ctypes.c_float)),
+    ]
+
+
 class _CCameraOpts_Perspective_(_ctypes.Structure):
     _fields_ = [
         ("fov", _ctypes.c_float),
@@ -168,6 +370,10 @@ _GTAM_ERROR_GL3W_FAILED_INIT = 3
 _GTAM_ERROR_GL3W_BAD_VERSION = 4
 _GTAM_ERROR_TEXTURE_LOAD_FAIL = 5
 _GTAM_ERROR_SHADER_LOAD_FAIL = 6
+_GTAM_ERROR_INVALID_HANDLE = 7
+_GTAM_ERROR_HEADLESS_FAILED_INIT = 8
+_GTAM_ERROR_FONT_LOAD_FAIL = 9
+_GTAM_ERROR_PACK_LOAD_FAIL = 10
 
 _GTAM_ERROR_STRINGS = [
     "None",
@@ -177,6 +383,10 @@ _GTAM_ERROR_STRINGS = [
     "Bad version reported by GL3W",
     "Failed to load texture",
     "Failed to load shader",
+    "Invalid handle",
+    "Failed to create headless context",
+    "Failed to load font",
+    "Failed to load asset pack",
 ]
 
 
@@ -190,8 +400,14 @@ _C.gtamGetError.argtypes = []
 _C.gtamGetError.restype = _ctypes.c_int
 _C.gtamGetErrorMessage.argtypes = []
 _C.gtamGetErrorMessage.restype = _ctypes.c_char_p
+_C.gtamWindowGetError.argtypes = [_CWindow]
+_C.gtamWindowGetError.restype = _ctypes.c_int
+_C.gtamWindowGetErrorMessage.argtypes = [_CWindow]
+_C.gtamWindowGetErrorMessage.restype = _ctypes.c_char_p
 _C.gtamCreateWindow.argtypes = [_CVec2i, _ctypes.c_char_p]
 _C.gtamCreateWindow.restype = _CWindow
+_C.gtamCreateHeadlessWindow.argtypes = [_CVec2i]
+_C.gtamCreateHeadlessWindow.restype = _CWindow
 _C.gtamDestroyWindow.argtypes = [_CWindow]
 _C.gtamInitWindow.argtypes = [_CWindow]
 _C.gtamWindowShouldClose.argtypes = [_CWindow]
@@ -207,75 +423,410 @@ _C.gtamWindowIsKeyDown.restype = _ctypes.c_int
 _C.gtamWindowIsMouseDown.argtypes = [_CWindow, _ctypes.c_int]
 _C.gtamWindowIsMouseDown.restype = _ctypes.c_int
 _C.gtamWindowGetMousePosition.argtypes = [_CWindow, _ctypes.POINTER(_CVec2)]
+_C.gtamWindowSetAtlasOptions.argtypes = [_CWindow, _ctypes.POINTER(_CAtlasOptions)]
+_C.gtamWindowGetAtlasStats.argtypes = [_CWindow, _ctypes.POINTER(_CAtlasStats)]
 _C.gtamWindowNewTexture.argtypes = [_CWindow, _ctypes.c_char_p]
-_C.gtamWindowNewTexture.restype = _ctypes.POINTER(_CTexture)
-_C.gtamWindowDelTexture.argtypes = [_CWindow, _ctypes.POINTER(_CTexture)]
+_C.gtamWindowNewTexture.restype = _CHandle
+_CTextureCallback = _ctypes.CFUNCTYPE(None, _CHandle, _ctypes.c_int, _ctypes.c_void_p)
+_C.gtamWindowNewTextureAsync.argtypes = [
+    _CWindow,
+    _ctypes.c_char_p,
+    _CTextureCallback,
+    _ctypes.c_void_p,
+]
+_C.gtamWindowNewTextureAsync.restype = _CHandle
+_C.gtamWindowSetTextureUploadBudget.argtypes = [_CWindow, _ctypes.c_size_t]
+_C.gtamWindowSetTextureBudget.argtypes = [_CWindow, _ctypes.c_size_t]
+_C.gtamWindowGetTextureResidencyStats.argtypes = [
+    _CWindow,
+    _ctypes.POINTER(_CTextureResidencyStats),
+]
+_C.gtamWindowGetPendingTextureCount.argtypes = [_CWindow]
+_C.gtamWindowGetPendingTextureCount.restype = _ctypes.c_size_t
+_C.gtamWindowDelTexture.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetTexture.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetTexture.restype = _ctypes.POINTER(_CTexture)
 _C.gtamWindowNewShader.argtypes = [
     _CWindow,
     _ctypes.c_char_p,
     _ctypes.c_char_p,
     _ctypes.c_size_t,
 ]
-_C.gtamWindowNewShader.restype = _ctypes.POINTER(_CShader)
-_C.gtamWindowDelShader.argtypes = [_CWindow, _ctypes.POINTER(_CShader)]
-_C.gtamWindowNewSprite.argtypes = [
+_C.gtamWindowNewShader.restype = _CHandle
+_C.gtamWindowDelShader.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowSetProgramCacheDirectory.argtypes = [_CWindow, _ctypes.c_char_p]
+_C.gtamWindowGetProgramCacheStats.argtypes = [
     _CWindow,
-    _ctypes.POINTER(_CTexture),
-    _ctypes.POINTER(_CShader),
+    _ctypes.POINTER(_CProgramCacheStats),
+]
+_C.gtamWindowGetShader.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetShader.restype = _ctypes.POINTER(_CShader)
+_C.gtamWindowGetShaderUniformCount.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetShaderUniformCount.restype = _ctypes.c_size_t
+_C.gtamWindowGetShaderUniform.argtypes = [
+    _CWindow,
+    _CHandle,
+    _ctypes.c_size_t,
+    _ctypes.POINTER(_CShaderUniform),
+]
+_C.gtamWindowGetShaderUniformBlockCount.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetShaderUniformBlockCount.restype = _ctypes.c_size_t
+_C.gtamWindowGetShaderUniformBlock.argtypes = [
+    _CWindow,
+    _CHandle,
+    _ctypes.c_size_t,
+    _ctypes.POINTER(_CShaderUniformBlock),
+]
+_C.gtamWindowLoadPack.argtypes = [_CWindow, _ctypes.c_char_p]
+_C.gtamWindowLoadPack.restype = _CHandle
+_C.gtamWindowUnloadPack.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetPack.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetPack.restype = _ctypes.POINTER(_CPack)
+_C.gtamWindowNewTextureFromPack.argtypes = [_CWindow, _CHandle, _ctypes.c_char_p]
+_C.gtamWindowNewTextureFromPack.restype = _CHandle
+_C.gtamWindowNewShaderFromPack.argtypes = [
+    _CWindow,
+    _CHandle,
+    _ctypes.c_char_p,
+    _ctypes.c_size_t,
+]
+_C.gtamWindowNewShaderFromPack.restype = _CHandle
+_C.gtamWindowSetShaderParameter.argtypes = [
+    _CWindow,
+    _CHandle,
+    _ctypes.c_char_p,
+    _ctypes.POINTER(_ctypes.c_float),
+    _ctypes.c_size_t,
+]
+_C.gtamWindowSetShaderParameterInt.argtypes = [
+    _CWindow,
+    _CHandle,
+    _ctypes.c_char_p,
+    _ctypes.POINTER(_ctypes.c_int),
+    _ctypes.c_size_t,
+]
+_C.gtamWindowNewSprite.argtypes = [_CWindow, _CHandle, _CHandle]
+_C.gtamWindowNewSprite.restype = _CHandle
+_C.gtamWindowDelSprite.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetSprite.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetSprite.restype = _ctypes.POINTER(_CSprite)
+_C.gtamWindowNewSprites.argtypes = [
+    _CWindow,
+    _CHandle,
+    _CHandle,
+    _ctypes.c_size_t,
+    _ctypes.POINTER(_CHandle),
+]
+_C.gtamWindowNewSprites.restype = _ctypes.c_size_t
+_C.gtamWindowDelSprites.argtypes = [_CWindow, _ctypes.POINTER(_CHandle), _ctypes.c_size_t]
+for _setter in (
+    _C.gtamWindowSetSpritePositions,
+    _C.gtamWindowSetSpriteScales,
+    _C.gtamWindowSetSpriteRotations,
+    _C.gtamWindowSetSpriteColors,
+    _C.gtamWindowSetSpriteTextureViews,
+):
+    _setter.argtypes = [
+        _CWindow,
+        _ctypes.POINTER(_CHandle),
+        _ctypes.c_size_t,
+        _ctypes.c_void_p,
+        _ctypes.c_size_t,
+    ]
+    _setter.restype = _ctypes.c_size_t
+_C.gtamWindowNewSpriteBatch.argtypes = [_CWindow, _CHandle, _CHandle, _ctypes.c_size_t]
+_C.gtamWindowNewSpriteBatch.restype = _CHandle
+_C.gtamWindowDelSpriteBatch.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetSpriteBatch.argtypes = [_CWindow, _CHandle, _ctypes.POINTER(_CSpriteBatch)]
+_C.gtamWindowGetSpriteBatch.restype = _ctypes.c_int
+_C.gtamWindowResizeSpriteBatch.argtypes = [_CWindow, _CHandle, _ctypes.c_size_t]
+_C.gtamWindowNewTilemap.argtypes = [
+    _CWindow,
+    _CHandle,
+    _CHandle,
+    _CVec2i,
+    _CVec2i,
+    _ctypes.c_size_t,
+]
+_C.gtamWindowNewTilemap.restype = _CHandle
+_C.gtamWindowDelTilemap.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetTilemap.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetTilemap.restype = _ctypes.POINTER(_CTilemap)
+_C.gtamWindowGetTilemapLayerCount.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetTilemapLayerCount.restype = _ctypes.c_size_t
+_C.gtamWindowSetTile.argtypes = [
+    _CWindow,
+    _CHandle,
+    _ctypes.c_size_t,
+    _CVec2i,
+    _ctypes.c_uint16,
 ]
-_C.gtamWindowNewSprite.restype = _ctypes.POINTER(_CSprite)
-_C.gtamWindowDelSprite.argtypes = [_CWindow, _ctypes.POINTER(_CSprite)]
+_C.gtamWindowGetTile.argtypes = [_CWindow, _CHandle, _ctypes.c_size_t, _CVec2i]
+_C.gtamWindowGetTile.restype = _ctypes.c_uint16
+_C.gtamWindowSetTiles.argtypes = [
+    _CWindow,
+    _CHandle,
+    _ctypes.c_size_t,
+    _CVec2i,
+    _CVec2i,
+    _ctypes.POINTER(_ctypes.c_uint16),
+]
+_C.gtamWindowSetTilemapLayerDepth.argtypes = [
+    _CWindow,
+    _CHandle,
+    _ctypes.c_size_t,
+    _ctypes.c_float,
+]
+_C.gtamWindowGetTilemapLayerDepth.argtypes = [_CWindow, _CHandle, _ctypes.c_size_t]
+_C.gtamWindowGetTilemapLayerDepth.restype = _ctypes.c_float
+_C.gtamWindowNewFont.argtypes = [_CWindow, _ctypes.c_char_p, _ctypes.c_int]
+_C.gtamWindowNewFont.restype = _CHandle
+_C.gtamWindowDelFont.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetFont.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetFont.restype = _ctypes.POINTER(_CFont)
+_C.gtamWindowSetFontCacheDirectory.argtypes = [_CWindow, _ctypes.c_char_p]
+_C.gtamWindowNewText.argtypes = [_CWindow, _CHandle, _CHandle, _ctypes.c_char_p]
+_C.gtamWindowNewText.restype = _CHandle
+_C.gtamWindowDelText.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetText.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetText.restype = _ctypes.POINTER(_CText)
+_C.gtamWindowSetTextString.argtypes = [_CWindow, _CHandle, _ctypes.c_char_p]
+_C.gtamWindowGetTextString.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetTextString.restype = _ctypes.c_char_p
+_C.gtamWindowGetTextExtent.argtypes = [_CWindow, _CHandle, _ctypes.POINTER(_CVec2)]
+_C.gtamWindowNewParticleEmitter.argtypes = [
+    _CWindow,
+    _CHandle,
+    _CHandle,
+    _ctypes.c_size_t,
+]
+_C.gtamWindowNewParticleEmitter.restype = _CHandle
+_C.gtamWindowDelParticleEmitter.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetParticleEmitter.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetParticleEmitter.restype = _ctypes.POINTER(_CParticleEmitter)
+_C.gtamWindowGetParticleEmitterCapacity.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetParticleEmitterCapacity.restype = _ctypes.c_size_t
+_C.gtamWindowEmitParticles.argtypes = [_CWindow, _CHandle, _ctypes.c_size_t]
+_C.gtamWindowSetParticleTimeStep.argtypes = [_CWindow, _ctypes.c_float]
 _C.gtamWindowNewCamera.argtypes = [_CWindow, _ctypes.c_int]
-_C.gtamWindowNewCamera.restype = _ctypes.POINTER(_CCamera)
-_C.gtamWindowDelCamera.argtypes = [_CWindow, _ctypes.POINTER(_CCamera)]
-_C.gtamWindowSetActiveCamera.argtypes = [_CWindow, _ctypes.POINTER(_CCamera)]
+_C.gtamWindowNewCamera.restype = _CHandle
+_C.gtamWindowDelCamera.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetCamera.argtypes = [_CWindow, _CHandle]
+_C.gtamWindowGetCamera.restype = _ctypes.POINTER(_CCamera)
+_C.gtamWindowSetActiveCamera.argtypes = [_CWindow, _CHandle]
 _C.gtamWindowGetActiveCamera.argtypes = [_CWindow]
-_C.gtamWindowGetActiveCamera.restype = _ctypes.POINTER(_CCamera)
+_C.gtamWindowGetActiveCamera.restype = _CHandle
+_C.gtamWindowSetCulling.argtypes = [_CWindow, _ctypes.c_int]
+_C.gtamWindowSetThreadCount.argtypes = [_CWindow, _ctypes.c_size_t]
+_C.gtamWindowGetThreadCount.argtypes = [_CWindow]
+_C.gtamWindowGetThreadCount.restype = _ctypes.c_size_t
+_C.gtamWindowSetGlDebugMode.argtypes = [_CWindow, _ctypes.c_int]
+_C.gtamWindowGetGlDebugMode.argtypes = [_CWindow]
+_C.gtamWindowGetGlDebugMode.restype = _ctypes.c_int
+
+
+class _CGlDebugMessage(_ctypes.Structure):
+    _fields_ = [
+        ("source", _ctypes.c_uint),
+        ("type", _ctypes.c_uint),
+        ("id", _ctypes.c_uint),
+        ("severity", _ctypes.c_int),
+        ("text", _ctypes.c_char_p),
+    ]
+
+
+_CGlDebugCallback = _ctypes.CFUNCTYPE(
+    None, _ctypes.POINTER(_CGlDebugMessage), _ctypes.c_void_p
+)
+_C.gtamWindowSetGlDebugCallback.argtypes = [
+    _CWindow,
+    _CGlDebugCallback,
+    _ctypes.c_void_p,
+]
+_C.gtamWindowGetSpritesInRect.argtypes = [
+    _CWindow,
+    _CVec2,
+    _CVec2,
+    _ctypes.POINTER(_CHandle),
+    _ctypes.c_size_t,
+]
+_C.gtamWindowGetSpritesInRect.restype = _ctypes.c_size_t
+_C.gtamWindowGetSpritesAtPoint.argtypes = [
+    _CWindow,
+    _CVec2,
+    _ctypes.POINTER(_CHandle),
+    _ctypes.c_size_t,
+]
+_C.gtamWindowGetSpritesAtPoint.restype = _ctypes.c_size_t
+_C.gtamWindowScreenToWorld.argtypes = [_CWindow, _CVec2, _ctypes.POINTER(_CVec2)]
 _C.gtamWindowGetFramebufferSize.argtypes = [_CWindow, _ctypes.POINTER(_CVec2)]
 _C.gtamWindowGetAspectRatio.argtypes = [_CWindow]
 _C.gtamWindowGetAspectRatio.restype = _ctypes.c_float
+_C.gtamWindowGetFrameStats.argtypes = [_CWindow, _ctypes.POINTER(_CFrameStats)]
+_C.gtamWindowGetFrameStatsHistory.argtypes = [
+    _CWindow,
+    _ctypes.POINTER(_CFrameStats),
+    _ctypes.c_size_t,
+]
+_C.gtamWindowGetFrameStatsHistory.restype = _ctypes.c_size_t
+_C.gtamWindowSetFrameStatsHistorySize.argtypes = [_CWindow, _ctypes.c_size_t]
+_C.gtamWindowGetStreamStats.argtypes = [_CWindow, _ctypes.POINTER(_CStreamStats)]
+_C.gtamWindowIsHeadless.argtypes = [_CWindow]
+_C.gtamWindowIsHeadless.restype = _ctypes.c_int
+_C.gtamWindowReadPixels.argtypes = [_CWindow, _ctypes.c_void_p]
+
+
+class _Object:
+    """Handle to an object owned by a window.
 
+    The data is looked up on every access, since the engine may move it
+    around; accessing an object after it was deleted raises ValueError.
+    """
 
-class Texture:
-    def __init__(self, handle: _Ptr[_CTexture]):
+    _getter: typing.Any = None
+
+    def __init__(self, window: _CWindow, handle: _CHandle):
+        self._window = window
         self._handle = handle
 
+    @property
+    def _data(self):
+        ptr = type(self)._getter(self._window, self._handle)
+        if not ptr:
+            raise ValueError(f"stale {type(self).__name__.lower()} handle")
+        return ptr[0]
+
+    @property
+    def alive(self) -> bool:
+        return not not type(self)._getter(self._window, self._handle)
+
+    def __eq__(self, other) -> bool:
+        return type(self) is type(other) and self._handle == other._handle
+
+    def __hash__(self) -> int:
+        return hash(self._handle)
+
+
+class TextureState(_enum.IntEnum):
+    RESIDENT = 0
+    LOADING = 1
+    FAILED = 2
+    EVICTED = 3
+
+
+class Texture(_Object):
+    _getter = _C.gtamWindowGetTexture
+
+    @property
+    def state(self) -> TextureState:
+        return TextureState(self._data.state)
+
     @property
     def id(self) -> int:
-        return self._handle[0].id
+        return self._data.id
 
     @property
     def size(self):
-        return self._handle[0].size.to_glm()
+        return self._data.size.to_glm()
+
+    @property
+    def region_position(self) -> glm.vec2:
+        return self._data.region.position.to_glm()
+
+    @property
+    def region_scale(self) -> glm.vec2:
+        return self._data.region.scale.to_glm()
 
 
-class Shader:
-    def __init__(self, handle: _Ptr[_CShader]):
-        self._handle = handle
+class Shader(_Object):
+    _getter = _C.gtamWindowGetShader
 
     @property
     def id(self) -> int:
-        return self._handle[0].id
+        return self._data.id
 
     @property
     def vertexCount(self) -> int:
-        return self._handle[0].vertexCount
+        return self._data.vertexCount
 
     @vertexCount.setter
     def vertexCount(self, value: int):
-        self._handle[0].vertexCount = value
-    
+        self._data.vertexCount = value
+
     @property
     def line(self) -> bool:
-        return not not self._handle[0].line
+        return not not self._data.line
 
     @line.setter
     def line(self, value: bool):
-        self._handle[0].line = value
+        self._data.line = value
+
+    @property
+    def instanced(self) -> bool:
+        return not not self._data.instanced
+
+    @property
+    def camera_block(self) -> bool:
+        """Whether the shader uses the GtamCamera uniform block."""
+        return not not self._data.cameraBlock
+
+    @property
+    def uniforms(self) -> list["ShaderUniform"]:
+        window, handle = self._window, self._handle
+        v = _CShaderUniform()
+        result = []
+        for i in range(_C.gtamWindowGetShaderUniformCount(window, handle)):
+            _C.gtamWindowGetShaderUniform(window, handle, i, _ctypes.byref(v))
+            result.append(
+                ShaderUniform(
+                    v.name.decode("utf-8"), v.type, v.size, v.location, v.block
+                )
+            )
+        return result
+
+    @property
+    def uniform_blocks(self) -> list["ShaderUniformBlock"]:
+        window, handle = self._window, self._handle
+        v = _CShaderUniformBlock()
+        result = []
+        for i in range(_C.gtamWindowGetShaderUniformBlockCount(window, handle)):
+            _C.gtamWindowGetShaderUniformBlock(window, handle, i, _ctypes.byref(v))
+            result.append(
+                ShaderUniformBlock(v.name.decode("utf-8"), v.size, v.binding)
+            )
+        return result
+
+    def set_parameter(self, name: str, value) -> bool:
+        """Sets a uniform outside of uniform blocks, uploaded before the next
+        draw if it changed. `value` is a number, a glm vector or matrix, or a
+        sequence of them for arrays; plain ints also set float uniforms.
+        False if the shader has no such uniform or the type doesn't match."""
+        values = []
+
+        def flatten(v):
+            if isinstance(v, (int, float)):
+                values.append(v)
+            else:
+                for item in v.to_list() if hasattr(v, "to_list") else v:
+                    flatten(item)
+
+        flatten(value)
+        encoded = name.encode("utf-8")
+        if all(isinstance(v, int) for v in values):
+            ints = (_ctypes.c_int * len(values))(*values)
+            if _C.gtamWindowSetShaderParameterInt(
+                self._window, self._handle, encoded, ints, len(values)
+            ):
+                return True
+        floats = (_ctypes.c_float * len(values))(*values)
+        return not not _C.gtamWindowSetShaderParameter(
+            self._window, self._handle, encoded, floats, len(values)
+        )
 
 
 class TextureView:
-    def __init__(self, handle: _CTextureView):
+    def __init__(self, window: _CWindow, handle: _CTextureView):
+        self._window = window
         self._handle = handle
 
     @property
@@ -296,64 +847,521 @@ class TextureView:
 
     @property
     def source(self):
-        return Texture(self._handle.source)
+        return Texture(self._window, self._handle.source)
 
     @source.setter
     def source(self, value: Texture):
         self._handle.source = value._handle
 
 
-class Sprite:
-    def __init__(self, handle: _Ptr[_CSprite]):
-        self._handle = handle
+class Sprite(_Object):
+    _getter = _C.gtamWindowGetSprite
 
     @property
     def texture(self) -> TextureView:
-        return TextureView(self._handle[0].texture)
+        return TextureView(self._window, self._data.texture)
 
     @texture.setter
     def texture(self, value: TextureView):
-        self._handle[0].texture = value._handle
+        self._data.texture = value._handle
 
     @property
     def shader(self) -> Shader:
-        return Shader(self._handle[0].shader)
+        return Shader(self._window, self._data.shader)
 
     @shader.setter
     def shader(self, value: Shader):
-        self._handle[0].shader = value._handle
+        self._data.shader = value._handle
 
     @property
     def color(self) -> glm.vec4:
-        return self._handle[0].color.to_glm()
+        return self._data.color.to_glm()
 
     @color.setter
     def color(self, value: glm.vec4):
-        self._handle[0].color.set_from_glm(value)
+        self._data.color.set_from_glm(value)
 
     @property
     def position(self) -> glm.vec3:
-        return self._handle[0].position.to_glm()
+        return self._data.position.to_glm()
 
     @position.setter
     def position(self, value: glm.vec3):
-        self._handle[0].position.set_from_glm(value)
+        self._data.position.set_from_glm(value)
 
     @property
     def scale(self) -> glm.vec3:
-        return self._handle[0].scale.to_glm()
+        return self._data.scale.to_glm()
 
     @scale.setter
     def scale(self, value: glm.vec3):
-        self._handle[0].scale.set_from_glm(value)
+        self._data.scale.set_from_glm(value)
 
     @property
     def rotation(self) -> glm.quat:
-        return self._handle[0].rotation.to_glm()
+        return self._data.rotation.to_glm()
 
     @rotation.setter
     def rotation(self, value: glm.quat):
-        self._handle[0].rotation.set_from_glm(value)
+        self._data.rotation.set_from_glm(value)
+
+
+class SpriteBatch:
+    """Sprites sharing a texture and shader, with their data in engine arrays.
+
+    `positions`, `scales`, `rotations` (quaternions as x, y, z, w), `colors`
+    and `texture_views` (position xy, scale zw) are zero-copy float32 views of
+    shape (len(batch), n): NumPy arrays if NumPy is installed, memoryviews
+    otherwise. Whatever is written to them is copied into the sprites by the
+    next `Window.update`, so a whole population is moved without any per
+    sprite call. The views are invalidated by `resize` and
+    `Window.del_sprite_batch`, get them again afterwards.
+    """
+
+    def __init__(self, window: _CWindow, handle: _CHandle):
+        self._window = window
+        self._handle = handle
+
+    def _arrays(self) -> _CSpriteBatch:
+        arrays = _CSpriteBatch()
+        if not _C.gtamWindowGetSpriteBatch(self._window, self._handle, _ctypes.byref(arrays)):
+            raise ValueError("stale sprite batch handle")
+        return arrays
+
+    def _view(self, field: str, width: int):
+        arrays = self._arrays()
+        if not arrays.count:
+            # memoryviews can't have a 0 in their shape
+            if _numpy is not None:
+                return _numpy.zeros((0, width), _numpy.float32)
+            return memoryview(bytearray()).cast("f")
+        address = _ctypes.cast(getattr(arrays, field), _ctypes.c_void_p).value
+        buffer = (_ctypes.c_float * (arrays.count * width)).from_address(address)
+        view = memoryview(buffer).cast("B").cast("f", (arrays.count, width))
+        return _numpy.asarray(view) if _numpy is not None else view
+
+    @property
+    def alive(self) -> bool:
+        arrays = _CSpriteBatch()
+        return not not _C.gtamWindowGetSpriteBatch(
+            self._window, self._handle, _ctypes.byref(arrays)
+        )
+
+    def __len__(self) -> int:
+        return self._arrays().count
+
+    def __eq__(self, other) -> bool:
+        return type(self) is type(other) and self._handle == other._handle
+
+    def __hash__(self) -> int:
+        return hash(self._handle)
+
+    @property
+    def sprites(self) -> list[Sprite]:
+        arrays = self._arrays()
+        return [Sprite(self._window, arrays.sprites[i]) for i in range(arrays.count)]
+
+    @property
+    def positions(self):
+        return self._view("positions", 3)
+
+    @property
+    def scales(self):
+        return self._view("scales", 3)
+
+    @property
+    def rotations(self):
+        return self._view("rotations", 4)
+
+    @property
+    def colors(self):
+        return self._view("colors", 4)
+
+    @property
+    def texture_views(self):
+        return self._view("textureViews", 4)
+
+    def resize(self, count: int):
+        """Adds sprites to or deletes them from the end."""
+        self._arrays()
+        _C.gtamWindowResizeSpriteBatch(self._window, self._handle, count)
+
+
+class Tilemap(_Object):
+    """A grid of tiles showing cells of an atlas texture, drawn in chunks of
+    32x32 that are only rebuilt when one of their tiles changes.
+
+    Tile (x, y) covers `position.xy + (x, y) * tile_size` to one tile further.
+    Tiles are 0 for none or n for the n-th cell of the texture, counted from 1
+    row by row from its top left. Layer i is drawn at `position.z` plus its
+    depth, in order with the sprites and after the layers before it.
+    """
+
+    _getter = _C.gtamWindowGetTilemap
+
+    def _layer(self, layer: int) -> int:
+        if not 0 <= layer < self.layer_count:
+            self._data  # stale handles raise ValueError
+            raise IndexError(f"tilemap layer {layer} out of range")
+        return layer
+
+    @property
+    def texture(self) -> Texture:
+        return Texture(self._window, self._data.texture)
+
+    @texture.setter
+    def texture(self, value: Texture):
+        self._data.texture = value._handle
+
+    @property
+    def shader(self) -> Shader:
+        return Shader(self._window, self._data.shader)
+
+    @shader.setter
+    def shader(self, value: Shader):
+        self._data.shader = value._handle
+
+    @property
+    def size(self) -> glm.ivec2:
+        return self._data.size.to_glm()
+
+    @property
+    def atlas_size(self) -> glm.ivec2:
+        return self._data.atlasSize.to_glm()
+
+    @atlas_size.setter
+    def atlas_size(self, value: glm.ivec2):
+        self._data.atlasSize.set_from_glm(value)
+
+    @property
+    def position(self) -> glm.vec3:
+        return self._data.position.to_glm()
+
+    @position.setter
+    def position(self, value: glm.vec3):
+        self._data.position.set_from_glm(value)
+
+    @property
+    def tile_size(self) -> glm.vec2:
+        return self._data.tileSize.to_glm()
+
+    @tile_size.setter
+    def tile_size(self, value: glm.vec2):
+        self._data.tileSize.set_from_glm(value)
+
+    @property
+    def layer_count(self) -> int:
+        return _C.gtamWindowGetTilemapLayerCount(self._window, self._handle)
+
+    def get_tile(self, layer: int, tile: glm.ivec2) -> int:
+        """0 outside of the map."""
+        return _C.gtamWindowGetTile(
+            self._window, self._handle, self._layer(layer), _CVec2i(tile.x, tile.y)
+        )
+
+    def set_tile(self, layer: int, tile: glm.ivec2, value: int):
+        """Tiles outside of the map are ignored."""
+        _C.gtamWindowSetTile(
+            self._window,
+            self._handle,
+            self._layer(layer),
+            _CVec2i(tile.x, tile.y),
+            value,
+        )
+
+    def set_tiles(self, layer: int, origin: glm.ivec2, tiles):
+        """Sets a block of tiles at `origin` from a list of rows, or a 2D
+        NumPy array, which is passed without copying if it is contiguous
+        uint16."""
+        if _numpy is not None and isinstance(tiles, _numpy.ndarray):
+            rows = _numpy.ascontiguousarray(tiles, _numpy.uint16)
+            height, width = rows.shape
+            data = rows.ctypes.data_as(_ctypes.POINTER(_ctypes.c_uint16))
+        else:
+            height, width = len(tiles), len(tiles[0]) if tiles else 0
+            data = (_ctypes.c_uint16 * (width * height))(
+                *(value for row in tiles for value in row)
+            )
+        _C.gtamWindowSetTiles(
+            self._window,
+            self._handle,
+            self._layer(layer),
+            _CVec2i(origin.x, origin.y),
+            _CVec2i(width, height),
+            data,
+        )
+
+    def get_layer_depth(self, layer: int) -> float:
+        return _C.gtamWindowGetTilemapLayerDepth(
+            self._window, self._handle, self._layer(layer)
+        )
+
+    def set_layer_depth(self, layer: int, depth: float):
+        """Added to the tilemap's z, 0 by default."""
+        _C.gtamWindowSetTilemapLayerDepth(
+            self._window, self._handle, self._layer(layer), depth
+        )
+
+
+class Pack(_Object):
+    """An asset pack file (written by `gtampack`) mapped into memory, whose
+    textures and shaders are created by name."""
+
+    _getter = _C.gtamWindowGetPack
+
+    @property
+    def texture_count(self) -> int:
+        return self._data.textureCount
+
+    @property
+    def shader_count(self) -> int:
+        return self._data.shaderCount
+
+    @property
+    def bytes(self) -> int:
+        return self._data.bytes
+
+
+class Font(_Object):
+    """A TrueType font whose glyphs are rendered as signed distance fields the
+    first time a text uses them. Metrics are in units of the text size, the
+    distance from ascent to descent."""
+
+    _getter = _C.gtamWindowGetFont
+
+    @property
+    def ascent(self) -> float:
+        return self._data.ascent
+
+    @property
+    def descent(self) -> float:
+        return self._data.descent
+
+    @property
+    def line_height(self) -> float:
+        return self._data.lineHeight
+
+    @property
+    def glyph_size(self) -> int:
+        return self._data.glyphSize
+
+
+class Text(_Object):
+    """A string drawn with a font in a single draw call, only laid out again
+    when the string or font changes.
+
+    `position` is the left end of the first line's baseline and `size` the
+    world units from the font's ascent to its descent. Shaders get the glyph
+    quads in `aGlyphPosition` and `aGlyphUv`, and the distance field atlas in
+    `uTexture`, whose red channel is 0.5 on the outlines.
+    """
+
+    _getter = _C.gtamWindowGetText
+
+    @property
+    def font(self) -> Font:
+        return Font(self._window, self._data.font)
+
+    @font.setter
+    def font(self, value: Font):
+        self._data.font = value._handle
+
+    @property
+    def shader(self) -> Shader:
+        return Shader(self._window, self._data.shader)
+
+    @shader.setter
+    def shader(self, value: Shader):
+        self._data.shader = value._handle
+
+    @property
+    def position(self) -> glm.vec3:
+        return self._data.position.to_glm()
+
+    @position.setter
+    def position(self, value: glm.vec3):
+        self._data.position.set_from_glm(value)
+
+    @property
+    def rotation(self) -> glm.quat:
+        return self._data.rotation.to_glm()
+
+    @rotation.setter
+    def rotation(self, value: glm.quat):
+        self._data.rotation.set_from_glm(value)
+
+    @property
+    def size(self) -> float:
+        return self._data.size
+
+    @size.setter
+    def size(self, value: float):
+        self._data.size = value
+
+    @property
+    def color(self) -> glm.vec4:
+        return self._data.color.to_glm()
+
+    @color.setter
+    def color(self, value: glm.vec4):
+        self._data.color.set_from_glm(value)
+
+    @property
+    def string(self) -> str:
+        value = _C.gtamWindowGetTextString(self._window, self._handle)
+        if value is None:
+            raise ValueError("stale text handle")
+        return value.decode("utf-8")
+
+    @string.setter
+    def string(self, value: str):
+        self._data  # stale handles raise ValueError
+        _C.gtamWindowSetTextString(self._window, self._handle, value.encode("utf-8"))
+
+    @property
+    def extent(self) -> glm.vec2:
+        """Width of the longest line and height of all lines, in units of
+        `size`."""
+        self._data
+        extent = _CVec2()
+        _C.gtamWindowGetTextExtent(self._window, self._handle, _ctypes.byref(extent))
+        return extent.to_glm()
+
+
+class ParticleEmitter(_Object):
+    """Particles that live and are simulated on the GPU and drawn with one
+    instanced draw call, at `position.z` in between the sprites.
+
+    Each update spawns `rate * delta` particles into a ring over the capacity,
+    dropping spawns that land on a live particle, so the capacity should be at
+    least `rate * lifetime`. Spreads are random offsets of up to that much
+    either way. Shaders get each particle as an instance in
+    `aParticlePosition`, `aParticleColor` and `aParticleSize`, and `uTransform`
+    maps world to clip space.
+    """
+
+    _getter = _C.gtamWindowGetParticleEmitter
+
+    @property
+    def texture(self) -> Texture:
+        return Texture(self._window, self._data.texture)
+
+    @texture.setter
+    def texture(self, value: Texture):
+        self._data.texture = value._handle
+
+    @property
+    def shader(self) -> Shader:
+        return Shader(self._window, self._data.shader)
+
+    @shader.setter
+    def shader(self, value: Shader):
+        self._data.shader = value._handle
+
+    @property
+    def position(self) -> glm.vec3:
+        return self._data.position.to_glm()
+
+    @position.setter
+    def position(self, value: glm.vec3):
+        self._data.position.set_from_glm(value)
+
+    @property
+    def position_spread(self) -> glm.vec3:
+        return self._data.positionSpread.to_glm()
+
+    @position_spread.setter
+    def position_spread(self, value: glm.vec3):
+        self._data.positionSpread.set_from_glm(value)
+
+    @property
+    def velocity(self) -> glm.vec3:
+        return self._data.velocity.to_glm()
+
+    @velocity.setter
+    def velocity(self, value: glm.vec3):
+        self._data.velocity.set_from_glm(value)
+
+    @property
+    def velocity_spread(self) -> glm.vec3:
+        return self._data.velocitySpread.to_glm()
+
+    @velocity_spread.setter
+    def velocity_spread(self, value: glm.vec3):
+        self._data.velocitySpread.set_from_glm(value)
+
+    @property
+    def acceleration(self) -> glm.vec3:
+        return self._data.acceleration.to_glm()
+
+    @acceleration.setter
+    def acceleration(self, value: glm.vec3):
+        self._data.acceleration.set_from_glm(value)
+
+    @property
+    def rate(self) -> float:
+        return self._data.rate
+
+    @rate.setter
+    def rate(self, value: float):
+        self._data.rate = value
+
+    @property
+    def lifetime(self) -> float:
+        return self._data.lifetime
+
+    @lifetime.setter
+    def lifetime(self, value: float):
+        self._data.lifetime = value
+
+    @property
+    def lifetime_spread(self) -> float:
+        return self._data.lifetimeSpread
+
+    @lifetime_spread.setter
+    def lifetime_spread(self, value: float):
+        self._data.lifetimeSpread = value
+
+    @property
+    def start_color(self) -> glm.vec4:
+        return self._data.startColor.to_glm()
+
+    @start_color.setter
+    def start_color(self, value: glm.vec4):
+        self._data.startColor.set_from_glm(value)
+
+    @property
+    def end_color(self) -> glm.vec4:
+        return self._data.endColor.to_glm()
+
+    @end_color.setter
+    def end_color(self, value: glm.vec4):
+        self._data.endColor.set_from_glm(value)
+
+    @property
+    def start_size(self) -> float:
+        return self._data.startSize
+
+    @start_size.setter
+    def start_size(self, value: float):
+        self._data.startSize = value
+
+    @property
+    def end_size(self) -> float:
+        return self._data.endSize
+
+    @end_size.setter
+    def end_size(self, value: float):
+        self._data.endSize = value
+
+    @property
+    def capacity(self) -> int:
+        return _C.gtamWindowGetParticleEmitterCapacity(self._window, self._handle)
+
+    def emit(self, count: int):
+        """Spawns `count` particles at once with the next update."""
+        self._data
+        _C.gtamWindowEmitParticles(self._window, self._handle, count)
 
 
 class CameraType(_enum.IntEnum):
@@ -444,55 +1452,54 @@ class OrthographicCamera_:
         self._handle.bottom = v
 
 
-class Camera:
-    def __init__(self, handle: _Ptr[_CCamera]):
-        self._handle = handle
+class Camera(_Object):
+    _getter = _C.gtamWindowGetCamera
 
     @property
     def type(self) -> CameraType:
         return (
             CameraType.ORTHOGRAPHIC
-            if self._handle[0].type == 0
+            if self._data.type == 0
             else CameraType.PERSPECTIVE
-            if self._handle[0].type == 1
+            if self._data.type == 1
             else CameraType.UNKNOWN
         )
 
     @type.setter
     def type(self, value: CameraType):
-        self._handle[0].type = value.value
+        self._data.type = value.value
 
     @property
     def position(self) -> glm.vec3:
-        return self._handle[0].position.to_glm()
+        return self._data.position.to_glm()
 
     @position.setter
     def position(self, value: glm.vec3):
-        self._handle[0].position.set_from_glm(value)
+        self._data.position.set_from_glm(value)
 
     @property
     def rotation(self) -> glm.quat:
-        return self._handle[0].rotation.to_glm()
+        return self._data.rotation.to_glm()
 
     @rotation.setter
     def rotation(self, value: glm.quat):
-        self._handle[0].rotation.set_from_glm(value)
+        self._data.rotation.set_from_glm(value)
 
     @property
     def perspective(self) -> PerspectiveCamera_:
-        return PerspectiveCamera_(self._handle[0].opts.perspective)
+        return PerspectiveCamera_(self._data.opts.perspective)
 
     @perspective.setter
     def perspective(self, value: PerspectiveCamera_):
-        self._handle[0].opts.perspective = value._handle
+        self._data.opts.perspective = value._handle
 
     @property
     def orthographic(self) -> OrthographicCamera_:
-        return OrthographicCamera_(self._handle[0].opts.orthographic)
+        return OrthographicCamera_(self._data.opts.orthographic)
 
     @orthographic.setter
     def orthographic(self, value: OrthographicCamera_):
-        self._handle[0].opts.orthographic = value._handle
+        self._data.opts.orthographic = value._handle
 
 
 class KeyCode(_enum.IntEnum):
@@ -619,17 +1626,188 @@ class KeyCode(_enum.IntEnum):
     MENU = 348
 
 
-class Window:
-    def __init__(self, size: glm.ivec2, title: str):
-        self._handle = _C.gtamCreateWindow(
-            _CVec2i(size.x, size.y), title.encode("utf-8")
+class AtlasStats(typing.NamedTuple):
+    page_count: int
+    image_count: int
+    used_pixels: int
+    total_pixels: int
+
+    @property
+    def occupancy(self) -> float:
+        return self.used_pixels / self.total_pixels if self.total_pixels else 0.0
+
+
+class ShaderUniform(typing.NamedTuple):
+    """An active uniform, `type` is the gl type (GL_FLOAT_VEC4, ...) and
+    `size` the array length. Members of uniform blocks have no location (-1)
+    and the index of their block in `Shader.uniform_blocks`."""
+
+    name: str
+    type: int
+    size: int
+    location: int
+    block: int
+
+
+class ShaderUniformBlock(typing.NamedTuple):
+    name: str
+    size: int
+    binding: int
+
+
+class TextureResidencyStats(typing.NamedTuple):
+    """Textures with a GL texture of their own, which is all but atlas images."""
+
+    budget: int  # 0 for none
+    resident_bytes: int  # mip levels included
+    resident_count: int
+    evicted_count: int
+    evictions: int
+    reloads: int
+
+
+class ProgramCacheStats(typing.NamedTuple):
+    hits: int
+    misses: int
+    rejected: int
+    stored: int
+
+
+class StreamStats(typing.NamedTuple):
+    """Totals of the ring buffers streaming per frame data since `init`,
+    `fence_wait_time` in milliseconds."""
+
+    persistent: bool
+    capacity: int
+    bytes_streamed: int
+    allocations: int
+    reallocations: int
+    fence_waits: int
+    fence_wait_time: float
+
+
+class GlDebugMode(_enum.IntEnum):
+    """When gl errors and driver messages are looked for, see
+    `Window.gl_debug_mode`."""
+
+    OFF = 0
+    PER_FRAME = 1
+    PER_CALL = 2
+
+
+class GlDebugSeverity(_enum.IntEnum):
+    LOW = 0
+    MEDIUM = 1
+    HIGH = 2
+
+
+class GlDebugMessage(typing.NamedTuple):
+    """`source`, `type` and `id` are the gl values the driver reported."""
+
+    source: int
+    type: int
+    id: int
+    severity: GlDebugSeverity
+    text: str
+
+
+class CpuTime(typing.NamedTuple):
+    poll: float
+    upload: float
+    sort: float
+    cull: float
+    transform: float
+    submit: float
+    swap: float
+    total: float
+
+
+class FrameStats(typing.NamedTuple):
+    """What one `Window.update` did, times in milliseconds.
+
+    `gpu_time` is None until the timer query was read back, a few frames later.
+    """
+
+    frame: int
+    cpu_time: CpuTime
+    gpu_time: float | None
+    draw_calls: int
+    program_binds: int
+    texture_binds: int
+    uniform_uploads: int
+    sprites_drawn: int
+    sprites_culled: int
+    state_changes_filtered: int
+    tile_chunks_drawn: int
+    texts_drawn: int
+    particles_simulated: int
+
+    @staticmethod
+    def _from_c(v: _CFrameStats) -> "FrameStats":
+        t = v.cpuTime
+        return FrameStats(
+            v.frame,
+            CpuTime(
+                t.poll, t.upload, t.sort, t.cull, t.transform, t.submit, t.swap, t.total
+            ),
+            v.gpuTime if v.gpuTime >= 0 else None,
+            v.drawCalls,
+            v.programBinds,
+            v.textureBinds,
+            v.uniformUploads,
+            v.spritesDrawn,
+            v.spritesCulled,
+            v.stateChangesFiltered,
+            v.tileChunksDrawn,
+            v.textsDrawn,
+            v.particlesSimulated,
         )
-        self._check_errors()
 
-    def _check_errors(self, msg: str | None = None):
-        if _C.gtamGetError() != _GTAM_ERROR_NONE:
+
+def _float_rows(values, count: int, width: int):
+    """Address and row stride in bytes of `count` rows of `width` float32s.
+
+    The last item owns the memory, keep it until the address was used.
+    """
+    if _numpy is not None and isinstance(values, _numpy.ndarray):
+        if (
+            values.dtype != _numpy.float32
+            or values.shape != (count, width)
+            or values.strides[1] != 4
+        ):
+            raise ValueError(f"need a ({count}, {width}) float32 array")
+        return values.ctypes.data, values.strides[0], values
+    view = memoryview(values).cast("B")
+    if view.nbytes != count * width * 4:
+        raise ValueError(f"need {count} * {width} floats")
+    if view.readonly:
+        buffer = (_ctypes.c_char * view.nbytes).from_buffer_copy(view)
+    else:
+        buffer = (_ctypes.c_char * view.nbytes).from_buffer(view)
+    return _ctypes.addressof(buffer), width * 4, buffer
+
+
+class Window:
+    def __init__(self, size: glm.ivec2, title: str, headless: bool = False):
+        if headless:
+            self._handle = _C.gtamCreateHeadlessWindow(_CVec2i(size.x, size.y))
+        else:
+            self._handle = _C.gtamCreateWindow(
+                _CVec2i(size.x, size.y), title.encode("utf-8")
+            )
+        if not self._handle:
             raise Exception(
                 f"{_gtam_error_to_text(_C.gtamGetError())}: {_C.gtamGetErrorMessage().decode('utf-8')}"
+            )
+        # ctypes callbacks must outlive the load, keyed by texture handle
+        self._texture_callbacks = {}
+        self._gl_debug_callback = _CGlDebugCallback()
+
+    def _check_errors(self, msg: str | None = None):
+        error = _C.gtamWindowGetError(self._handle)
+        if error != _GTAM_ERROR_NONE:
+            raise Exception(
+                f"{_gtam_error_to_text(error)}: {_C.gtamWindowGetErrorMessage(self._handle).decode('utf-8')}"
                 + (" " + msg if msg is not None else "")
             )
 
@@ -675,33 +1853,289 @@ class Window:
     def aspect_ratio(self) -> float:
         return _C.gtamWindowGetAspectRatio(self._handle)
 
+    @property
+    def headless(self) -> bool:
+        return not not _C.gtamWindowIsHeadless(self._handle)
+
+    def read_pixels(self, out=None):
+        """Last frame as rgba8, bottom row first.
+
+        `out` can be any writable buffer of width * height * 4 bytes (bytearray,
+        numpy array, ...) and is filled in place; a new bytearray is returned
+        otherwise.
+        """
+        size = self.framebuffer_size
+        length = int(size.x) * int(size.y) * 4
+        if out is None:
+            out = bytearray(length)
+        view = memoryview(out).cast("B")
+        if view.readonly or view.nbytes < length:
+            raise ValueError(f"need a writable buffer of {length} bytes")
+        c_buffer = (_ctypes.c_ubyte * length).from_buffer(view)
+        _C.gtamWindowReadPixels(self._handle, c_buffer)
+        return out
+
     def get_mouse_position(self) -> glm.vec2:
         v = _CVec2()
         _C.gtamWindowGetMousePosition(self._handle, _ctypes.byref(v))
         return v.to_glm()
 
+    def set_atlas_options(
+        self,
+        enabled: bool = True,
+        page_size: int = 2048,
+        max_image_size: int = 256,
+        padding: int = 2,
+    ):
+        options = _CAtlasOptions(1 if enabled else 0, page_size, max_image_size, padding)
+        _C.gtamWindowSetAtlasOptions(self._handle, _ctypes.byref(options))
+
+    @property
+    def atlas_stats(self) -> AtlasStats:
+        v = _CAtlasStats()
+        _C.gtamWindowGetAtlasStats(self._handle, _ctypes.byref(v))
+        return AtlasStats(v.pageCount, v.imageCount, v.usedPixels, v.totalPixels)
+
+    @property
+    def frame_stats(self) -> FrameStats:
+        v = _CFrameStats()
+        _C.gtamWindowGetFrameStats(self._handle, _ctypes.byref(v))
+        return FrameStats._from_c(v)
+
+    def frame_stats_history(self, count: int = 240) -> list[FrameStats]:
+        """Stats of up to `count` of the most recent frames, oldest first."""
+        buffer = (_CFrameStats * count)()
+        n = _C.gtamWindowGetFrameStatsHistory(self._handle, buffer, count)
+        return [FrameStats._from_c(v) for v in buffer[:n]]
+
+    def set_frame_stats_history_size(self, frames: int):
+        _C.gtamWindowSetFrameStatsHistorySize(self._handle, frames)
+
+    @property
+    def stream_stats(self) -> StreamStats:
+        v = _CStreamStats()
+        _C.gtamWindowGetStreamStats(self._handle, _ctypes.byref(v))
+        return StreamStats(
+            bool(v.persistent),
+            v.capacity,
+            v.bytesStreamed,
+            v.allocations,
+            v.reallocations,
+            v.fenceWaits,
+            v.fenceWaitTime,
+        )
+
     def new_texture(self, path: str) -> Texture:
-        ptr = _C.gtamWindowNewTexture(self._handle, path.encode("utf-8"))
+        handle = _C.gtamWindowNewTexture(self._handle, path.encode("utf-8"))
+        self._check_errors(path)
+        return Texture(self._handle, handle)
+
+    def new_texture_async(
+        self, path: str, callback: typing.Callable[[Texture, bool], None] | None = None
+    ) -> Texture:
+        """Loads the texture in the background, see `Texture.state`.
+
+        `callback(texture, loaded)` runs inside `update` once it is done.
+        """
+        c_callback = _CTextureCallback()
+        if callback is not None:
+
+            def trampoline(handle, loaded, _user):
+                self._texture_callbacks.pop(_CHandle(handle.index, handle.generation), None)
+                callback(Texture(self._handle, handle), not not loaded)
+
+            c_callback = _CTextureCallback(trampoline)
+
+        handle = _C.gtamWindowNewTextureAsync(
+            self._handle, path.encode("utf-8"), c_callback, None
+        )
         self._check_errors(path)
-        return Texture(ptr)
+        if callback is not None:
+            self._texture_callbacks[handle] = c_callback
+        return Texture(self._handle, handle)
+
+    @property
+    def pending_texture_count(self) -> int:
+        return _C.gtamWindowGetPendingTextureCount(self._handle)
+
+    def set_texture_upload_budget(self, bytes_per_frame: int):
+        _C.gtamWindowSetTextureUploadBudget(self._handle, bytes_per_frame)
+
+    def set_texture_budget(self, bytes: int):
+        """Textures drawn the longest time ago are evicted while all of them
+        take more than `bytes` of GPU memory, and loaded again the next time
+        something draws them. 0 (the default) for no budget."""
+        _C.gtamWindowSetTextureBudget(self._handle, bytes)
+
+    @property
+    def texture_residency_stats(self) -> TextureResidencyStats:
+        v = _CTextureResidencyStats()
+        _C.gtamWindowGetTextureResidencyStats(self._handle, _ctypes.byref(v))
+        return TextureResidencyStats(
+            v.budget,
+            v.residentBytes,
+            v.residentCount,
+            v.evictedCount,
+            v.evictions,
+            v.reloads,
+        )
 
     def new_sprite(self, texture: Texture, shader: Shader) -> Sprite:
-        ptr = _C.gtamWindowNewSprite(self._handle, texture._handle, shader._handle)
-        return Sprite(ptr)
+        handle = _C.gtamWindowNewSprite(self._handle, texture._handle, shader._handle)
+        self._check_errors()
+        return Sprite(self._handle, handle)
+
+    def new_sprites(self, texture: Texture, shader: Shader, count: int) -> list[Sprite]:
+        handles = (_CHandle * count)()
+        _C.gtamWindowNewSprites(
+            self._handle, texture._handle, shader._handle, count, handles
+        )
+        self._check_errors()
+        return [Sprite(self._handle, handle) for handle in handles]
+
+    def del_sprites(self, sprites: typing.Sequence[Sprite]):
+        handles = (_CHandle * len(sprites))(*(sprite._handle for sprite in sprites))
+        _C.gtamWindowDelSprites(self._handle, handles, len(sprites))
+
+    def set_sprites(
+        self,
+        sprites: typing.Sequence[Sprite],
+        positions=None,
+        scales=None,
+        rotations=None,
+        colors=None,
+        texture_views=None,
+    ):
+        """Writes the given attributes of many sprites in one call each.
+
+        Values are (len(sprites), n) float32 arrays: NumPy arrays, strided ones
+        included, or anything else with a contiguous float buffer. Rotations
+        are quaternions as x, y, z, w, texture views position xy and scale zw.
+        """
+        handles = (_CHandle * len(sprites))(*(sprite._handle for sprite in sprites))
+        for values, width, setter in (
+            (positions, 3, _C.gtamWindowSetSpritePositions),
+            (scales, 3, _C.gtamWindowSetSpriteScales),
+            (rotations, 4, _C.gtamWindowSetSpriteRotations),
+            (colors, 4, _C.gtamWindowSetSpriteColors),
+            (texture_views, 4, _C.gtamWindowSetSpriteTextureViews),
+        ):
+            if values is None:
+                continue
+            address, stride, _owner = _float_rows(values, len(sprites), width)
+            setter(self._handle, handles, len(sprites), address, stride)
+
+    def new_sprite_batch(self, texture: Texture, shader: Shader, count: int) -> SpriteBatch:
+        handle = _C.gtamWindowNewSpriteBatch(
+            self._handle, texture._handle, shader._handle, count
+        )
+        self._check_errors()
+        return SpriteBatch(self._handle, handle)
+
+    def new_tilemap(
+        self,
+        texture: Texture,
+        shader: Shader,
+        size: glm.ivec2,
+        atlas_size: glm.ivec2,
+        layer_count: int = 1,
+    ) -> Tilemap:
+        """`layer_count` empty layers of `size` tiles, at most 65535 per side."""
+        handle = _C.gtamWindowNewTilemap(
+            self._handle,
+            texture._handle,
+            shader._handle,
+            _CVec2i(size.x, size.y),
+            _CVec2i(atlas_size.x, atlas_size.y),
+            layer_count,
+        )
+        self._check_errors()
+        return Tilemap(self._handle, handle)
+
+    def new_font(self, path: str, glyph_size: int = 48) -> Font:
+        """Glyphs are rendered with `glyph_size` pixels from ascent to descent,
+        larger sizes keep sharper corners when scaled up."""
+        handle = _C.gtamWindowNewFont(self._handle, path.encode("utf-8"), glyph_size)
+        self._check_errors()
+        return Font(self._handle, handle)
+
+    def set_font_cache_directory(self, path: str | None):
+        """Rendered glyphs are saved to `path` when their font is deleted and
+        read back by fonts created later. None turns the cache off."""
+        _C.gtamWindowSetFontCacheDirectory(
+            self._handle, path.encode("utf-8") if path else None
+        )
+
+    def new_text(self, font: Font, shader: Shader, string: str = "") -> Text:
+        handle = _C.gtamWindowNewText(
+            self._handle, font._handle, shader._handle, string.encode("utf-8")
+        )
+        self._check_errors()
+        return Text(self._handle, handle)
+
+    def new_particle_emitter(
+        self, texture: Texture, shader: Shader, capacity: int
+    ) -> ParticleEmitter:
+        """All particles start out dead, and the rate at 0."""
+        handle = _C.gtamWindowNewParticleEmitter(
+            self._handle, texture._handle, shader._handle, capacity
+        )
+        self._check_errors()
+        return ParticleEmitter(self._handle, handle)
+
+    def set_particle_time_step(self, seconds: float):
+        """Seconds particles move per update, 0 (the default) for the real time
+        since the last one, at most a tenth of a second."""
+        _C.gtamWindowSetParticleTimeStep(self._handle, seconds)
 
     def new_shader(self, vertex: str, fragment: str, vertex_count: int) -> Shader:
-        ptr = _C.gtamWindowNewShader(
+        handle = _C.gtamWindowNewShader(
             self._handle, vertex.encode("utf-8"), fragment.encode("utf-8"), vertex_count
         )
         self._check_errors(
             f"vertex: {vertex}, fragment: {fragment}, vertex_count: {vertex_count}"
         )
-        return Shader(ptr)
+        return Shader(self._handle, handle)
+
+    def load_pack(self, path: str) -> Pack:
+        """Maps the pack until `unload_pack`, textures and shaders created from
+        it outlive it."""
+        handle = _C.gtamWindowLoadPack(self._handle, path.encode("utf-8"))
+        self._check_errors(path)
+        return Pack(self._handle, handle)
+
+    def new_texture_from_pack(self, pack: Pack, name: str) -> Texture:
+        """Uploads the texture's mip levels straight from the mapped file."""
+        handle = _C.gtamWindowNewTextureFromPack(
+            self._handle, pack._handle, name.encode("utf-8")
+        )
+        self._check_errors(name)
+        return Texture(self._handle, handle)
+
+    def new_shader_from_pack(self, pack: Pack, name: str, vertex_count: int) -> Shader:
+        handle = _C.gtamWindowNewShaderFromPack(
+            self._handle, pack._handle, name.encode("utf-8"), vertex_count
+        )
+        self._check_errors(name)
+        return Shader(self._handle, handle)
+
+    def set_program_cache_directory(self, path: str | None):
+        """Linked programs are saved to `path` and loaded from there on the next
+        launch instead of being compiled. None turns the cache off."""
+        _C.gtamWindowSetProgramCacheDirectory(
+            self._handle, path.encode("utf-8") if path else None
+        )
+
+    @property
+    def program_cache_stats(self) -> ProgramCacheStats:
+        v = _CProgramCacheStats()
+        _C.gtamWindowGetProgramCacheStats(self._handle, _ctypes.byref(v))
+        return ProgramCacheStats(v.hits, v.misses, v.rejected, v.stored)
 
     def new_camera(self, type: CameraType) -> Camera:
-        ptr = _C.gtamWindowNewCamera(self._handle, type.value)
+        handle = _C.gtamWindowNewCamera(self._handle, type.value)
         self._check_errors()
-        return Camera(ptr)
+        return Camera(self._handle, handle)
 
     def del_texture(self, texture: Texture):
         _C.gtamWindowDelTexture(self._handle, texture._handle)
@@ -709,15 +2143,124 @@ class Window:
     def del_sprite(self, sprite: Sprite):
         _C.gtamWindowDelSprite(self._handle, sprite._handle)
 
+    def del_sprite_batch(self, batch: SpriteBatch):
+        """Deletes the batch and its sprites."""
+        _C.gtamWindowDelSpriteBatch(self._handle, batch._handle)
+
     def del_shader(self, shader: Shader):
         _C.gtamWindowDelShader(self._handle, shader._handle)
 
+    def del_tilemap(self, tilemap: Tilemap):
+        _C.gtamWindowDelTilemap(self._handle, tilemap._handle)
+
+    def unload_pack(self, pack: Pack):
+        _C.gtamWindowUnloadPack(self._handle, pack._handle)
+
+    def del_font(self, font: Font):
+        _C.gtamWindowDelFont(self._handle, font._handle)
+
+    def del_text(self, text: Text):
+        _C.gtamWindowDelText(self._handle, text._handle)
+
+    def del_particle_emitter(self, emitter: ParticleEmitter):
+        _C.gtamWindowDelParticleEmitter(self._handle, emitter._handle)
+
     def del_camera(self, camera: Camera):
         _C.gtamWindowDelCamera(self._handle, camera._handle)
 
+    def set_culling(self, enabled: bool):
+        """Sprites outside the active camera's view are skipped by `update`."""
+        _C.gtamWindowSetCulling(self._handle, 1 if enabled else 0)
+
+    @property
+    def thread_count(self) -> int:
+        """Threads preparing frames, the one calling `update` included. Set to
+        0 for one per core."""
+        return _C.gtamWindowGetThreadCount(self._handle)
+
+    @thread_count.setter
+    def thread_count(self, threads: int):
+        _C.gtamWindowSetThreadCount(self._handle, threads)
+
+    @property
+    def gl_debug_mode(self) -> GlDebugMode:
+        """Per frame checks once at the end of `update`, per call after every
+        draw call as well, which can stall the driver."""
+        return GlDebugMode(_C.gtamWindowGetGlDebugMode(self._handle))
+
+    @gl_debug_mode.setter
+    def gl_debug_mode(self, mode: GlDebugMode):
+        _C.gtamWindowSetGlDebugMode(self._handle, mode)
+
+    def set_gl_debug_callback(
+        self, callback: typing.Callable[[GlDebugMessage], None] | None
+    ):
+        """`callback(message)` runs inside `update`, once per distinct
+        message. Messages go to stderr without one."""
+        c_callback = _CGlDebugCallback()
+        if callback is not None:
+
+            def trampoline(message, _user):
+                m = message.contents
+                callback(
+                    GlDebugMessage(
+                        m.source,
+                        m.type,
+                        m.id,
+                        GlDebugSeverity(m.severity),
+                        m.text.decode("utf-8", "replace"),
+                    )
+                )
+
+            c_callback = _CGlDebugCallback(trampoline)
+
+        _C.gtamWindowSetGlDebugCallback(self._handle, c_callback, None)
+        self._gl_debug_callback = c_callback
+
+    def _query_sprites(self, query) -> list[Sprite]:
+        capacity = 64
+        while True:
+            buffer = (_CHandle * capacity)()
+            count = query(buffer, capacity)
+            if count <= capacity:
+                return [
+                    Sprite(self._handle, _CHandle(h.index, h.generation))
+                    for h in buffer[:count]
+                ]
+            capacity = count
+
+    def sprites_in_rect(self, min: glm.vec2, max: glm.vec2) -> list[Sprite]:
+        """Sprites whose bounds overlap the world space rectangle."""
+        return self._query_sprites(
+            lambda buffer, capacity: _C.gtamWindowGetSpritesInRect(
+                self._handle,
+                _CVec2(min.x, min.y),
+                _CVec2(max.x, max.y),
+                buffer,
+                capacity,
+            )
+        )
+
+    def sprites_at_point(self, point: glm.vec2) -> list[Sprite]:
+        """Sprites covering the world space point, topmost first."""
+        return self._query_sprites(
+            lambda buffer, capacity: _C.gtamWindowGetSpritesAtPoint(
+                self._handle, _CVec2(point.x, point.y), buffer, capacity
+            )
+        )
+
+    def screen_to_world(self, position: glm.vec2) -> glm.vec2:
+        """Window coordinates (see `get_mouse_position`) to world xy at z = 0."""
+        v = _CVec2()
+        _C.gtamWindowScreenToWorld(
+            self._handle, _CVec2(position.x, position.y), _ctypes.byref(v)
+        )
+        self._check_errors()
+        return v.to_glm()
+
     @property
     def active_camera(self):
-        return Camera(_C.gtamWindowGetActiveCamera(self._handle))
+        return Camera(self._handle, _C.gtamWindowGetActiveCamera(self._handle))
 
     @active_camera.setter
     def active_camera(self, camera: Camera):
@@ -725,11 +2268,29 @@ class Window:
 
 
 __all__ = [
+    "AtlasStats",
     "Camera",
+    "CpuTime",
+    "Font",
+    "FrameStats",
+    "ProgramCacheStats",
+    "GlDebugMessage",
+    "GlDebugMode",
+    "GlDebugSeverity",
+    "Pack",
+    "ParticleEmitter",
     "Shader",
+    "ShaderUniform",
+    "ShaderUniformBlock",
     "Texture",
+    "TextureResidencyStats",
+    "TextureState",
     "TextureView",
     "Sprite",
+    "SpriteBatch",
+    "StreamStats",
+    "Text",
+    "Tilemap",
     "Window",
     "CameraType",
     "KeyCode",
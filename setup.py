@@ -54,6 +54,12 @@ LIB_GLFW_PREDEFINED = {
 }
 
 
+# headless windows render through EGL, which is only used on linux
+LIB_EGL_PREDEFINED = {
+    "linux": ["-lEGL"],
+}
+
+
 def download(dst, url):
     if os.path.exists(dst):
         print("Reusing {0}.".format(dst))
@@ -205,6 +211,22 @@ if glfw_res is None:
 else:
     lib_glfw = glfw_res
 
+lib_egl = []
+if PLATFORM in LIB_EGL_PREDEFINED:
+    print("- egl")
+    if check_includes(["EGL/egl.h", "EGL/eglext.h"], lang="c") != 0:
+        print(
+            "Failed to compile test EGL program. Most likely the EGL headers are not present."
+        )
+        print("For more info: https://www.khronos.org/egl")
+        exit(1)
+    egl_res = check_libraries(LIB_EGL_PREDEFINED[PLATFORM], lang="c", name="EGL")
+    if egl_res is None:
+        print("Failed to link test EGL program. Most likely libEGL is not present.")
+        print("For more info: https://www.khronos.org/egl")
+        exit(1)
+    lib_egl = egl_res
+
 print("All required tools found!")
 print("Setting up environment...")
 print("- gl3w")
@@ -216,8 +238,14 @@ download(
     "gtamfx/include/stb_image.h",
     "https://raw.githubusercontent.com/nothings/stb/master/stb_image.h",
 )
+print("- stb_truetype.h")
+download(
+    "gtamfx/include/stb_truetype.h",
+    "https://raw.githubusercontent.com/nothings/stb/master/stb_truetype.h",
+)
 print("- ninja")
 with open("gtamfx/platform.ninja", "w") as f:
     f.write("platform_cflags = {0}\n".format(""))
     f.write("platform_ldflags = {0}\n".format(" ".join(lib_glfw)))
+    f.write("headless_ldflags = {0}\n".format(" ".join(lib_egl)))
 print("Environment setup!")